@@ -0,0 +1,47 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Micro benchmarks of layers and kernels.
+//
+// bench [--out results.json] [--baseline baseline.json] [--threshold 0.1] [--seconds 0.25] [--filter Dense]
+//
+// Results are printed as JSON unless written to file. With baseline every case is compared and
+// exit code is count of regressions, so runs can gate upgrades.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "../stacks/Bench.hpp"
+#include <iostream>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Entry.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+auto main ( int _Argc, char** _Argv ) -> int
+{
+	using namespace sx;
+
+	auto Cfg = CfgBench();
+	auto Out = str();
+	auto Baseline = str();
+	auto Threshold = r64(0.1);
+
+	for(auto a = 1; a + 1 < _Argc; a += 2)
+	{
+		const auto Arg = str(_Argv[a]);
+		const auto Value = str(_Argv[a + 1]);
+
+		if(Arg == "--out"s) Out = Value;
+		else if(Arg == "--baseline"s) Baseline = Value;
+		else if(Arg == "--threshold"s) Threshold = std::stod(Value);
+		else if(Arg == "--seconds"s) Cfg.Seconds = std::stod(Value);
+		else if(Arg == "--filter"s) Cfg.Filter = Value;
+		else { std::cerr << "Unknown argument ["s << Arg << "]!\n"s; return -1; }
+	}
+
+	auto Results = vec<BenchResult>();
+	benchSuite<r32>(Cfg, Results);
+	benchSuite<r64>(Cfg, Results);
+
+	if(Out.empty()) storeBench(std::cout, Results);
+	else { auto File = std::ofstream(Out); storeBench(File, Results); }
+
+	if(Baseline.empty()) return 0;
+	return int(compareBench(std::cerr, Results, loadBench(Baseline), Threshold));
+}
@@ -0,0 +1,180 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Multi-process data-parallel training check.
+//
+// procs [--workers 2] [--steps 40] [--batch 16] [--rate 0.01]
+//
+// Workers are forked, synchronized by broadcast and trained on their own data with deltas summed by allReduce, raw and Q8 compressed.
+// Every worker leaves its parameters in shared result area, which must be bit identical over ranks. Group is also checked to refuse
+// network of other size and launcher to report failed worker, also one failing or dying while others wait in allReduce.
+// Every mode prints JSON line, exit code is non zero on any failure.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "../stacks/stacks.hpp"
+#include <chrono>
+#include <iostream>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Network of every worker.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+using Net = sx::Network<sx::r32,sx::CompClass::LAYERS>;
+constexpr auto SZ_IN = sx::uMAX(16);
+constexpr auto SZ_OUT = sx::uMAX(4);
+
+auto procsBuild ( Net& _Net ) -> void
+{
+	using namespace sx;
+
+	_Net.attach(new Dense<r32, SZ_IN, 32, FnTrTanh<r32>>());
+	_Net.attach(new Dense<r32, 32, SZ_OUT, FnTrTanh<r32>>());
+	_Net.attach(new sx::Error<r32, SZ_OUT>());
+}
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Train group in one mode and compare parameters of all workers.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+auto procsRun ( const sx::FnCompress _Compress, const sx::uMAX _Workers, const sx::uMAX _Steps, const sx::uMAX _Batch, const sx::rMAX _Rate ) -> bool
+{
+	using namespace sx;
+
+	auto Reference = Net();
+	procsBuild(Reference);
+	const auto Size = Reference.bufSz(LayerBuf::PARAMS);
+
+	// Losses and parameters of every rank, shared with forked workers.
+	const auto SzResults = _Workers * (2 + Size) * sizeof(r32);
+	const auto Mem = mmap(nullptr, SzResults, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(Mem == MAP_FAILED) { std::cerr << "Failed to map results!\n"s; return false; }
+	const auto Results = static_cast<r32*>(Mem);
+
+	auto Group = ProcGroup<r32>(_Workers, Size, _Compress);
+
+	const auto Start = std::chrono::steady_clock::now();
+	const auto Success = spawnWorkers(_Workers, [&]( const uMAX _Rank )
+	{
+		auto Worker = Net();
+		procsBuild(Worker);
+		Group.broadcast(_Rank, Worker);
+
+		// Every rank sees other samples of same mapping.
+		auto Inputs = vec<r32>(_Batch * SZ_IN);
+		auto Targets = vec<r32>(_Batch * SZ_OUT);
+		for(auto n = uMAX(0); n < _Batch; ++n)
+		{
+			const auto Sample = r64(_Rank * _Batch + n);
+			for(auto i = uMAX(0); i < SZ_IN; ++i) Inputs[n * SZ_IN + i] = r32(std::sin(Sample * 0.71 + r64(i) * 0.37));
+			for(auto o = uMAX(0); o < SZ_OUT; ++o) Targets[n * SZ_OUT + o] = r32(0.5 * std::sin(Sample * 0.71 + r64(o)));
+		}
+
+		const auto Loss = Results + _Rank * (2 + Size);
+		for(auto s = uMAX(0); s < _Steps; ++s)
+		{
+			Worker.exeBatch(Inputs.data(), SZ_IN, _Batch);
+			const auto Err = Worker.errBatch(Targets.data(), SZ_OUT, _Batch);
+			Worker.fitBatch(Targets.data(), SZ_OUT, _Batch, r32(0));
+			Group.allReduce(_Rank, Worker);
+			Worker.apply(_Rate, s + 1);
+			Worker.reset();
+
+			if(s == 0) Loss[0] = Err;
+			Loss[1] = Err;
+		}
+
+		Worker.gather(Loss + 2, LayerBuf::PARAMS);
+	});
+	const auto Seconds = std::chrono::duration<r64>(std::chrono::steady_clock::now() - Start).count();
+
+	auto Identical = Success;
+	for(auto r = uMAX(1); Success && (r < _Workers); ++r) Identical &= (std::memcmp(Results + 2, Results + r * (2 + Size) + 2, Size * sizeof(r32)) == 0);
+
+	auto First = r64(0), Last = r64(0);
+	for(auto r = uMAX(0); r < _Workers; ++r) { First += Results[r * (2 + Size)]; Last += Results[r * (2 + Size) + 1]; }
+	munmap(Mem, SzResults);
+
+	std::printf("{\"compress\":\"%s\",\"workers\":%llu,\"steps\":%llu,\"batch\":%llu,\"loss_first\":%.5f,\"loss_last\":%.5f,\"identical\":%s,\"seconds\":%.3f}\n",
+		(_Compress == FnCompress::Q8) ? "q8" : "none", (unsigned long long)_Workers, (unsigned long long)_Steps, (unsigned long long)_Batch,
+		First / r64(_Workers), Last / r64(_Workers), Identical ? "true" : "false", Seconds);
+
+	return Success && Identical && (Last < First);
+}
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Group must refuse mismatched network and launcher must notice worker that threw. Last rank also fails inside allReduce,
+// by throwing or by dying, after others already wait there. Launcher must return instead of hanging.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+auto procsFailures ( const sx::uMAX _Workers ) -> bool
+{
+	using namespace sx;
+
+	auto Reference = Net();
+	procsBuild(Reference);
+
+	auto Refused = false;
+	auto Group = ProcGroup<r32>(1, Reference.bufSz(LayerBuf::PARAMS) + 1);
+	try { Group.allReduce(0, Reference); }
+	catch(const fx::Error&) { Refused = true; }
+
+	const auto Reported = !spawnWorkers(_Workers, []( const uMAX _Rank ) { if(_Rank == 0) throw std::runtime_error("Worker failed!"); });
+
+	const auto failInReduce = [&]( const bool _Die ) -> bool
+	{
+		auto Group = ProcGroup<r32>(_Workers, Reference.bufSz(LayerBuf::PARAMS));
+		return !spawnWorkers(_Workers, [&]( const uMAX _Rank )
+		{
+			auto Worker = Net();
+			procsBuild(Worker);
+			Group.broadcast(_Rank, Worker);
+
+			if(_Rank + 1 < _Workers) { Group.allReduce(_Rank, Worker); return; }
+			if(_Die) _exit(3);
+
+			auto Other = Net();
+			Other.attach(new Dense<r32, SZ_IN, SZ_OUT, FnTrTanh<r32>>());
+			Other.attach(new sx::Error<r32, SZ_OUT>());
+			Group.allReduce(_Rank, Other);
+		});
+	};
+
+	const auto Start = std::chrono::steady_clock::now();
+	const auto ThrownInReduce = failInReduce(false);
+	const auto DiedInReduce = failInReduce(true);
+	const auto Seconds = std::chrono::duration<r64>(std::chrono::steady_clock::now() - Start).count();
+
+	std::printf("{\"refused_size\":%s,\"reported_failure\":%s,\"reported_throw_in_reduce\":%s,\"reported_death_in_reduce\":%s,\"seconds\":%.3f}\n", Refused ? "true" : "false",
+		Reported ? "true" : "false", ThrownInReduce ? "true" : "false", DiedInReduce ? "true" : "false", Seconds);
+	return Refused && Reported && ThrownInReduce && DiedInReduce;
+}
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Entry.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+auto main ( int _Argc, char** _Argv ) -> int
+{
+	using namespace sx;
+
+	auto Workers = uMAX(2);
+	auto Steps = uMAX(40);
+	auto Batch = uMAX(16);
+	auto Rate = rMAX(0.01);
+
+	for(auto a = 1; a + 1 < _Argc; a += 2)
+	{
+		const auto Arg = str(_Argv[a]);
+		const auto Value = str(_Argv[a + 1]);
+
+		if(Arg == "--workers"s) Workers = std::max(std::stoull(Value), 1ull);
+		else if(Arg == "--steps"s) Steps = std::max(std::stoull(Value), 1ull);
+		else if(Arg == "--batch"s) Batch = std::max(std::stoull(Value), 1ull);
+		else if(Arg == "--rate"s) Rate = std::stod(Value);
+		else { std::cerr << "Unknown argument ["s << Arg << "]!\n"s; return -1; }
+	}
+
+	auto Success = true;
+	Success &= procsRun(FnCompress::NONE, Workers, Steps, Batch, Rate);
+	Success &= procsRun(FnCompress::Q8, Workers, Steps, Batch, Rate);
+	Success &= procsFailures(Workers);
+
+	return Success ? 0 : 1;
+}
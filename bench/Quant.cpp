@@ -0,0 +1,116 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Post-training int8 quantization of dense and convolutional network.
+//
+// quant [--samples 256] [--batch 64] [--seconds 0.5]
+//
+// Float network is calibrated over sample cache, quantized and compared against quantized copy.
+// Every network prints JSON line with single and batch latency of both, stored size and accuracy of quantized one.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "../stacks/Bench.hpp"
+#include <iostream>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Calibrate, quantize and measure one pair of networks.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+template<class NET, class BUILD, class BUILD_Q> auto quantRun ( const char* _Name, BUILD&& _Build, BUILD_Q&& _BuildQ, const sx::uMAX _Samples, const sx::uMAX _Batch, const sx::r64 _Seconds ) -> bool
+{
+	using namespace sx;
+
+	auto Float = NET();
+	auto Quant = NET();
+	_Build(Float);
+	_BuildQ(Quant);
+
+	const auto SzIn = uMAX(Float.front()->desc().SzIn);
+	auto Samples = vec<vec<r32>>(_Samples, vec<r32>(SzIn));
+	for(auto n = uMAX(0); n < _Samples; ++n) for(auto i = uMAX(0); i < SzIn; ++i) Samples[n][i] = r32(0.5 + 0.5 * std::sin(r64(i) * 0.013 * r64(n % 7 + 1) + r64(n)));
+
+	const auto Ranges = quantCalibrate(Float, Samples);
+	if(!quantizeNetwork(Quant, Float, Ranges)) { std::cerr << "Networks differ in shape!\n"s; return false; }
+	const auto Report = quantCompare(Float, Quant, Samples);
+
+	auto Inputs = vec<r32>(_Batch * SzIn);
+	for(auto n = uMAX(0); n < _Batch; ++n) memCopy(SzIn, Inputs.data() + n * SzIn, Samples[n % _Samples].data());
+
+	const auto FloatExe = benchTime(_Seconds, [&]( void ) { Float.exe(Inputs.data(), false); });
+	const auto QuantExe = benchTime(_Seconds, [&]( void ) { Quant.exe(Inputs.data(), false); });
+	const auto FloatBatch = benchTime(_Seconds, [&]( void ) { Float.exeBatch(Inputs.data(), SzIn, _Batch, false); }) / r64(_Batch);
+	const auto QuantBatch = benchTime(_Seconds, [&]( void ) { Quant.exeBatch(Inputs.data(), SzIn, _Batch, false); }) / r64(_Batch);
+
+	auto FloatStream = std::ostringstream();
+	auto QuantStream = std::ostringstream();
+	Float.front()->store(FloatStream);
+	Quant.front()->store(QuantStream);
+
+	std::printf("{\"net\":\"%s\",\"float_us\":%.2f,\"q8_us\":%.2f,\"speedup\":%.2f,\"float_batch_us\":%.2f,\"q8_batch_us\":%.2f,\"batch_speedup\":%.2f,\"float_bytes\":%zu,\"q8_bytes\":%zu,\"samples\":%llu,\"mean_abs_err\":%.5f,\"max_abs_err\":%.5f,\"agreement\":%.4f}\n",
+		_Name, FloatExe * 1e-3, QuantExe * 1e-3, FloatExe / QuantExe, FloatBatch * 1e-3, QuantBatch * 1e-3, FloatBatch / QuantBatch,
+		FloatStream.str().size(), QuantStream.str().size(), (unsigned long long)Report.Samples, Report.MeanAbsErr, Report.MaxAbsErr, Report.Agreement);
+
+	return true;
+}
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Entry.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+auto main ( int _Argc, char** _Argv ) -> int
+{
+	using namespace sx;
+	using Net = Network<r32,CompClass::LAYERS>;
+
+	auto Samples = uMAX(256);
+	auto Batch = uMAX(64);
+	auto Seconds = r64(0.5);
+
+	for(auto a = 1; a + 1 < _Argc; a += 2)
+	{
+		const auto Arg = str(_Argv[a]);
+		const auto Value = str(_Argv[a + 1]);
+
+		if(Arg == "--samples"s) Samples = std::max(std::stoull(Value), 1ull);
+		else if(Arg == "--batch"s) Batch = std::max(std::stoull(Value), 1ull);
+		else if(Arg == "--seconds"s) Seconds = std::stod(Value);
+		else { std::cerr << "Unknown argument ["s << Arg << "]!\n"s; return -1; }
+	}
+
+	auto Success = true;
+
+	Success &= quantRun<Net>("dense",
+		[]( Net& _Net )
+		{
+			_Net.attach(new Dense<r32, 1024, 1024, FnTrRelu<r32>>());
+			_Net.attach(new Dense<r32, 1024, 512, FnTrRelu<r32>>());
+			_Net.attach(new Dense<r32, 512, 10, FnTrTanh<r32>>());
+			_Net.attach(new sx::Error<r32, 10>());
+		},
+		[]( Net& _Net )
+		{
+			_Net.attach(new DenseQ8<r32, 1024, 1024, FnTrRelu<r32>>());
+			_Net.attach(new DenseQ8<r32, 1024, 512, FnTrRelu<r32>>());
+			_Net.attach(new DenseQ8<r32, 512, 10, FnTrTanh<r32>>());
+			_Net.attach(new sx::Error<r32, 10>());
+		}, Samples, Batch, Seconds);
+
+	Success &= quantRun<Net>("conv",
+		[]( Net& _Net )
+		{
+			_Net.attach(new Conv2<r32, 32, 32, 3, 16, 1>());
+			_Net.attach(new Downscale2<r32, 32, 32, 16>());
+			_Net.attach(new Conv2<r32, 16, 16, 16, 32, 1>());
+			_Net.attach(new Downscale2<r32, 16, 16, 32>());
+			_Net.attach(new Dense<r32, 8 * 8 * 32, 10, FnTrTanh<r32>>());
+			_Net.attach(new sx::Error<r32, 10>());
+		},
+		[]( Net& _Net )
+		{
+			_Net.attach(new Conv2Q8<r32, 32, 32, 3, 16, 1>());
+			_Net.attach(new Downscale2<r32, 32, 32, 16>());
+			_Net.attach(new Conv2Q8<r32, 16, 16, 16, 32, 1>());
+			_Net.attach(new Downscale2<r32, 16, 16, 32>());
+			_Net.attach(new DenseQ8<r32, 8 * 8 * 32, 10, FnTrTanh<r32>>());
+			_Net.attach(new sx::Error<r32, 10>());
+		}, Samples, Batch, Seconds);
+
+	return Success ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Load generator for batched inference server.
+//
+// serve [--clients 8] [--depth 4] [--seconds 2] [--batch 32] [--delay 0.001] [--replicas 2]
+//
+// Every client thread keeps depth requests in flight against small dense network and waits for oldest one
+// when window is full. Latency percentiles, throughput and mean batch are printed as JSON line.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "../stacks/stacks.hpp"
+#include <deque>
+#include <iostream>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Entry.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+auto main ( int _Argc, char** _Argv ) -> int
+{
+	using namespace sx;
+	using Net = Network<r32,CompClass::LAYERS>;
+
+	auto Cfg = CfgServer(32, 0.001, 2);
+	auto Clients = uMAX(8);
+	auto Depth = uMAX(4);
+	auto Seconds = r64(2.0);
+
+	for(auto a = 1; a + 1 < _Argc; a += 2)
+	{
+		const auto Arg = str(_Argv[a]);
+		const auto Value = str(_Argv[a + 1]);
+
+		if(Arg == "--clients"s) Clients = std::stoull(Value);
+		else if(Arg == "--depth"s) Depth = std::max(std::stoull(Value), 1ull);
+		else if(Arg == "--seconds"s) Seconds = std::stod(Value);
+		else if(Arg == "--batch"s) Cfg.MaxBatch = std::max(std::stoull(Value), 1ull);
+		else if(Arg == "--delay"s) Cfg.MaxDelay = std::stod(Value);
+		else if(Arg == "--replicas"s) Cfg.Replicas = std::max(std::stoull(Value), 1ull);
+		else { std::cerr << "Unknown argument ["s << Arg << "]!\n"s; return -1; }
+	}
+
+
+	// Replicas share parameters of one reference network.
+	const auto Build = []( Net& _Net )
+	{
+		_Net.attach(new Dense<r32, 256, 256, FnTrRelu<r32>>());
+		_Net.attach(new Dense<r32, 256, 256, FnTrRelu<r32>>());
+		_Net.attach(new Dense<r32, 256, 10, FnTrTanh<r32>>());
+		_Net.attach(new sx::Error<r32, 10>());
+	};
+
+	auto Reference = Net();
+	Build(Reference);
+	auto Params = vec<r32>(Reference.bufSz(LayerBuf::PARAMS));
+	Reference.gather(Params.data(), LayerBuf::PARAMS);
+
+	auto Engine = Server<r32>(Cfg, [&]( Net& _Net ) { Build(_Net); _Net.scatter(Params.data(), LayerBuf::PARAMS); });
+
+
+	// Clients run until time is up.
+	auto Inputs = vec<r32>(Engine.inSz() * 64);
+	for(auto i = uMAX(0); i < Inputs.size(); ++i) Inputs[i] = r32(std::sin(r64(i) * 0.37));
+
+	const auto End = std::chrono::steady_clock::now() + std::chrono::duration<r64>(Seconds);
+	auto Threads = vec<std::thread>();
+	auto Failed = std::atomic<u64>(0);
+
+	Engine.statsReset();
+	for(auto c = uMAX(0); c < Clients; ++c) Threads.emplace_back([&, c]( void )
+	{
+		auto Window = std::deque<std::future<vec<r32>>>();
+		auto Next = c;
+
+		while(std::chrono::steady_clock::now() < End)
+		{
+			Window.push_back(Engine.submit(Inputs.data() + (Next++ % 64) * Engine.inSz()));
+			if(Window.size() < Depth) continue;
+			if(Window.front().get().size() != Engine.outSz()) Failed++;
+			Window.pop_front();
+		}
+
+		for(auto& F : Window) if(F.get().size() != Engine.outSz()) Failed++;
+	});
+
+	for(auto& T : Threads) T.join();
+	const auto Stats = Engine.stats();
+	Engine.stop();
+
+
+	std::printf("{\"clients\":%llu,\"depth\":%llu,\"max_batch\":%llu,\"max_delay_us\":%.0f,\"replicas\":%llu,\"requests\":%llu,\"batches\":%llu,\"mean_batch\":%.2f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"throughput\":%.0f,\"failed\":%llu}\n",
+		(unsigned long long)Clients, (unsigned long long)Depth, (unsigned long long)Cfg.MaxBatch, Cfg.MaxDelay * 1e6, (unsigned long long)Cfg.Replicas,
+		(unsigned long long)Stats.Requests, (unsigned long long)Stats.Batches, Stats.MeanBatch, Stats.P50 * 1e6, Stats.P99 * 1e6, Stats.Throughput, (unsigned long long)Failed.load());
+
+	return Failed.load() ? 1 : 0;
+}
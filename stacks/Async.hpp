@@ -0,0 +1,382 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Network.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Configuration of asynchronous inference.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct CfgAsync
+	{
+		uMAX Replicas; // Networks running in parallel, each at most one pool task at a time.
+		uMAX MaxBatch; // Most waiting requests replica takes at once.
+
+		CfgAsync ( const uMAX _Replicas = 1, const uMAX _MaxBatch = 16 ) :
+		Replicas(std::max(_Replicas, uMAX(1))),
+		MaxBatch(std::max(_MaxBatch, uMAX(1)))
+		{}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Progress of asynchronous inference.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class AsyncState : u64
+	{
+		NEW,
+		QUEUED,
+		RUNNING,
+		DONE,
+		CANCELLED
+	};
+
+
+	template<class T> class AsyncInference;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Awaitable inference of single sample. Lives in awaiting coroutine frame and is its own queue node, so requests in flight cost
+	// no threads and no allocations. Awaiting yields true once output is written or false if stop was requested before forward pass began.
+	// Input and output must stay valid until awaiting resumes.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class AsyncInfer
+	{
+		friend class AsyncInference<T>;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Cancel
+		{
+			AsyncInfer* Op;
+			auto operator() ( void ) -> void { this->Op->Owner->cancel(*this->Op); }
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		AsyncInference<T>* Owner;
+		const T* Input;
+		T* Output;
+		std::stop_token Token;
+		std::optional<std::stop_callback<Cancel>> OnStop;
+		std::coroutine_handle<> Caller;
+		std::exception_ptr Failure;
+		AsyncInfer* Prev;
+		AsyncInfer* Next;
+		AsyncState State;
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		AsyncInfer ( AsyncInference<T>* _Owner, const T* _Input, T* _Output, std::stop_token _Token ) :
+			Owner(_Owner),
+			Input(_Input),
+			Output(_Output),
+			Token(std::move(_Token)),
+			OnStop(),
+			Caller(),
+			Failure(),
+			Prev(nullptr),
+			Next(nullptr),
+			State(AsyncState::NEW)
+		{}
+
+		AsyncInfer ( const AsyncInfer& ) = delete;
+		auto operator= ( const AsyncInfer& ) -> AsyncInfer& = delete;
+
+		auto await_ready ( void ) const noexcept -> bool { return false; }
+		auto await_suspend ( std::coroutine_handle<> _Caller ) -> bool { this->Caller = _Caller; return this->Owner->start(*this); }
+
+		auto await_resume ( void ) -> bool
+		{
+			this->OnStop.reset();
+			if(this->Failure) std::rethrow_exception(this->Failure);
+			return this->State == AsyncState::DONE;
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Awaitable inference on library thread pool. Coroutine awaiting infer() is suspended while its forward pass runs as pool task
+	// and is resumed on pool thread that finished it. Requests waiting for busy replicas are queued and replica
+	// takes up to MaxBatch of them at once through batch mode. Forward pass runs serially within its task, requests are spread over threads.
+	// Without pool workers inference runs synchronously inside co_await.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class AsyncInference
+	{
+		friend class AsyncInfer<T>;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		using Net = Network<T,CompClass::LAYERS>;
+		using Op = AsyncInfer<T>;
+
+		struct Replica
+		{
+			std::unique_ptr<Net> Model;
+			BatchBuf<T> Inputs;
+			vec<Op*> Batch;
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		CfgAsync Cfg;
+		uMAX SzIn;
+		uMAX SzOut;
+		vec<std::unique_ptr<Replica>> Replicas;
+		vec<Replica*> Idle;
+		Op* Head; // Waiting requests, oldest first.
+		Op* Tail;
+
+		std::mutex Lock;
+		std::condition_variable Drained;
+		std::atomic<bool> Running;
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor. _Build attaches layers of one replica and is called once per replica.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		AsyncInference ( const CfgAsync& _Cfg, const std::function<void(Net&)>& _Build ) :
+			Cfg(_Cfg),
+			SzIn(0),
+			SzOut(0),
+			Replicas(),
+			Idle(),
+			Head(nullptr),
+			Tail(nullptr),
+			Running(true)
+		{
+			for(auto r = uMAX(0); r < this->Cfg.Replicas; ++r)
+			{
+				auto R = std::make_unique<Replica>();
+				R->Model = std::make_unique<Net>();
+				_Build(*R->Model);
+				R->Model->connect();
+
+				const auto SzIn = uMAX(R->Model->front()->desc().SzIn);
+				const auto SzOut = uMAX(R->Model->back()->outSz());
+				if(r > 0 && (SzIn != this->SzIn || SzOut != this->SzOut)) throw Error("sx"s, "AsyncInference<T>"s, "AsyncInference"s, 0, "Replicas differ in shape!"s);
+				this->SzIn = SzIn;
+				this->SzOut = SzOut;
+
+				R->Inputs.reserve(this->Cfg.MaxBatch * this->SzIn);
+				R->Batch.reserve(this->Cfg.MaxBatch);
+				this->Idle.push_back(R.get());
+				this->Replicas.push_back(std::move(R));
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~AsyncInference ( void ) { this->stop(); }
+
+		AsyncInference ( const AsyncInference& ) = delete;
+		auto operator= ( const AsyncInference& ) -> AsyncInference& = delete;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Awaitable inference of inSz() Ts into outSz() Ts. Stop request on _Token drops request still waiting for replica.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto infer ( const T* _Input, T* _Output, std::stop_token _Token = std::stop_token() ) -> AsyncInfer<T>
+		{
+			return AsyncInfer<T>(this, _Input, _Output, std::move(_Token));
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Refuse new requests and wait for waiting and running ones to finish. Must not race infer or be called from pool task.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto stop ( void ) -> void
+		{
+			this->Running.store(false, std::memory_order_release);
+			auto Guard = std::unique_lock(this->Lock);
+			this->Drained.wait(Guard, [&]( void ) { return this->Idle.size() == this->Replicas.size(); });
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Get sizes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto inSz ( void ) const -> uMAX { return this->SzIn; }
+		inline auto outSz ( void ) const -> uMAX { return this->SzOut; }
+
+		private:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Queue links. Lock must be held.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto link ( Op& _Op ) -> void
+		{
+			_Op.Prev = this->Tail;
+			_Op.Next = nullptr;
+			if(this->Tail) this->Tail->Next = &_Op;
+			else this->Head = &_Op;
+			this->Tail = &_Op;
+		}
+
+		auto unlink ( Op& _Op ) -> void
+		{
+			if(_Op.Prev) _Op.Prev->Next = _Op.Next;
+			else this->Head = _Op.Next;
+			if(_Op.Next) _Op.Next->Prev = _Op.Prev;
+			else this->Tail = _Op.Prev;
+			_Op.Prev = nullptr;
+			_Op.Next = nullptr;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Called on suspension. Returns false when awaiting coroutine should continue at once.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto start ( Op& _Op ) -> bool
+		{
+			if(!this->Running.load(std::memory_order_acquire)) throw Error("sx"s, "AsyncInference<T>"s, "infer"s, 0, "Inference is stopped!"s);
+			if(_Op.Token.stop_requested()) { _Op.State = AsyncState::CANCELLED; return false; }
+
+			// Callback may run right here, it then only marks request cancelled.
+			if(_Op.Token.stop_possible()) _Op.OnStop.emplace(_Op.Token, typename Op::Cancel{&_Op});
+
+			auto Guard = std::unique_lock(this->Lock);
+			if(_Op.State == AsyncState::CANCELLED) return false;
+
+			if(this->Idle.empty())
+			{
+				_Op.State = AsyncState::QUEUED;
+				this->link(_Op);
+				return true;
+			}
+
+			const auto R = this->Idle.back();
+			this->Idle.pop_back();
+			_Op.State = AsyncState::RUNNING;
+			R->Batch.push_back(&_Op);
+			Guard.unlock();
+
+			if(threadPool().size() == 0)
+			{
+				this->run(*R, &_Op);
+				return false;
+			}
+
+			threadPool().post([this, R]( void ) { this->run(*R, nullptr); });
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Stop callback of request. Waiting request leaves queue and its coroutine is resumed on pool.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto cancel ( Op& _Op ) -> void
+		{
+			auto Guard = std::unique_lock(this->Lock);
+
+			if(_Op.State == AsyncState::NEW) { _Op.State = AsyncState::CANCELLED; return; }
+			if(_Op.State != AsyncState::QUEUED) return;
+
+			this->unlink(_Op);
+			_Op.State = AsyncState::CANCELLED;
+			const auto Caller = _Op.Caller;
+			Guard.unlock();
+
+			threadPool().post([Caller]( void ) { Caller.resume(); });
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Pool task. Runs batch of replica, hands replica to next waiting requests and resumes callers except _Inline,
+		// whose coroutine did not suspend. Nothing of this is touched once replica is handed over.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto run ( Replica& _Replica, const Op* _Inline ) -> void
+		{
+			SX_MC_TRACE("async", "batch");
+
+			auto& Batch = _Replica.Batch;
+			const auto Count = Batch.size();
+			auto Failure = std::exception_ptr();
+
+			try
+			{
+				if(Count == 1)
+				{
+					_Replica.Model->exe(Batch[0]->Input, false);
+					memCopy(this->SzOut, Batch[0]->Output, _Replica.Model->out(false));
+				}
+
+				else
+				{
+					const auto Inputs = _Replica.Inputs.reserve(Count * this->SzIn);
+					for(auto n = uMAX(0); n < Count; ++n) memCopy(this->SzIn, Inputs + n * this->SzIn, Batch[n]->Input);
+
+					_Replica.Model->exeBatch(Inputs, this->SzIn, Count, false);
+					const auto Outputs = _Replica.Model->outBatch(false);
+					for(auto n = uMAX(0); n < Count; ++n) memCopy(this->SzOut, Batch[n]->Output, Outputs + n * this->SzOut);
+				}
+			}
+
+			catch(...)
+			{
+				Failure = std::current_exception();
+			}
+
+			// Running requests can no longer be cancelled, so their callbacks go before anything else.
+			auto Callers = vec<std::coroutine_handle<>>();
+			Callers.reserve(Count);
+			for(const auto B : Batch)
+			{
+				B->OnStop.reset();
+				B->Failure = Failure;
+				if(B != _Inline) Callers.push_back(B->Caller);
+			}
+
+			auto More = false;
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				for(const auto B : Batch) B->State = AsyncState::DONE;
+				Batch.clear();
+
+				while(this->Head && Batch.size() < this->Cfg.MaxBatch)
+				{
+					const auto Next = this->Head;
+					this->unlink(*Next);
+					Next->State = AsyncState::RUNNING;
+					Batch.push_back(Next);
+				}
+
+				More = !Batch.empty();
+				if(!More)
+				{
+					this->Idle.push_back(&_Replica);
+					if(this->Idle.size() == this->Replicas.size()) this->Drained.notify_all();
+				}
+			}
+
+			if(More) threadPool().post([this, &_Replica]( void ) { this->run(_Replica, nullptr); });
+			for(const auto C : Callers) C.resume();
+		}
+	};
+}
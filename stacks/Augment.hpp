@@ -0,0 +1,192 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Sampler.hpp"
+#include <memory>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Configuration of runtime augmentation. Samples are Depth planes of Width x Height, as built from images.
+	// Crops and flips apply to inputs and targets alike, degradation and noise only to inputs.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct CfgAugment
+	{
+		uMAX Width;
+		uMAX Height;
+		uMAX Depth;
+		uMAX CropWidth; // Random crop of this width. Zero keeps width.
+		uMAX CropHeight; // Random crop of this height. Zero keeps height.
+		bool FlipX; // Mirror horizontally with probability of half.
+		bool FlipY; // Mirror vertically with probability of half.
+		uMAX DownUp; // Downscale by random factor from 1 to this then upscale back.
+		r64 Noise; // Standard deviation of additive noise.
+
+		CfgAugment ( const uMAX _Width = 64, const uMAX _Height = 64, const uMAX _Depth = 1, const uMAX _CropWidth = 0, const uMAX _CropHeight = 0, const bool _FlipX = true, const bool _FlipY = false, const uMAX _DownUp = 1, const r64 _Noise = 0.0 ) :
+		Width(_Width),
+		Height(_Height),
+		Depth(_Depth),
+		CropWidth(_CropWidth),
+		CropHeight(_CropHeight),
+		FlipX(_FlipX),
+		FlipY(_FlipY),
+		DownUp(_DownUp),
+		Noise(_Noise)
+		{}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Copy _CropW x _CropH window at _X, _Y of every plane.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto augCrop ( const T* _Src, const uMAX _Width, const uMAX _Height, const uMAX _Depth, const uMAX _X, const uMAX _Y, const uMAX _CropW, const uMAX _CropH, T* _Dst ) -> void
+	{
+		for(auto d = uMAX(0); d < _Depth; ++d)
+		{
+			for(auto y = uMAX(0); y < _CropH; ++y) memCopy(_CropW, _Dst + math::index_c(0, y, d, _CropW, _CropH), _Src + math::index_c(_X, _Y + y, d, _Width, _Height));
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Mirror every plane horizontally.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto augFlipX ( T* _Data, const uMAX _Width, const uMAX _Height, const uMAX _Depth ) -> void
+	{
+		for(auto r = uMAX(0); r < _Height * _Depth; ++r) std::reverse(_Data + r * _Width, _Data + (r + 1) * _Width);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Mirror every plane vertically.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto augFlipY ( T* _Data, const uMAX _Width, const uMAX _Height, const uMAX _Depth ) -> void
+	{
+		for(auto d = uMAX(0); d < _Depth; ++d)
+		{
+			const auto Plane = _Data + d * _Width * _Height;
+			for(auto y = uMAX(0); y < _Height / 2; ++y) std::swap_ranges(Plane + y * _Width, Plane + (y + 1) * _Width, Plane + (_Height - 1 - y) * _Width);
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Degrade by box downscale with _Factor and nearest upscale back. Edge blocks average what they cover.
+	// Rows of block are summed first so inner loops run over contiguous memory.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto augDownUp ( T* _Data, const uMAX _Width, const uMAX _Height, const uMAX _Depth, const uMAX _Factor ) -> void
+	{
+		if(_Factor <= 1) return;
+
+		thread_local auto Sum = vec<T>();
+		Sum.resize(_Width);
+
+		for(auto d = uMAX(0); d < _Depth; ++d)
+		{
+			const auto Plane = _Data + d * _Width * _Height;
+			for(auto by = uMAX(0); by < _Height; by += _Factor)
+			{
+				const auto Rows = std::min(_Factor, _Height - by);
+
+				memCopy(_Width, Sum.data(), Plane + by * _Width);
+				for(auto y = uMAX(1); y < Rows; ++y)
+				{
+					const auto Row = Plane + (by + y) * _Width;
+					for(auto x = uMAX(0); x < _Width; ++x) Sum[x] += Row[x];
+				}
+
+				for(auto bx = uMAX(0); bx < _Width; bx += _Factor)
+				{
+					const auto Cols = std::min(_Factor, _Width - bx);
+					auto Avg = T(0);
+					for(auto x = uMAX(0); x < Cols; ++x) Avg += Sum[bx + x];
+					Sum[bx] = Avg / T(Rows * Cols);
+				}
+
+				for(auto bx = uMAX(0); bx < _Width; bx += _Factor) std::fill(Sum.begin() + bx + 1, Sum.begin() + std::min(bx + _Factor, _Width), Sum[bx]);
+				for(auto y = uMAX(0); y < Rows; ++y) memCopy(_Width, Plane + (by + y) * _Width, Sum.data());
+			}
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Add approximately normal noise. Counter based generator keeps loop free of dependencies so it vectorizes,
+	// every value is sum of four uniforms rescaled to unit variance.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto augNoise ( T* _Data, const uMAX _Count, const r64 _Stddev, const u64 _Seed ) -> void
+	{
+		const auto Scale = T(_Stddev * std::sqrt(3.0) / 65536.0);
+		const auto Bias = T(_Stddev * std::sqrt(3.0) * 2.0);
+
+		for(auto i = uMAX(0); i < _Count; ++i)
+		{
+			auto z = _Seed + (i + 1) * u64(0x9E3779B97F4A7C15);
+			z = (z ^ (z >> 30)) * u64(0xBF58476D1CE4E5B9);
+			z = (z ^ (z >> 27)) * u64(0x94D049BB133111EB);
+			z = z ^ (z >> 31);
+
+			const auto Uniforms = T((z & 0xFFFF) + ((z >> 16) & 0xFFFF) + ((z >> 32) & 0xFFFF) + (z >> 48));
+			_Data[i] += Uniforms * Scale - Bias;
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Sampler stage applying random augmentation to every batch. Runs on sampler helper thread.
+	// Separate targets must have same geometry as inputs.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto augmentStage ( const CfgAugment& _Cfg, const u64 _Seed = 0 ) -> BatchStage<T>
+	{
+		const auto CropW = (_Cfg.CropWidth != 0) ? std::min(_Cfg.CropWidth, _Cfg.Width) : _Cfg.Width;
+		const auto CropH = (_Cfg.CropHeight != 0) ? std::min(_Cfg.CropHeight, _Cfg.Height) : _Cfg.Height;
+		const auto SampleSz = CropW * CropH * _Cfg.Depth;
+		const auto Rng = std::make_shared<std::mt19937_64>(_Seed);
+
+		return BatchStage<T>{SampleSz, SampleSz, [_Cfg, CropW, CropH, SampleSz, Rng]( const SamplesBatch<T>& _Raw, T* _Inputs, T* _Targets, const uMAX _Stride, const uMAX _StrideTargets )
+		{
+			for(auto i = uMAX(0); i < _Raw.Count; ++i)
+			{
+				// Draw parameters.
+				const auto X = std::uniform_int_distribution<uMAX>(0, _Cfg.Width - CropW)(*Rng);
+				const auto Y = std::uniform_int_distribution<uMAX>(0, _Cfg.Height - CropH)(*Rng);
+				const auto FlipX = _Cfg.FlipX && ((*Rng)() & 1);
+				const auto FlipY = _Cfg.FlipY && ((*Rng)() & 1);
+				const auto Factor = std::uniform_int_distribution<uMAX>(1, std::max(_Cfg.DownUp, uMAX(1)))(*Rng);
+				const auto Seed = (*Rng)();
+
+
+				// Geometry is shared by input and target.
+				const auto Input = _Inputs + i * _Stride;
+				const auto Target = _Targets + i * _StrideTargets;
+
+				augCrop(_Raw.input(i), _Cfg.Width, _Cfg.Height, _Cfg.Depth, X, Y, CropW, CropH, Input);
+				augCrop(_Raw.target(i), _Cfg.Width, _Cfg.Height, _Cfg.Depth, X, Y, CropW, CropH, Target);
+
+				if(FlipX) { augFlipX(Input, CropW, CropH, _Cfg.Depth); augFlipX(Target, CropW, CropH, _Cfg.Depth); }
+				if(FlipY) { augFlipY(Input, CropW, CropH, _Cfg.Depth); augFlipY(Target, CropW, CropH, _Cfg.Depth); }
+
+
+				// Degrade input only.
+				augDownUp(Input, CropW, CropH, _Cfg.Depth, Factor);
+				if(_Cfg.Noise > 0.0) augNoise(Input, SampleSz, _Cfg.Noise, Seed);
+			}
+		}};
+	}
+}
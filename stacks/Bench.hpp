@@ -0,0 +1,316 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./stacks.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto BENCH_ROUNDS = uMAX(5); // Timed rounds, median is reported.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Benchmark settings.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct CfgBench
+	{
+		r64 Seconds; // Time budget of single measurement.
+		str Filter; // Run only cases which name contains this.
+
+		CfgBench ( const r64 _Seconds = 0.25, const str& _Filter = ""s ) :
+			Seconds(_Seconds),
+			Filter(_Filter)
+		{}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Measurement of single operation of single case.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct BenchResult
+	{
+		str Name; // Case, like Dense<256,256>.
+		str Type; // Scalar type.
+		str Op; // exe, fit, apply or call.
+		r64 Nanos; // Median time of single call.
+		u64 Flops; // Work of single call.
+		u64 Bytes;
+
+		auto key ( void ) const -> str { return this->Name + "/"s + this->Type + "/"s + this->Op; }
+		auto gflops ( void ) const -> r64 { return r64(this->Flops) / std::max(this->Nanos, 1e-9); }
+		auto gbytes ( void ) const -> r64 { return r64(this->Bytes) / std::max(this->Nanos, 1e-9); }
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Name of scalar type.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> constexpr inline auto benchTypeName ( void ) -> const char*
+	{
+		if constexpr(std::is_same_v<T,r32>) return "float";
+		else if constexpr(std::is_same_v<T,r64>) return "double";
+		else return "other";
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Time _Fn in nanoseconds per call. Iterations grow until round fills its share of budget,
+	// median of rounds is returned so single preemption does not skew result.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class FN> auto benchTime ( const r64 _Seconds, FN&& _Fn ) -> r64
+	{
+		using Clock = std::chrono::steady_clock;
+		const auto RoundNanos = _Seconds * 1e9 / r64(BENCH_ROUNDS);
+
+		const auto run = [&]( const uMAX _Iters ) -> r64
+		{
+			const auto Beg = Clock::now();
+			for(auto i = uMAX(0); i < _Iters; ++i) _Fn();
+			return r64(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - Beg).count());
+		};
+
+		// Warm up caches and thread pool, then calibrate.
+		run(1);
+		auto Iters = uMAX(1);
+		while(run(Iters) < RoundNanos / 4.0 && Iters < (uMAX(1) << 30)) Iters *= 2;
+
+		auto Rounds = vec<r64>(BENCH_ROUNDS);
+		for(auto& Round : Rounds) Round = run(Iters) / r64(Iters);
+
+		std::nth_element(Rounds.begin(), Rounds.begin() + BENCH_ROUNDS / 2, Rounds.end());
+		return Rounds[BENCH_ROUNDS / 2];
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Front layer standing in for rest of network. Provides gradient of matching size.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class BenchSink : public Layer<T>
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		vec<T> Gradient;
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		BenchSink ( const uMAX _Size ) : Gradient(_Size, T(0.001)) {}
+
+		SX_FNSIG_LAYER_OUTSZ final { return this->Gradient.size(); }
+		SX_FNSIG_LAYER_OUTSZBT final { return this->Gradient.size() * sizeof(T); }
+		SX_FNSIG_LAYER_OUT final { return this->Input; }
+		SX_FNSIG_LAYER_GRAD final { return this->Gradient.data(); }
+		SX_FNSIG_LAYER_EXE final { return; }
+		SX_FNSIG_LAYER_FIT final { return; }
+		SX_FNSIG_LAYER_OUT_BATCH final { return this->InputBatch; }
+		SX_FNSIG_LAYER_GRAD_BATCH final { return this->Gradient.data(); }
+		SX_FNSIG_LAYER_EXE_BATCH final { return; }
+		SX_FNSIG_LAYER_FIT_BATCH final { return; }
+		SX_FNSIG_LAYER_EXCHANGE final { return; }
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::NONE, this->Gradient.size(), this->Gradient.size(), 0, 0}; }
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Benchmark exe, fit and apply of single layer without chaining.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, class LAYER> auto benchLayer ( const str& _Name, const CfgBench& _Cfg, vec<BenchResult>& _Results ) -> void
+	{
+		if(_Name.find(_Cfg.Filter) == str::npos) return;
+
+		const auto Layer = std::make_unique<LAYER>();
+		const auto Desc = Layer->desc();
+
+		auto Input = vec<T>(Desc.SzIn);
+		for(auto i = uMAX(0); i < Input.size(); ++i) Input[i] = T(i % 17) * T(0.01);
+
+		auto Sink = BenchSink<T>(Desc.SzOut);
+		Layer->setInput(Input.data());
+		Layer->setFront(&Sink);
+
+		auto Iter = uMAX(0);
+		const auto Type = str(benchTypeName<T>());
+		const auto Exe = benchTime(_Cfg.Seconds, [&]( void ) { Layer->exe(false); });
+		const auto Fit = benchTime(_Cfg.Seconds, [&]( void ) { Layer->fit(nullptr, 0.0, false); });
+		const auto Apply = benchTime(_Cfg.Seconds, [&]( void ) { Layer->apply(1e-6, Iter++, false); });
+
+		const auto CostExe = Layer->cost(LayerOp::EXE);
+		const auto CostFit = Layer->cost(LayerOp::FIT);
+		const auto CostApply = Layer->cost(LayerOp::APPLY);
+
+		_Results.push_back(BenchResult{_Name, Type, "exe"s, Exe, CostExe.Flops, CostExe.Bytes});
+		_Results.push_back(BenchResult{_Name, Type, "fit"s, Fit, CostFit.Flops, CostFit.Bytes});
+		if(Desc.SzWeights + Desc.SzBiases != 0) _Results.push_back(BenchResult{_Name, Type, "apply"s, Apply, CostApply.Flops, CostApply.Bytes});
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Benchmark optimizer step over _Size parameters.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, FnOptim FN_OPTIM> auto benchOptim ( const str& _Name, const uMAX _Size, const CfgBench& _Cfg, vec<BenchResult>& _Results ) -> void
+	{
+		if(_Name.find(_Cfg.Filter) == str::npos) return;
+
+		auto Buff = vec<T>(_Size, T(0.5));
+		auto BuffD = vec<T>(_Size, T(0.001));
+		auto BuffM = vec<T>(_Size, T(0));
+		auto BuffV = vec<T>(_Size, T(0));
+
+		auto Iter = uMAX(0);
+		const auto Nanos = benchTime(_Cfg.Seconds, [&]( void ) { optimApply<T,FN_OPTIM>(T(1e-6), Iter++, _Size, Buff.data(), BuffD.data(), BuffM.data(), BuffV.data()); });
+		const auto Cost = applyCost<T,FN_OPTIM>(_Size);
+
+		_Results.push_back(BenchResult{_Name, benchTypeName<T>(), "call"s, Nanos, Cost.Flops, Cost.Bytes});
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Benchmark error over _Size outputs.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, FnErr FN_ERR> auto benchError ( const str& _Name, const uMAX _Size, const CfgBench& _Cfg, vec<BenchResult>& _Results ) -> void
+	{
+		if(_Name.find(_Cfg.Filter) == str::npos) return;
+
+		auto Real = vec<T>(_Size);
+		auto Predicted = vec<T>(_Size);
+		for(auto i = uMAX(0); i < _Size; ++i) { Real[i] = T(i % 13) * T(0.07); Predicted[i] = T(i % 7) * T(0.11); }
+
+		auto Sink = T(0);
+		const auto Nanos = benchTime(_Cfg.Seconds, [&]( void ) { Sink += error<T,FN_ERR>(_Size, Real.data(), Predicted.data()); });
+		if(Sink == T(-1)) _Results.clear(); // Keep result alive.
+
+		_Results.push_back(BenchResult{_Name, benchTypeName<T>(), "call"s, Nanos, 3 * _Size, 2 * _Size * sizeof(T)});
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Grid of layer dimensions and kernel sizes for single scalar type.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto benchSuite ( const CfgBench& _Cfg, vec<BenchResult>& _Results ) -> void
+	{
+		benchLayer<T, Dense<T, 64, 64, FnTrRelu<T>>>("Dense<64,64>"s, _Cfg, _Results);
+		benchLayer<T, Dense<T, 256, 256, FnTrRelu<T>>>("Dense<256,256>"s, _Cfg, _Results);
+		benchLayer<T, Dense<T, 1024, 256, FnTrRelu<T>>>("Dense<1024,256>"s, _Cfg, _Results);
+		benchLayer<T, Dense<T, 1024, 1024, FnTrRelu<T>>>("Dense<1024,1024>"s, _Cfg, _Results);
+
+		benchLayer<T, Conv2<T, 32, 32, 3, 8, 1>>("Conv2<32,32,3,8,1>"s, _Cfg, _Results);
+		benchLayer<T, Conv2<T, 64, 64, 8, 8, 1>>("Conv2<64,64,8,8,1>"s, _Cfg, _Results);
+		benchLayer<T, Conv2<T, 32, 32, 16, 16, 1>>("Conv2<32,32,16,16,1>"s, _Cfg, _Results);
+		benchLayer<T, Conv2<T, 32, 32, 8, 8, 2>>("Conv2<32,32,8,8,2>"s, _Cfg, _Results);
+
+		benchLayer<T, Downscale2<T, 64, 64, 8>>("Downscale2<64,64,8>"s, _Cfg, _Results);
+		benchLayer<T, Downscale2<T, 128, 128, 16>>("Downscale2<128,128,16>"s, _Cfg, _Results);
+
+		benchLayer<T, Upscale2<T, 32, 32, 8>>("Upscale2<32,32,8>"s, _Cfg, _Results);
+		benchLayer<T, Upscale2<T, 64, 64, 16>>("Upscale2<64,64,16>"s, _Cfg, _Results);
+
+		benchOptim<T, FnOptim::NONE>("optimApply<NONE,65536>"s, 65536, _Cfg, _Results);
+		benchOptim<T, FnOptim::MOMENTUM>("optimApply<MOMENTUM,65536>"s, 65536, _Cfg, _Results);
+		benchOptim<T, FnOptim::ADAM>("optimApply<ADAM,65536>"s, 65536, _Cfg, _Results);
+		benchOptim<T, FnOptim::ADAM>("optimApply<ADAM,1048576>"s, 1048576, _Cfg, _Results);
+
+		benchError<T, FnErr::MSE>("error<MSE,4096>"s, 4096, _Cfg, _Results);
+		benchError<T, FnErr::MAE>("error<MAE,4096>"s, 4096, _Cfg, _Results);
+		benchError<T, FnErr::MSE>("error<MSE,262144>"s, 262144, _Cfg, _Results);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Store results as JSON, one result per line.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto storeBench ( std::ostream& _Stream, const vec<BenchResult>& _Results ) -> void
+	{
+		_Stream << "[\n";
+		for(auto r = uMAX(0); r < _Results.size(); ++r)
+		{
+			const auto& Result = _Results[r];
+			_Stream << "  {\"name\": \"" << Result.Name << "\", \"type\": \"" << Result.Type << "\", \"op\": \"" << Result.Op << "\", \"ns\": " << Result.Nanos;
+			_Stream << ", \"flops\": " << Result.Flops << ", \"bytes\": " << Result.Bytes << ", \"gflops\": " << Result.gflops() << ", \"gbs\": " << Result.gbytes() << "}";
+			_Stream << ((r + 1 < _Results.size()) ? ",\n" : "\n");
+		}
+		_Stream << "]\n";
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Load results stored by storeBench. Lines that are not results are skipped.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto loadBench ( const str& _File ) -> vec<BenchResult>
+	{
+		auto Stream = std::ifstream(_File);
+		if(!Stream.is_open()) throw fx::Error("sx"s, "Bench"s, "loadBench"s, 0, "Failed to open baseline!"s);
+
+		const auto field = []( const str& _Line, const str& _Key ) -> str
+		{
+			const auto Pos = _Line.find("\""s + _Key + "\": "s);
+			if(Pos == str::npos) return ""s;
+
+			auto Beg = Pos + _Key.size() + 4;
+			if(_Line[Beg] == '"') return _Line.substr(Beg + 1, _Line.find('"', Beg + 1) - Beg - 1);
+			return _Line.substr(Beg, _Line.find_first_of(",}", Beg) - Beg);
+		};
+
+		auto Results = vec<BenchResult>();
+		auto Line = str();
+		while(std::getline(Stream, Line))
+		{
+			const auto Nanos = field(Line, "ns"s);
+			if(Nanos.empty()) continue;
+
+			Results.push_back(BenchResult{field(Line, "name"s), field(Line, "type"s), field(Line, "op"s), std::stod(Nanos), std::stoull(field(Line, "flops"s)), std::stoull(field(Line, "bytes"s))});
+		}
+
+		return Results;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Compare results against baseline. Prints every case and returns count of cases slower by more than _Threshold.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto compareBench ( std::ostream& _Stream, const vec<BenchResult>& _Results, const vec<BenchResult>& _Baseline, const r64 _Threshold = 0.1 ) -> uMAX
+	{
+		auto Regressions = uMAX(0);
+
+		for(const auto& Result : _Results)
+		{
+			const auto Base = std::find_if(_Baseline.begin(), _Baseline.end(), [&]( const BenchResult& _Base ) { return _Base.key() == Result.key(); });
+			if(Base == _Baseline.end()) { _Stream << "new        " << Result.key() << "\n"; continue; }
+
+			const auto Ratio = Result.Nanos / std::max(Base->Nanos, 1e-9);
+			const auto Slower = Ratio > 1.0 + _Threshold;
+			Regressions += Slower;
+
+			auto Line = std::ostringstream();
+			Line.precision(3);
+			Line << std::fixed << (Slower ? "REGRESSION " : (Ratio < 1.0 - _Threshold) ? "faster     " : "same       ") << Result.key() << " " << Base->Nanos << " ns -> " << Result.Nanos << " ns (x" << Ratio << ")\n";
+			_Stream << Line.str();
+		}
+
+		return Regressions;
+	}
+}
@@ -0,0 +1,115 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Network.hpp"
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Quantized network measured against float network it was made of.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct QuantReport
+	{
+		u64 Samples;
+		r64 MeanAbsErr; // Mean absolute difference of outputs.
+		r64 MaxAbsErr;
+		r64 Agreement; // Share of samples whose largest output is at same position.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Calibration pass. Runs up to _Count samples of cache through float network and records largest magnitude entering each layer.
+	// Ranges are front to back, one per layer. Samples hold input first, anything after it is ignored.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto quantCalibrate ( Network<T,MODE>& _Net, const vec<vec<T>>& _Samples, const uMAX _Count = 0 ) -> vec<r64>
+	{
+		_Net.connect();
+
+		auto Layers = vec<Layer<T>*>();
+		for(auto L = _Net.front(); L; L = L->front()) Layers.push_back(L);
+
+		auto Ranges = vec<r64>(Layers.size(), 0.0);
+		const auto Count = _Count ? std::min(_Count, _Samples.size()) : _Samples.size();
+
+		for(auto n = uMAX(0); n < Count; ++n)
+		{
+			_Net.exe(_Samples[n].data(), false);
+			for(auto l = uMAX(0); l < Layers.size(); ++l) Ranges[l] = std::max(Ranges[l], r64(quantMaxAbs(uMAX(Layers[l]->desc().SzIn), Layers[l]->in())));
+		}
+
+		return Ranges;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Fill network of quantized layers from float network of same shape. Quantized layers take parameters of float layer
+	// at same position, remaining layers must match it and copy its parameters. Returns false on first mismatch.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto quantizeNetwork ( Network<T,MODE>& _Quant, Network<T,MODE>& _Float, const vec<r64>& _Ranges ) -> bool
+	{
+		_Float.connect();
+
+		auto Layers = uMAX(0);
+		for(auto F = _Float.front(); F; F = F->front()) ++Layers;
+		if(_Ranges.size() < Layers) return false;
+
+		return convertNetwork(_Quant, _Float, [&]( Layer<T>* _Q, const Layer<T>* _F, const uMAX _Index ) { return _Q->quantize(_F, _Ranges[_Index]); });
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Compare outputs of quantized and float network over up to _Count samples.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto quantCompare ( Network<T,MODE>& _Float, Network<T,MODE>& _Quant, const vec<vec<T>>& _Samples, const uMAX _Count = 0 ) -> QuantReport
+	{
+		_Float.connect();
+		_Quant.connect();
+
+		auto Report = QuantReport{0, 0.0, 0.0, 0.0};
+		const auto Count = _Count ? std::min(_Count, _Samples.size()) : _Samples.size();
+		const auto SzOut = uMAX(_Float.back()->outSz());
+		auto Agree = u64(0);
+
+		for(auto n = uMAX(0); n < Count; ++n)
+		{
+			_Float.exe(_Samples[n].data(), false);
+			_Quant.exe(_Samples[n].data(), false);
+
+			const auto OutF = _Float.out(false);
+			const auto OutQ = _Quant.out(false);
+			for(auto o = uMAX(0); o < SzOut; ++o)
+			{
+				const auto Diff = std::abs(r64(OutF[o]) - r64(OutQ[o]));
+				Report.MeanAbsErr += Diff;
+				Report.MaxAbsErr = std::max(Report.MaxAbsErr, Diff);
+			}
+
+			Agree += (std::max_element(OutF, OutF + SzOut) - OutF) == (std::max_element(OutQ, OutQ + SzOut) - OutQ);
+		}
+
+		Report.Samples = Count;
+		if(Count)
+		{
+			Report.MeanAbsErr /= r64(Count * SzOut);
+			Report.Agreement = r64(Agree) / r64(Count);
+		}
+
+		return Report;
+	}
+}
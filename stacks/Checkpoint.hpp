@@ -0,0 +1,310 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Network.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto CHECKPOINT_MAGIC = u64(0x0054504B48435853); // "SXCHKPT".
+	constexpr auto CHECKPOINT_VERSION = u64(1);
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Checkpoint file header. Followed by network state.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct CheckpointHeader
+	{
+		u64 Magic;
+		u64 Version;
+		u64 SzT;
+		u64 SzState; // In Ts.
+		u64 Step;
+		NetworkInfo Info;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Build checkpoint file name.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto checkpointFile ( const str& _Prefix, const u64 _Step ) -> str
+	{
+		auto Step = std::to_string(_Step);
+		if(Step.size() < 12) Step.insert(0, 12 - Step.size(), '0');
+		return _Prefix + "."s + Step + ".sxc"s;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// List checkpoints with given prefix, oldest first.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto listCheckpoints ( const str& _Prefix ) -> vec<str>
+	{
+		namespace fs = std::filesystem;
+
+		const auto Prefix = fs::path(_Prefix);
+		const auto Dir = Prefix.has_parent_path() ? Prefix.parent_path() : fs::path(".");
+		const auto Stem = Prefix.filename().string() + "."s;
+
+		auto Files = vec<str>();
+		auto Code = std::error_code();
+		for(const auto& Entry : fs::directory_iterator(Dir, Code))
+		{
+			const auto Name = Entry.path().filename().string();
+			if((Name.size() == Stem.size() + 16) && (Name.compare(0, Stem.size(), Stem) == 0) && (Name.compare(Name.size() - 4, 4, ".sxc") == 0)) Files.push_back(Entry.path().string());
+		}
+
+		std::sort(Files.begin(), Files.end());
+		return Files;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Restore network and optimizer state from checkpoint.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto loadCheckpoint ( const str& _File, Network<T,MODE>& _Net, NetworkInfo* _Info = nullptr, u64* _Step = nullptr ) -> bool
+	{
+		auto File = std::ifstream(_File, std::ios::binary);
+		if(!File.is_open()) return false;
+
+		auto Header = CheckpointHeader();
+		File.read(reinterpret_cast<char*>(&Header), sizeof(CheckpointHeader));
+		if(!File || (Header.Magic != CHECKPOINT_MAGIC) || (Header.Version != CHECKPOINT_VERSION) || (Header.SzT != sizeof(T))) return false;
+		if(Header.SzState != _Net.bufSz(LayerBuf::STATE)) return false;
+
+		auto State = vec<T>(Header.SzState);
+		File.read(reinterpret_cast<char*>(State.data()), State.size() * sizeof(T));
+		if(!File) return false;
+
+		_Net.scatter(State.data(), LayerBuf::STATE);
+		if(_Info) *_Info = Header.Info;
+		if(_Step) *_Step = Header.Step;
+		return true;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Background checkpoint writer. snapshot() copies state into one of two buffers and returns,
+	// writer thread saves other buffer meanwhile. Files are written under temporary name and renamed once synced.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class Checkpointer
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		str Prefix;
+		uMAX Keep;
+		vec<T> States[2];
+		CheckpointHeader Headers[2];
+		iMAX Filling; // Buffer being filled by snapshot.
+		iMAX Pending; // Buffer waiting for writer.
+		iMAX Writing; // Buffer being written.
+		bool Quit;
+		bool Failed;
+		vec<str> Files;
+		std::mutex Lock;
+		std::condition_variable Wake;
+		std::thread Writer;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor. Existing checkpoints with same prefix count towards _Keep.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Checkpointer ( const str& _Prefix, const uMAX _Keep = 3 ) :
+			Prefix(_Prefix),
+			Keep(std::max(_Keep, uMAX(1))),
+			States(),
+			Headers(),
+			Filling(-1),
+			Pending(-1),
+			Writing(-1),
+			Quit(false),
+			Failed(false),
+			Files(listCheckpoints(_Prefix)),
+			Lock(),
+			Wake(),
+			Writer()
+		{
+			this->Writer = std::thread([this]( void ) { this->write(); });
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor. Finishes outstanding writes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~Checkpointer ( void )
+		{
+			this->wait();
+			{ auto Guard = std::lock_guard(this->Lock); this->Quit = true; }
+			this->Wake.notify_all();
+			this->Writer.join();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Take snapshot of network state. Newer snapshot replaces one still waiting for writer.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<CompClass MODE> auto snapshot ( Network<T,MODE>& _Net, const u64 _Step, const NetworkInfo& _Info = NetworkInfo() ) -> void
+		{
+			auto Idx = iMAX(0);
+			{
+				auto Guard = std::unique_lock(this->Lock);
+				this->Wake.wait(Guard, [&]( void ) { return this->Filling < 0; });
+
+				Idx = (this->Writing == 0) ? 1 : 0;
+				if(this->Pending == Idx) this->Pending = -1;
+				this->Filling = Idx;
+			}
+
+			auto& State = this->States[Idx];
+			State.resize(_Net.bufSz(LayerBuf::STATE));
+			_Net.gather(State.data(), LayerBuf::STATE);
+
+			auto& Header = this->Headers[Idx];
+			Header.Magic = CHECKPOINT_MAGIC;
+			Header.Version = CHECKPOINT_VERSION;
+			Header.SzT = sizeof(T);
+			Header.SzState = State.size();
+			Header.Step = _Step;
+			Header.Info = _Info;
+
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Filling = -1;
+				this->Pending = Idx;
+			}
+			this->Wake.notify_all();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Block until every snapshot is on disk. Returns false if any write failed since last call.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto wait ( void ) -> bool
+		{
+			auto Guard = std::unique_lock(this->Lock);
+			this->Wake.wait(Guard, [&]( void ) { return (this->Pending < 0) && (this->Writing < 0) && (this->Filling < 0); });
+
+			const auto Success = !this->Failed;
+			this->Failed = false;
+			return Success;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Newest checkpoint on disk.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto latest ( void ) -> str
+		{
+			auto Guard = std::lock_guard(this->Lock);
+			return this->Files.empty() ? str() : this->Files.back();
+		}
+
+		private:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Write whole buffer to descriptor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto writeAll ( const int _Fd, const void* _Data, const uMAX _Size ) -> bool
+		{
+			auto Data = static_cast<const char*>(_Data);
+			auto Left = _Size;
+
+			while(Left)
+			{
+				const auto Written = ::write(_Fd, Data, Left);
+				if(Written < 0) { if(errno == EINTR) continue; return false; }
+				Data += Written;
+				Left -= uMAX(Written);
+			}
+
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Save one buffer. Rename makes checkpoint appear only once complete.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto save ( const iMAX _Idx ) -> bool
+		{
+			const auto& Header = this->Headers[_Idx];
+			const auto& State = this->States[_Idx];
+			const auto File = checkpointFile(this->Prefix, Header.Step);
+			const auto FileTmp = File + ".tmp"s;
+
+			const auto Fd = ::open(FileTmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if(Fd < 0) return false;
+
+			auto Success = writeAll(Fd, &Header, sizeof(CheckpointHeader)) && writeAll(Fd, State.data(), State.size() * sizeof(T));
+			Success = (::fsync(Fd) == 0) && Success;
+			Success = (::close(Fd) == 0) && Success;
+			Success = Success && (std::rename(FileTmp.c_str(), File.c_str()) == 0);
+
+			if(!Success) { std::remove(FileTmp.c_str()); return false; }
+
+
+			// Rotate old checkpoints.
+			auto Remove = vec<str>();
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Files.erase(std::remove(this->Files.begin(), this->Files.end(), File), this->Files.end());
+				this->Files.push_back(File);
+				std::sort(this->Files.begin(), this->Files.end());
+
+				while(this->Files.size() > this->Keep) { Remove.push_back(this->Files.front()); this->Files.erase(this->Files.begin()); }
+			}
+
+			for(const auto& Old : Remove) std::remove(Old.c_str());
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Writer loop.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto write ( void ) -> void
+		{
+			while(true)
+			{
+				auto Idx = iMAX(-1);
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->Wake.wait(Guard, [&]( void ) { return this->Quit || (this->Pending >= 0); });
+					if(this->Pending < 0) return;
+
+					Idx = this->Pending;
+					this->Pending = -1;
+					this->Writing = Idx;
+				}
+
+				const auto Success = this->save(Idx);
+
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					this->Writing = -1;
+					if(!Success) this->Failed = true;
+				}
+				this->Wake.notify_all();
+			}
+		}
+	};
+}
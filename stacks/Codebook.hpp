@@ -0,0 +1,190 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <fx/Types.hpp>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto CODEBOOK_PAD = uMAX(8); // Rows of indices are padded to multiple of eight, which one AVX2 register decodes.
+	constexpr auto CODEBOOK_ITERS = uMAX(32); // Limit of k-means iterations, one dimensional clustering settles well before it.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Padded count and bytes of row of _Count indices of BITS.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr inline auto codebookPad ( const uMAX _Count ) -> uMAX { return ((_Count + CODEBOOK_PAD - 1) / CODEBOOK_PAD) * CODEBOOK_PAD; }
+	template<uMAX BITS> constexpr inline auto codebookBytes ( const uMAX _Count ) -> uMAX { return codebookPad(_Count) * BITS / 8; }
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Fit codebook of _Size entries to values by k-means and assign every value its nearest entry in _Idx.
+	// Entries start evenly spread between smallest and largest value, so rare large weights keep their own entries.
+	// Values are one dimensional, so clusters are runs of sorted values and every iteration is _Size searches and prefix sum differences.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto codebookFit ( const uMAX _Count, const T* _Src, const uMAX _Size, T* _Codebook, u8* _Idx ) -> void
+	{
+		auto Sorted = vec<T>(_Src, _Src + _Count);
+		std::sort(Sorted.begin(), Sorted.end());
+
+		auto Prefix = vec<r64>(_Count + 1, 0.0);
+		for(auto i = uMAX(0); i < _Count; ++i) Prefix[i + 1] = Prefix[i] + r64(Sorted[i]);
+
+		const auto Lo = _Count ? r64(Sorted.front()) : 0.0;
+		const auto Hi = _Count ? r64(Sorted.back()) : 0.0;
+
+		auto Centers = vec<r64>(_Size);
+		for(auto k = uMAX(0); k < _Size; ++k) Centers[k] = Lo + (Hi - Lo) * (r64(k) + 0.5) / r64(_Size);
+
+		// Midpoints between neighbouring entries split values between them.
+		auto Mids = vec<T>(_Size - 1);
+		const auto split = [&]( void ) { for(auto k = uMAX(1); k < _Size; ++k) Mids[k - 1] = T(0.5 * (Centers[k - 1] + Centers[k])); };
+
+		for(auto It = uMAX(0); It < CODEBOOK_ITERS; ++It)
+		{
+			split();
+
+			auto Moved = false;
+			auto Beg = uMAX(0);
+
+			for(auto k = uMAX(0); k < _Size; ++k)
+			{
+				const auto End = (k + 1 < _Size) ? uMAX(std::lower_bound(Sorted.begin(), Sorted.end(), Mids[k]) - Sorted.begin()) : _Count;
+				if(End > Beg)
+				{
+					const auto Center = (Prefix[End] - Prefix[Beg]) / r64(End - Beg);
+					Moved |= (T(Center) != T(Centers[k]));
+					Centers[k] = Center;
+				}
+
+				Beg = std::max(Beg, End);
+			}
+
+			std::sort(Centers.begin(), Centers.end());
+			if(!Moved) break;
+		}
+
+		split();
+		for(auto k = uMAX(0); k < _Size; ++k) _Codebook[k] = T(Centers[k]);
+		for(auto i = uMAX(0); i < _Count; ++i) _Idx[i] = u8(std::upper_bound(Mids.begin(), Mids.end(), _Src[i]) - Mids.begin());
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Pack _Count indices to row of BITS. Four bit indices go two per byte, lower one to low nibble. Padding is zero.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX BITS> auto codebookPack ( const uMAX _Count, const u8* _Idx, u8* _Row ) -> void
+	{
+		std::memset(_Row, 0, codebookBytes<BITS>(_Count));
+
+		if constexpr(BITS == 8) std::memcpy(_Row, _Idx, _Count);
+		else for(auto i = uMAX(0); i < _Count; ++i) _Row[i / 2] |= u8((_Idx[i] & 15) << ((i & 1) * 4));
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Index at position _I of packed row.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX BITS> inline auto codebookAt ( const u8* _Row, const uMAX _I ) -> u32
+	{
+		if constexpr(BITS == 8) return _Row[_I];
+		else return (_Row[_I / 2] >> ((_I & 1) * 4)) & 15;
+	}
+
+
+	#if defined(__AVX2__)
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Decode eight entries at position _I of packed row. Sixteen entry codebook sits in two registers and is picked by permutes,
+	// larger one is gathered from L1.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX BITS> inline auto codebookLoad8 ( const u8* _Row, const uMAX _I, const r32* _Codebook, const __m256 _Lo, const __m256 _Hi ) -> __m256
+	{
+		if constexpr(BITS == 8)
+		{
+			const auto Idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(_Row + _I)));
+			return _mm256_i32gather_ps(_Codebook, Idx, 4);
+		}
+
+		else
+		{
+			auto Word = u32(0);
+			std::memcpy(&Word, _Row + _I / 2, sizeof(u32));
+
+			const auto Idx = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(i32(Word)), _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28)), _mm256_set1_epi32(15));
+			return _mm256_blendv_ps(_mm256_permutevar8x32_ps(_Lo, Idx), _mm256_permutevar8x32_ps(_Hi, Idx), _mm256_castsi256_ps(_mm256_slli_epi32(Idx, 28)));
+		}
+	}
+	#endif
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Dot product of _X with packed row decoded through codebook. Weights are decoded in registers and never written out.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX BITS, class T> auto codebookDot ( const uMAX _Count, const T* _X, const u8* _Row, const T* _Codebook ) -> T
+	{
+		auto i = uMAX(0);
+		auto Sum = T(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T,r32>)
+		{
+			const auto Lo = (BITS == 4) ? _mm256_loadu_ps(_Codebook) : _mm256_setzero_ps();
+			const auto Hi = (BITS == 4) ? _mm256_loadu_ps(_Codebook + 8) : _mm256_setzero_ps();
+
+			auto Acc = _mm256_setzero_ps();
+			for(; i + 8 <= _Count; i += 8) Acc = _mm256_add_ps(Acc, _mm256_mul_ps(_mm256_loadu_ps(_X + i), codebookLoad8<BITS>(_Row, i, _Codebook, Lo, Hi)));
+
+			alignas(32) r32 Lanes[8];
+			_mm256_store_ps(Lanes, Acc);
+			for(auto l = 0; l < 8; ++l) Sum += Lanes[l];
+		}
+		#endif
+
+		for(; i < _Count; ++i) Sum += _X[i] * _Codebook[codebookAt<BITS>(_Row, i)];
+		return Sum;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Decode _Count weights of packed row to _Dst.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX BITS, class T> auto codebookDecode ( const uMAX _Count, const u8* _Row, const T* _Codebook, T* _Dst ) -> void
+	{
+		auto i = uMAX(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T,r32>)
+		{
+			const auto Lo = (BITS == 4) ? _mm256_loadu_ps(_Codebook) : _mm256_setzero_ps();
+			const auto Hi = (BITS == 4) ? _mm256_loadu_ps(_Codebook + 8) : _mm256_setzero_ps();
+			for(; i + 8 <= _Count; i += 8) _mm256_storeu_ps(_Dst + i, codebookLoad8<BITS>(_Row, i, _Codebook, Lo, Hi));
+		}
+		#endif
+
+		for(; i < _Count; ++i) _Dst[i] = _Codebook[codebookAt<BITS>(_Row, i)];
+	}
+}
@@ -0,0 +1,81 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Network.hpp"
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Gradual pruning. Sparsity rises from zero at Begin to Final at End along cubic curve, fast early while weights are redundant
+	// and slow near end. Layers are pruned every Every iterations in between.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct PruneSchedule
+	{
+		u64 Begin;
+		u64 End;
+		u64 Every;
+		r64 Final;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Target sparsity of schedule at iteration _Iter.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto pruneSparsity ( const PruneSchedule& _Schedule, const u64 _Iter ) -> r64
+	{
+		if(_Iter <= _Schedule.Begin) return 0.0;
+		if(_Iter >= _Schedule.End) return _Schedule.Final;
+
+		const auto Left = 1.0 - r64(_Iter - _Schedule.Begin) / r64(_Schedule.End - _Schedule.Begin);
+		return _Schedule.Final * (1.0 - Left * Left * Left);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Prune every layer of network with own weights to _Sparsity. Returns count of pruned layers.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto pruneNetwork ( Network<T,MODE>& _Net, const r64 _Sparsity ) -> uMAX
+	{
+		_Net.connect();
+
+		auto Count = uMAX(0);
+		for(auto L = _Net.front(); L; L = L->front()) Count += L->prune(_Sparsity);
+		return Count;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Step of gradual pruning, call once per iteration after apply. Returns true when network was pruned.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto pruneStep ( Network<T,MODE>& _Net, const PruneSchedule& _Schedule, const u64 _Iter ) -> bool
+	{
+		if((_Iter < _Schedule.Begin) || (_Iter > _Schedule.End) || !_Schedule.Every || ((_Iter - _Schedule.Begin) % _Schedule.Every)) return false;
+		return pruneNetwork(_Net, pruneSparsity(_Schedule, _Iter)) > 0;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Fill network of compressed layers from float network of same shape. Compressed layers take parameters of float layer
+	// at same position, remaining layers must match it and copy its parameters. Returns false on first mismatch.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto compressNetwork ( Network<T,MODE>& _Compressed, Network<T,MODE>& _Float ) -> bool
+	{
+		return convertNetwork(_Compressed, _Float, []( Layer<T>* _C, const Layer<T>* _F, const uMAX ) { return _C->compress(_F); });
+	}
+}
@@ -0,0 +1,348 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <fx/Types.hpp>
+#include <fx/Vops.hpp>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+#if defined(__AVX2__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Convert float to IEEE half precision bits. Rounds to nearest even.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto halfFromFloat ( const r32 _Value ) -> u16
+	{
+		auto Bits = u32(0);
+		std::memcpy(&Bits, &_Value, sizeof(u32));
+
+		const auto Sign = u32((Bits >> 16) & 0x8000);
+		const auto Abs = u32(Bits & 0x7FFFFFFF);
+
+		if(Abs >= 0x7F800000) return u16(Sign | ((Abs > 0x7F800000) ? 0x7E00 : 0x7C00)); // Nan or infinity.
+		if(Abs >= 0x477FF000) return u16(Sign | 0x7C00); // Overflow.
+
+		// Subnormal. Scale so unit is smallest subnormal and let rounding mode do rest.
+		if(Abs < 0x38800000)
+		{
+			auto Small = r32(0);
+			std::memcpy(&Small, &Abs, sizeof(r32));
+			return u16(Sign | u32(std::nearbyint(Small * 16777216.0f)));
+		}
+
+		// Normal. Rebias exponent and round mantissa.
+		return u16(Sign | ((Abs - 0x38000000 + 0xFFF + ((Abs >> 13) & 1)) >> 13));
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Convert IEEE half precision bits to float. Exact.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto halfToFloat ( const u16 _Half ) -> r32
+	{
+		const auto Sign = u32(_Half & 0x8000) << 16;
+		const auto Exp = u32(_Half >> 10) & 0x1F;
+		const auto Mant = u32(_Half & 0x3FF);
+
+		if(Exp == 0)
+		{
+			const auto Value = r32(Mant) * (1.0f / 16777216.0f);
+			return Sign ? -Value : Value;
+		}
+
+		const auto Bits = (Exp == 31) ? (Sign | 0x7F800000 | (Mant << 13)) : (Sign | ((Exp + 112) << 23) | (Mant << 13));
+		auto Value = r32(0);
+		std::memcpy(&Value, &Bits, sizeof(r32));
+		return Value;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Convert float to bfloat16 bits, upper half of float. Rounds to nearest even, nan stays quiet nan.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto bf16FromFloat ( const r32 _Value ) -> u16
+	{
+		auto Bits = u32(0);
+		std::memcpy(&Bits, &_Value, sizeof(u32));
+
+		if((Bits & 0x7FFFFFFF) > 0x7F800000) return u16((Bits >> 16) | 0x40);
+		return u16((Bits + 0x7FFF + ((Bits >> 16) & 1)) >> 16);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Convert bfloat16 bits to float. Exact.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto bf16ToFloat ( const u16 _Half ) -> r32
+	{
+		const auto Bits = u32(_Half) << 16;
+		auto Value = r32(0);
+		std::memcpy(&Value, &Bits, sizeof(r32));
+		return Value;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Widen bytes to T. _Dst[i] = _Src[i] * _Scale + _Offset.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto widenU8 ( const uMAX _Count, const u8* _Src, T* _Dst, const r64 _Scale, const r64 _Offset ) -> void
+	{
+		auto i = uMAX(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T,r32>)
+		{
+			const auto Scale = _mm256_set1_ps(r32(_Scale));
+			const auto Offset = _mm256_set1_ps(r32(_Offset));
+
+			for(; i + 8 <= _Count; i += 8)
+			{
+				const auto Wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(_Src + i)));
+				_mm256_storeu_ps(_Dst + i, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(Wide), Scale), Offset));
+			}
+		}
+		#endif
+
+		const auto Scale = T(_Scale);
+		const auto Offset = T(_Offset);
+		for(; i < _Count; ++i) _Dst[i] = T(_Src[i]) * Scale + Offset;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Widen half floats to T. _Dst[i] = _Src[i] * _Scale + _Offset.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto widenF16 ( const uMAX _Count, const u16* _Src, T* _Dst, const r64 _Scale, const r64 _Offset ) -> void
+	{
+		auto i = uMAX(0);
+
+		#if defined(__F16C__) && defined(__AVX__)
+		if constexpr(std::is_same_v<T,r32>)
+		{
+			const auto Scale = _mm256_set1_ps(r32(_Scale));
+			const auto Offset = _mm256_set1_ps(r32(_Offset));
+
+			for(; i + 8 <= _Count; i += 8)
+			{
+				const auto Wide = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_Src + i)));
+				_mm256_storeu_ps(_Dst + i, _mm256_add_ps(_mm256_mul_ps(Wide, Scale), Offset));
+			}
+		}
+		#endif
+
+		const auto Scale = T(_Scale);
+		const auto Offset = T(_Offset);
+		for(; i < _Count; ++i) _Dst[i] = T(halfToFloat(_Src[i])) * Scale + Offset;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Quantize T to bytes. Inverse of widenU8, saturates outside of representable range.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto narrowU8 ( const uMAX _Count, const T* _Src, u8* _Dst, const r64 _Scale, const r64 _Offset ) -> void
+	{
+		for(auto i = uMAX(0); i < _Count; ++i) _Dst[i] = u8(std::clamp(std::nearbyint((r64(_Src[i]) - _Offset) / _Scale), 0.0, 255.0));
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Quantize T to half floats. Inverse of widenF16.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto narrowF16 ( const uMAX _Count, const T* _Src, u16* _Dst, const r64 _Scale, const r64 _Offset ) -> void
+	{
+		for(auto i = uMAX(0); i < _Count; ++i) _Dst[i] = halfFromFloat(r32((r64(_Src[i]) - _Offset) / _Scale));
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Reduced precision storage formats of layer parameters and activations. Arithmetic always happens in T, only what is kept in memory is narrowed.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class FnStore
+	{
+		FP32, // Same as T.
+		F16, // IEEE half, 10 bit mantissa, range up to 65504.
+		BF16 // Upper half of float, 7 bit mantissa, range of float.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Stored type of format.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<FnStore FN_STORE, class T> using StoreT = std::conditional_t<FN_STORE == FnStore::FP32, T, u16>;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Narrow and widen single value.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<FnStore FN_STORE, class T> inline auto storeNarrow ( const T _Value ) -> StoreT<FN_STORE,T>
+	{
+		if constexpr(FN_STORE == FnStore::F16) return halfFromFloat(r32(_Value));
+		else if constexpr(FN_STORE == FnStore::BF16) return bf16FromFloat(r32(_Value));
+		else return _Value;
+	}
+
+	template<FnStore FN_STORE, class T> inline auto storeWiden ( const StoreT<FN_STORE,T> _Value ) -> T
+	{
+		if constexpr(FN_STORE == FnStore::F16) return T(halfToFloat(_Value));
+		else if constexpr(FN_STORE == FnStore::BF16) return T(bf16ToFloat(_Value));
+		else return _Value;
+	}
+
+
+	#if defined(__AVX2__)
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Eight stored values widened to floats. F16 needs F16C, without it they go through scalar conversion.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<FnStore FN_STORE> inline auto storeLoad8 ( const u16* _Src ) -> __m256
+	{
+		const auto Raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_Src));
+
+		if constexpr(FN_STORE == FnStore::BF16) return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(Raw), 16));
+		else
+		{
+			#if defined(__F16C__)
+			return _mm256_cvtph_ps(Raw);
+			#else
+			alignas(32) r32 Wide[8];
+			for(auto i = 0; i < 8; ++i) Wide[i] = halfToFloat(_Src[i]);
+			return _mm256_load_ps(Wide);
+			#endif
+		}
+	}
+	#endif
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Narrow array of T into storage format.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<FnStore FN_STORE, class T> auto storeNarrow ( const uMAX _Count, const T* _Src, StoreT<FN_STORE,T>* _Dst ) -> void
+	{
+		if constexpr(FN_STORE == FnStore::FP32) { memCopy(_Count, _Dst, _Src); return; }
+		else
+		{
+			auto i = uMAX(0);
+
+			#if defined(__AVX2__)
+			if constexpr(std::is_same_v<T,r32> && (FN_STORE == FnStore::BF16))
+			{
+				const auto Round = _mm256_set1_epi32(0x7FFF);
+				const auto One = _mm256_set1_epi32(1);
+				const auto narrow = [&]( const uMAX _At )
+				{
+					const auto Value = _mm256_loadu_ps(_Src + _At);
+					const auto Bits = _mm256_castps_si256(Value);
+					const auto Rounded = _mm256_srli_epi32(_mm256_add_epi32(Bits, _mm256_add_epi32(Round, _mm256_and_si256(_mm256_srli_epi32(Bits, 16), One))), 16);
+					const auto Nan = _mm256_or_si256(_mm256_srli_epi32(Bits, 16), _mm256_set1_epi32(0x40));
+					return _mm256_blendv_epi8(Rounded, Nan, _mm256_castps_si256(_mm256_cmp_ps(Value, Value, _CMP_UNORD_Q)));
+				};
+
+				for(; i + 16 <= _Count; i += 16) _mm256_storeu_si256(reinterpret_cast<__m256i*>(_Dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi32(narrow(i), narrow(i + 8)), 0xD8));
+			}
+			#endif
+
+			#if defined(__F16C__) && defined(__AVX__)
+			if constexpr(std::is_same_v<T,r32> && (FN_STORE == FnStore::F16))
+			{
+				for(; i + 8 <= _Count; i += 8) _mm_storeu_si128(reinterpret_cast<__m128i*>(_Dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(_Src + i), _MM_FROUND_TO_NEAREST_INT));
+			}
+			#endif
+
+			for(; i < _Count; ++i) _Dst[i] = storeNarrow<FN_STORE>(_Src[i]);
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Widen stored array into T.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<FnStore FN_STORE, class T> auto storeWiden ( const uMAX _Count, const StoreT<FN_STORE,T>* _Src, T* _Dst ) -> void
+	{
+		if constexpr(FN_STORE == FnStore::FP32) { memCopy(_Count, _Dst, _Src); return; }
+		else
+		{
+			auto i = uMAX(0);
+
+			#if defined(__AVX2__)
+			if constexpr(std::is_same_v<T,r32>) for(; i + 8 <= _Count; i += 8) _mm256_storeu_ps(_Dst + i, storeLoad8<FN_STORE>(_Src + i));
+			#endif
+
+			for(; i < _Count; ++i) _Dst[i] = storeWiden<FN_STORE,T>(_Src[i]);
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Dot product of T vector with stored vector, accumulated in T.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<FnStore FN_STORE, class T> auto storeDot ( const uMAX _Count, const T* _X, const StoreT<FN_STORE,T>* _W ) -> T
+	{
+		if constexpr(FN_STORE == FnStore::FP32) return std::inner_product(_X, _X + _Count, _W, T(0));
+		else
+		{
+			auto i = uMAX(0);
+			auto Sum = T(0);
+
+			#if defined(__AVX2__)
+			if constexpr(std::is_same_v<T,r32>)
+			{
+				auto Acc0 = _mm256_setzero_ps(), Acc1 = _mm256_setzero_ps();
+				for(; i + 16 <= _Count; i += 16)
+				{
+					Acc0 = _mm256_add_ps(Acc0, _mm256_mul_ps(_mm256_loadu_ps(_X + i), storeLoad8<FN_STORE>(_W + i)));
+					Acc1 = _mm256_add_ps(Acc1, _mm256_mul_ps(_mm256_loadu_ps(_X + i + 8), storeLoad8<FN_STORE>(_W + i + 8)));
+				}
+
+				alignas(32) r32 Lanes[8];
+				_mm256_store_ps(Lanes, _mm256_add_ps(Acc0, Acc1));
+				for(auto l = 0; l < 8; ++l) Sum += Lanes[l];
+			}
+			#endif
+
+			for(; i < _Count; ++i) Sum += _X[i] * storeWiden<FN_STORE,T>(_W[i]);
+			return Sum;
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Accumulate stored vector times constant into T. _Out[i] += _W[i] * _Const.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<FnStore FN_STORE, class T> auto storeAxpy ( const uMAX _Count, T* _Out, const StoreT<FN_STORE,T>* _W, const T _Const ) -> void
+	{
+		if constexpr(FN_STORE == FnStore::FP32) { vops::mulVecByConstAddToOut(_Count, _Out, _W, _Const); return; }
+		else
+		{
+			auto i = uMAX(0);
+
+			#if defined(__AVX2__)
+			if constexpr(std::is_same_v<T,r32>)
+			{
+				const auto Const = _mm256_set1_ps(_Const);
+				for(; i + 8 <= _Count; i += 8) _mm256_storeu_ps(_Out + i, _mm256_add_ps(_mm256_loadu_ps(_Out + i), _mm256_mul_ps(storeLoad8<FN_STORE>(_W + i), Const)));
+			}
+			#endif
+
+			for(; i < _Count; ++i) _Out[i] += storeWiden<FN_STORE,T>(_W[i]) * _Const;
+		}
+	}
+}
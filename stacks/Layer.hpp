@@ -9,9 +9,17 @@
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include "./Error.hpp"
 #include "./Transfer.hpp"
+#include "./Threads.hpp"
 #include "./Optimizer.hpp"
+#include "./Profile.hpp"
+#include "./Quant.hpp"
+#include "./Convert.hpp"
+#include "./Sparse.hpp"
+#include "./Svd.hpp"
+#include "./Codebook.hpp"
 
 #include "./layer/data/Outputs.hpp"
+#include "./layer/data/Batch.hpp"
 #include "./layer/data/Weights.hpp"
 #include "./layer/data/Biases.hpp"
 
@@ -46,23 +54,137 @@ namespace sx
 	#define SX_FNSIG_LAYER_STORE auto store ( std::ostream& _Stream, const bool _Chain = true ) const -> void
 	#define SX_FNSIG_LAYER_LOAD auto load ( std::istream& _Stream, const bool _Chain = true ) -> void
 	#define SX_FNSIG_LAYER_EXCHANGE auto exchange ( Layer<T>* _Master, const bool _Chain = true ) -> void
+	#define SX_FNSIG_LAYER_BUFSZ auto bufSz ( const LayerBuf _Buf, const bool _Chain = true ) const -> uMAX
+	#define SX_FNSIG_LAYER_GATHER auto gather ( T* _Dst, const LayerBuf _Buf, const bool _Chain = true ) const -> T*
+	#define SX_FNSIG_LAYER_SCATTER auto scatter ( const T* _Src, const LayerBuf _Buf, const bool _Chain = true ) -> const T*
+	#define SX_FNSIG_LAYER_DESC auto desc ( void ) const -> LayerDesc
+	#define SX_FNSIG_LAYER_BIND auto bind ( const T* _Weights, const T* _Biases ) -> void
+	#define SX_FNSIG_LAYER_COST auto cost ( const LayerOp _Op ) const -> LayerCost
+	#define SX_FNSIG_LAYER_NORMS auto norms ( void ) const -> LayerNorms
+	#define SX_FNSIG_LAYER_QUANTIZE auto quantize ( const Layer<T>* _Source, const r64 _Range ) -> bool
+	#define SX_FNSIG_LAYER_PRUNE auto prune ( const r64 _Sparsity ) -> bool
+	#define SX_FNSIG_LAYER_COMPRESS auto compress ( const Layer<T>* _Source ) -> bool
+	#define SX_FNSIG_LAYER_UNLOCK auto unlock ( void ) -> void
+	#define SX_FNSIG_LAYER_OUT_BATCH auto outBatch ( void ) const -> const T*
+	#define SX_FNSIG_LAYER_GRAD_BATCH auto gradientBatch ( void ) const -> const T*
+	#define SX_FNSIG_LAYER_EXE_BATCH auto exeBatch ( const uMAX _Count, const bool _Chain = true ) -> void
+	#define SX_FNSIG_LAYER_ERR_BATCH auto errBatch ( const T* _Target, const uMAX _Stride, const uMAX _Count ) -> T
+	#define SX_FNSIG_LAYER_FIT_BATCH auto fitBatch ( const T* _Target, const uMAX _Stride, const uMAX _Count, const rMAX _ErrParam, const bool _Chain = true ) -> void
 	
 	// Macros for chained function calls.
-	#define SX_MC_LAYER_NEXT_EXE if(this->Front && _Chain) this->Front->exe()
+	#define SX_MC_LAYER_NEXT_EXE if(this->Front && _Chain) SX_MC_PROFILE(this->Front, LayerOp::EXE, this->Front->exe())
 	#define SX_MC_LAYER_NEXT_RESET if(this->Front && _Chain) this->Front->reset()
-	#define SX_MC_LAYER_NEXT_FIT if(this->Back && _Chain) this->Back->fit(nullptr, _ErrParam)
-	#define SX_MC_LAYER_NEXT_APPLY if(this->Front && _Chain) this->Front->apply(_Rate, _Iter)
+	#define SX_MC_LAYER_NEXT_FIT if(this->Back && _Chain) SX_MC_PROFILE(this->Back, LayerOp::FIT, this->Back->fit(nullptr, _ErrParam))
+	#define SX_MC_LAYER_NEXT_APPLY if(this->Front && _Chain) SX_MC_PROFILE(this->Front, LayerOp::APPLY, this->Front->apply(_Rate, _Iter))
 	#define SX_MC_LAYER_NEXT_STORE if(this->Front && _Chain) this->Front->store(_Stream)
 	#define SX_MC_LAYER_NEXT_LOAD if(this->Front && _Chain) this->Front->load(_Stream)
+	#define SX_MC_LAYER_NEXT_BUFSZ if(this->Front && _Chain) return this->Front->bufSz(_Buf); else return 0
+	#define SX_MC_LAYER_NEXT_GATHER if(this->Front && _Chain) return this->Front->gather(_Dst, _Buf); else return _Dst
+	#define SX_MC_LAYER_NEXT_SCATTER if(this->Front && _Chain) return this->Front->scatter(_Src, _Buf); else return _Src
+	#define SX_MC_LAYER_NEXT_EXE_BATCH if(this->Front && _Chain) { this->Front->setInputBatch(this->outBatch(), this->outSz()); SX_MC_PROFILE_BATCH(this->Front, LayerOp::EXE_BATCH, _Count, this->Front->exeBatch(_Count)); }
+	#define SX_MC_LAYER_NEXT_FIT_BATCH if(this->Back && _Chain) SX_MC_PROFILE_BATCH(this->Back, LayerOp::FIT_BATCH, _Count, this->Back->fitBatch(nullptr, 0, _Count, _ErrParam))
 
 	// Generate code for trivial functions.
 	#define SX_MC_LAYER_TRIVIAL(CLASS_NAME, SZ_OUT, PTR_OUT, PTR_GRAD) public: ~CLASS_NAME ( void ) final {} constexpr SX_FNSIG_LAYER_OUTSZ final { return SZ_OUT; } constexpr SX_FNSIG_LAYER_OUTSZBT final { return SZ_OUT * sizeof(T); } constexpr SX_FNSIG_LAYER_OUT final { return PTR_OUT; } constexpr SX_FNSIG_LAYER_GRAD final { return PTR_GRAD; }
+	#define SX_MC_LAYER_TRIVIAL_BATCH(PTR_OUT, PTR_GRAD) public: SX_FNSIG_LAYER_OUT_BATCH final { return PTR_OUT; } SX_FNSIG_LAYER_GRAD_BATCH final { return PTR_GRAD; }
 
 	// Generate code common derivatives.
 	#define SX_MC_LAYER_DER_ERR auto DerErr = T(0); if(this->Front) DerErr = this->Front->gradient()[o]; else DerErr += errorDer<T,FN_ERR>(_Target[o], this->OutTrans[o])
 	#define SX_MC_LAYER_DER_TRANS auto ValRaw = T(); if constexpr(needRaw<T,FN_TRANS>()) ValRaw = this->OutRaw[o]; auto DerTrans = transferDer<T,FN_TRANS>(this->OutTrans[o], ValRaw) * DerErr; DerTrans = std::clamp(DerTrans, T(-1), T(1))
 	
 
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Layer buffers that can be moved in and out as flat arrays.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class LayerBuf
+	{
+		PARAMS, // Weights followed by biases.
+		DELTAS, // Weights deltas followed by biases deltas.
+		STATE // Everything needed to resume training: iteration counter, parameters and optimizer buffers.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Layer types.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class LayerType : u64
+	{
+		NONE,
+		ERROR,
+		ERROR_CONV2,
+		DENSE,
+		CONV2,
+		DOWNSCALE2,
+		UPSCALE2,
+		DENSE_Q8,
+		CONV2_Q8,
+		DENSE_SPARSE,
+		DENSE_LOW_RANK,
+		DENSE_CODEBOOK
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Name of layer type.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto layerTypeName ( const LayerType _Type ) -> const char*
+	{
+		switch(_Type)
+		{
+			case LayerType::ERROR: return "Error";
+			case LayerType::ERROR_CONV2: return "ErrorConv2";
+			case LayerType::DENSE: return "Dense";
+			case LayerType::CONV2: return "Conv2";
+			case LayerType::DOWNSCALE2: return "Downscale2";
+			case LayerType::UPSCALE2: return "Upscale2";
+			case LayerType::DENSE_Q8: return "DenseQ8";
+			case LayerType::CONV2_Q8: return "Conv2Q8";
+			case LayerType::DENSE_SPARSE: return "DenseSparse";
+			case LayerType::DENSE_LOW_RANK: return "DenseLowRank";
+			case LayerType::DENSE_CODEBOOK: return "DenseCodebook";
+			default: return "None";
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Layer description.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct LayerDesc
+	{
+		LayerType Type;
+		u64 SzIn; // Input size in Ts.
+		u64 SzOut; // Output size in Ts.
+		u64 SzWeights; // Weights size in Ts.
+		u64 SzBiases; // Biases size in Ts.
+
+		constexpr auto operator== ( const LayerDesc& _Other ) const -> bool
+		{
+			return (this->Type == _Other.Type) && (this->SzIn == _Other.SzIn) && (this->SzOut == _Other.SzOut) && (this->SzWeights == _Other.SzWeights) && (this->SzBiases == _Other.SzBiases);
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Euclidean norms of layer parameters and of accumulated deltas.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct LayerNorms
+	{
+		rMAX Params;
+		rMAX Deltas;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Cost of optimizer step over _Params parameters. Parameters, deltas and optimizer buffers are read and written.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, FnOptim FN_OPTIM> constexpr inline auto applyCost ( const uMAX _Params ) -> LayerCost
+	{
+		const auto Buffers = uMAX(2) + uMAX(needBufM<T,FN_OPTIM>()) + uMAX(needBufV<T,FN_OPTIM>());
+		return LayerCost{optimCost<T,FN_OPTIM>() * _Params, Buffers * 2 * sizeof(T) * _Params};
+	}
+
+
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	// Layer interface.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -75,13 +197,18 @@ namespace sx
 		Layer* Back;
 		Layer* Front;
 		const T* Input;
+		const T* InputBatch; // Batch input, sample n starts at InputBatch + n * InputStride.
+		uMAX InputStride;
 		bool IsLocked;
 		public:
+		#if defined(SX_PROFILE)
+		LayerProfile Prof; // Measurements, filled by profiled calls.
+		#endif
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Functions.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		Layer ( void ) : Front(nullptr), Back(nullptr), Input(nullptr), IsLocked(false) {}
+		Layer ( void ) : Front(nullptr), Back(nullptr), Input(nullptr), InputBatch(nullptr), InputStride(0), IsLocked(false) {}
 		virtual ~Layer ( void ) {}
 
 		virtual SX_FNSIG_LAYER_OUTSZ = 0; // Get output size in Ts.
@@ -94,14 +221,30 @@ namespace sx
 
 		virtual SX_FNSIG_LAYER_ERR { return 0; } // Get output error in respect to argument.
 		virtual SX_FNSIG_LAYER_RESET { if(this->Front) this->Front->reset(); } // Reset delta parameters.
-		virtual SX_FNSIG_LAYER_APPLY { if(this->Front) this->Front->apply(_Rate, _Iter); } // Apply optimizations and update parameters.
+		virtual SX_FNSIG_LAYER_APPLY { if(this->Front) SX_MC_PROFILE(this->Front, LayerOp::APPLY, this->Front->apply(_Rate, _Iter)); } // Apply optimizations and update parameters.
 		virtual SX_FNSIG_LAYER_STORE { if(this->Front) this->Front->store(_Stream); } // Store parameters to stream.
 		virtual SX_FNSIG_LAYER_LOAD { if(this->Front) this->Front->load(_Stream); } // Load parameters from stream.
 		virtual SX_FNSIG_LAYER_EXCHANGE = 0; // Multi threading utility.
+		virtual SX_FNSIG_LAYER_BUFSZ { SX_MC_LAYER_NEXT_BUFSZ; } // Get size of flat buffer in Ts.
+		virtual SX_FNSIG_LAYER_GATHER { SX_MC_LAYER_NEXT_GATHER; } // Copy buffer out to flat array. Returns end of written data.
+		virtual SX_FNSIG_LAYER_SCATTER { SX_MC_LAYER_NEXT_SCATTER; } // Copy buffer in from flat array. Returns end of read data.
+		virtual SX_FNSIG_LAYER_DESC = 0; // Describe type and sizes.
+		virtual SX_FNSIG_LAYER_BIND { return; } // Execute with external read only parameters. Nullptr returns to own buffers.
+		virtual SX_FNSIG_LAYER_COST { return LayerCost{0, 0}; } // Work of single call of operation.
+		virtual SX_FNSIG_LAYER_NORMS { return LayerNorms{0, 0}; } // Norms of parameters and deltas.
+		virtual SX_FNSIG_LAYER_QUANTIZE { return false; } // Take parameters of float layer, whose input spans [-_Range, _Range]. False unless layer is quantized counterpart of _Source.
+		virtual SX_FNSIG_LAYER_PRUNE { return false; } // Zero smallest weights so _Sparsity share of them is zero and keep them zero while training. False if layer has no own weights.
+		virtual SX_FNSIG_LAYER_COMPRESS { return false; } // Take parameters of float layer. False unless layer is compressed counterpart of _Source.
+
+		virtual SX_FNSIG_LAYER_OUT_BATCH = 0; // Get batch output buffer pointer, laid out as [N][outSz()].
+		virtual SX_FNSIG_LAYER_GRAD_BATCH = 0; // Get batch gradient buffer pointer, laid out as [N][input size].
+		virtual SX_FNSIG_LAYER_EXE_BATCH = 0; // Execute _Count samples of batch input.
+		virtual SX_FNSIG_LAYER_FIT_BATCH = 0; // Backpropagate _Count samples, deltas are accumulated over all of them.
+		virtual SX_FNSIG_LAYER_ERR_BATCH { return 0; } // Get mean output error of batch in respect to arguments.
 
 		inline auto in ( void ) -> const T* { return this->Input; }
 		inline auto lock ( void ) -> void { this->IsLocked = true; }
-		inline auto unlock ( void ) -> void { this->IsLocked = false; }
+		virtual SX_FNSIG_LAYER_UNLOCK { this->IsLocked = false; } // Allow training of parameters.
 		inline auto back ( void ) -> Layer* { return this->Back; }
 		inline auto front ( void ) -> Layer* { return this->Front; }
 		inline auto back ( void ) const -> const Layer* { return this->Back; }
@@ -109,5 +252,7 @@ namespace sx
 		inline auto setBack ( Layer* _Back ) -> void { this->Back = _Back; if(_Back) { this->Input = _Back->out(); _Back->setFront(this); } }
 		inline auto setFront ( Layer* _Front ) -> void { this->Front = _Front; }
 		inline auto setInput ( const T* _Input ) -> const T* { const auto InputLast = this->Input; if(_Input) this->Input = _Input; return InputLast; }
+		inline auto setInputBatch ( const T* _Input, const uMAX _Stride ) -> void { this->InputBatch = _Input; this->InputStride = _Stride; }
+		inline auto inBatch ( const uMAX _Index ) const -> const T* { return this->InputBatch + _Index * this->InputStride; }
 	};
 }
@@ -0,0 +1,108 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Read only memory mapped file. Pages are shared with every other process mapping same file.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class FileMap
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		u8* Data;
+		uMAX Size;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		FileMap ( void ) : Data(nullptr), Size(0) {}
+		FileMap ( const str& _File ) : Data(nullptr), Size(0) { this->open(_File); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~FileMap ( void ) { this->close(); }
+
+		FileMap ( const FileMap& ) = delete;
+		auto operator= ( const FileMap& ) -> FileMap& = delete;
+		FileMap ( FileMap&& _Other ) : Data(_Other.Data), Size(_Other.Size) { _Other.Data = nullptr; _Other.Size = 0; }
+		auto operator= ( FileMap&& _Other ) -> FileMap& { if(this != &_Other) { this->close(); std::swap(this->Data, _Other.Data); std::swap(this->Size, _Other.Size); } return *this; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Map file.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto open ( const str& _File ) -> bool
+		{
+			this->close();
+
+			const auto Fd = ::open(_File.c_str(), O_RDONLY);
+			if(Fd < 0) return false;
+
+			struct stat Stat;
+			if((fstat(Fd, &Stat) != 0) || (Stat.st_size <= 0)) { ::close(Fd); return false; }
+
+			const auto Mem = mmap(nullptr, uMAX(Stat.st_size), PROT_READ, MAP_SHARED, Fd, 0);
+			::close(Fd);
+			if(Mem == MAP_FAILED) return false;
+
+			this->Data = static_cast<u8*>(Mem);
+			this->Size = uMAX(Stat.st_size);
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Unmap file.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto close ( void ) -> void
+		{
+			if(this->Data) munmap(this->Data, this->Size);
+			this->Data = nullptr;
+			this->Size = 0;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Hint expected access pattern. Takes MADV_* value.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto advise ( const int _Advice, const uMAX _Offset = 0, const uMAX _Size = 0 ) const -> void
+		{
+			if(!this->Data || (_Offset >= this->Size)) return;
+
+			const auto Page = uMAX(sysconf(_SC_PAGESIZE));
+			const auto Beg = (_Offset / Page) * Page;
+			const auto End = (_Size == 0) ? this->Size : std::min(this->Size, _Offset + _Size);
+			madvise(this->Data + Beg, End - Beg, _Advice);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto isOpen ( void ) const -> bool { return this->Data != nullptr; }
+		inline auto data ( void ) const -> const u8* { return this->Data; }
+		inline auto size ( void ) const -> uMAX { return this->Size; }
+		template<class T> inline auto at ( const uMAX _Offset ) const -> const T* { return reinterpret_cast<const T*>(this->Data + _Offset); }
+	};
+}
@@ -0,0 +1,323 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Network.hpp"
+#include "./Mmap.hpp"
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto MODEL_MAGIC = u64(0x004C45444F4D5853); // "SXMODEL".
+	constexpr auto MODEL_VERSION = u64(1);
+	constexpr auto MODEL_ALIGNMENT = u64(64); // Alignment of every section. Multiple of ALIGNMENT.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Model file header. Followed by table of layer entries, custom data and parameters.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ModelHeader
+	{
+		u64 Magic;
+		u64 Version;
+		u64 SzHeader;
+		u64 SzT;
+		u64 IsFloat;
+		u64 Alignment;
+		u64 Layers;
+		u64 OffTable;
+		u64 OffData;
+		u64 SzData;
+		u64 SzFile;
+		NetworkInfo Info;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Model file layer entry. Offsets are from start of file, zero when layer has no parameters.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ModelEntry
+	{
+		LayerDesc Desc;
+		u64 OffWeights;
+		u64 OffBiases;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Round up to model alignment.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr inline auto modelAlign ( const u64 _Offset ) -> u64 { return ((_Offset + MODEL_ALIGNMENT - 1) / MODEL_ALIGNMENT) * MODEL_ALIGNMENT; }
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Validate mapped model file. Returns header or nullptr.
+	// Every section must be aligned and lie within file, so layers bound to entries never read past mapping.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto modelHeader ( const FileMap& _Map ) -> const ModelHeader*
+	{
+		if(!_Map.isOpen() || (_Map.size() < sizeof(ModelHeader))) return nullptr;
+
+		const auto Size = u64(_Map.size());
+		const auto fits = [&]( const u64 _Offset, const u64 _Count, const u64 _SzItem ) { return (_Offset <= Size) && (_Count <= (Size - _Offset) / _SzItem); };
+
+		const auto Header = _Map.at<ModelHeader>(0);
+		if(Header->Magic != MODEL_MAGIC) return nullptr;
+		if(Header->Version != MODEL_VERSION) return nullptr;
+		if(Header->SzHeader != sizeof(ModelHeader)) return nullptr;
+		if(Header->SzT != sizeof(T)) return nullptr;
+		if(Header->IsFloat != u64(std::is_floating_point_v<T>)) return nullptr;
+		if(Header->Alignment != MODEL_ALIGNMENT) return nullptr;
+		if(Header->SzFile != _Map.size()) return nullptr;
+		if((Header->OffTable < sizeof(ModelHeader)) || (Header->OffTable % MODEL_ALIGNMENT)) return nullptr;
+		if(!fits(Header->OffTable, Header->Layers, sizeof(ModelEntry))) return nullptr;
+		if((Header->OffData % MODEL_ALIGNMENT) || !fits(Header->OffData, Header->SzData, 1)) return nullptr;
+
+		// Parameters of layer are absent with zero size, otherwise aligned run of Ts past table.
+		const auto OffParams = Header->OffTable + Header->Layers * sizeof(ModelEntry);
+		const auto valid = [&]( const u64 _Offset, const u64 _Count )
+		{
+			if(!_Count) return _Offset == 0;
+			return (_Offset >= OffParams) && !(_Offset % MODEL_ALIGNMENT) && fits(_Offset, _Count, sizeof(T));
+		};
+
+		const auto Entries = _Map.at<ModelEntry>(Header->OffTable);
+		for(auto l = u64(0); l < Header->Layers; ++l)
+		{
+			if(!valid(Entries[l].OffWeights, Entries[l].Desc.SzWeights)) return nullptr;
+			if(!valid(Entries[l].OffBiases, Entries[l].Desc.SzBiases)) return nullptr;
+		}
+
+		return Header;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Store network to versioned model file.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto storeModel ( const str& _File, Network<T,MODE>& _Net, const NetworkInfo& _Info, const void* _Data, const uMAX _SzData ) -> bool
+	{
+		_Net.connect();
+
+
+		// Collect layers and lay out file.
+		auto Layers = vec<Layer<T>*>();
+		for(auto L = _Net.front(); L; L = L->front()) Layers.push_back(L);
+
+		auto Header = ModelHeader();
+		Header.Magic = MODEL_MAGIC;
+		Header.Version = MODEL_VERSION;
+		Header.SzHeader = sizeof(ModelHeader);
+		Header.SzT = sizeof(T);
+		Header.IsFloat = u64(std::is_floating_point_v<T>);
+		Header.Alignment = MODEL_ALIGNMENT;
+		Header.Layers = Layers.size();
+		Header.OffTable = modelAlign(sizeof(ModelHeader));
+		Header.OffData = modelAlign(Header.OffTable + Layers.size() * sizeof(ModelEntry));
+		Header.SzData = _SzData;
+		Header.Info = _Info;
+
+		auto Entries = vec<ModelEntry>(Layers.size());
+		auto Offset = modelAlign(Header.OffData + Header.SzData);
+
+		for(auto l = uMAX(0); l < Layers.size(); ++l)
+		{
+			auto& Entry = Entries[l];
+			Entry.Desc = Layers[l]->desc();
+			Entry.OffWeights = 0;
+			Entry.OffBiases = 0;
+
+			if(Entry.Desc.SzWeights) { Entry.OffWeights = Offset; Offset = modelAlign(Offset + Entry.Desc.SzWeights * sizeof(T)); }
+			if(Entry.Desc.SzBiases) { Entry.OffBiases = Offset; Offset = modelAlign(Offset + Entry.Desc.SzBiases * sizeof(T)); }
+		}
+
+		Header.SzFile = Offset;
+
+
+		// Write sections with padding between them.
+		auto File = std::ofstream(_File, std::ios::binary);
+		if(!File.is_open()) return false;
+
+		const auto Pad = [&]( const u64 _To ) { while(u64(File.tellp()) < _To) File.put(0); };
+
+		File.write(reinterpret_cast<const char*>(&Header), sizeof(ModelHeader));
+		Pad(Header.OffTable);
+		File.write(reinterpret_cast<const char*>(Entries.data()), Entries.size() * sizeof(ModelEntry));
+		Pad(Header.OffData);
+		if(_SzData) File.write(reinterpret_cast<const char*>(_Data), _SzData);
+
+		auto Params = vec<T>();
+		for(auto l = uMAX(0); l < Layers.size(); ++l)
+		{
+			const auto& Entry = Entries[l];
+			if(!Entry.Desc.SzWeights && !Entry.Desc.SzBiases) continue;
+
+			Params.resize(Entry.Desc.SzWeights + Entry.Desc.SzBiases);
+			Layers[l]->gather(Params.data(), LayerBuf::PARAMS, false);
+
+			if(Entry.Desc.SzWeights) { Pad(Entry.OffWeights); File.write(reinterpret_cast<const char*>(Params.data()), Entry.Desc.SzWeights * sizeof(T)); }
+			if(Entry.Desc.SzBiases) { Pad(Entry.OffBiases); File.write(reinterpret_cast<const char*>(Params.data() + Entry.Desc.SzWeights), Entry.Desc.SzBiases * sizeof(T)); }
+		}
+
+		Pad(Header.SzFile);
+		return File.good();
+	}
+
+	template<class T, CompClass MODE> auto storeModel ( const str& _File, Network<T,MODE>& _Net, const NetworkInfo& _Info = NetworkInfo() ) -> bool
+	{
+		return storeModel(_File, _Net, _Info, nullptr, 0);
+	}
+
+	template<class T, CompClass MODE, class DATA> auto storeModel ( const str& _File, Network<T,MODE>& _Net, const NetworkInfo& _Info, const DATA& _Data ) -> bool
+	{
+		return storeModel(_File, _Net, _Info, &_Data, sizeof(DATA));
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Memory mapped model. Layers bound to it execute straight from mapped pages, so every process shares one copy in page cache.
+	// Must outlive every network bound to it.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class ModelMap
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		FileMap Map;
+		const ModelHeader* Header;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ModelMap ( void ) : Map(), Header(nullptr) {}
+		ModelMap ( const str& _File ) : Map(), Header(nullptr) { this->open(_File); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Map and validate file.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto open ( const str& _File ) -> bool
+		{
+			this->Header = nullptr;
+			if(!this->Map.open(_File)) return false;
+
+			this->Header = modelHeader<T>(this->Map);
+			if(!this->Header) this->Map.close();
+			return this->Header != nullptr;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto isOpen ( void ) const -> bool { return this->Header != nullptr; }
+		inline auto info ( void ) const -> const NetworkInfo& { return this->Header->Info; }
+		inline auto layers ( void ) const -> uMAX { return this->Header->Layers; }
+		inline auto entry ( const uMAX _Layer ) const -> const ModelEntry& { return this->Map.template at<ModelEntry>(this->Header->OffTable)[_Layer]; }
+		inline auto weights ( const uMAX _Layer ) const -> const T* { return this->entry(_Layer).OffWeights ? this->Map.template at<T>(this->entry(_Layer).OffWeights) : nullptr; }
+		inline auto biases ( const uMAX _Layer ) const -> const T* { return this->entry(_Layer).OffBiases ? this->Map.template at<T>(this->entry(_Layer).OffBiases) : nullptr; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Get custom data. Returns nullptr when size does not match.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class DATA> auto data ( void ) const -> const DATA*
+		{
+			if(this->Header->SzData != sizeof(DATA)) return nullptr;
+			return this->Map.template at<DATA>(this->Header->OffData);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Check that network has same layers as file.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<CompClass MODE> auto matches ( Network<T,MODE>& _Net ) const -> bool
+		{
+			if(!this->isOpen()) return false;
+			_Net.connect();
+
+			auto l = uMAX(0);
+			for(auto L = _Net.front(); L; L = L->front(), ++l)
+			{
+				if(l >= this->layers()) return false;
+				if(!(L->desc() == this->entry(l).Desc)) return false;
+			}
+
+			return l == this->layers();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Point layers at mapped parameters. Bound layers are locked.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<CompClass MODE> auto bind ( Network<T,MODE>& _Net ) const -> bool
+		{
+			if(!this->matches(_Net)) return false;
+
+			auto l = uMAX(0);
+			for(auto L = _Net.front(); L; L = L->front(), ++l)
+			{
+				if(this->entry(l).Desc.SzWeights || this->entry(l).Desc.SzBiases) L->bind(this->weights(l), this->biases(l));
+			}
+
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Copy mapped parameters into layers own buffers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<CompClass MODE> auto load ( Network<T,MODE>& _Net ) const -> bool
+		{
+			if(!this->matches(_Net)) return false;
+
+			auto Params = vec<T>();
+			auto l = uMAX(0);
+			for(auto L = _Net.front(); L; L = L->front(), ++l)
+			{
+				const auto& Desc = this->entry(l).Desc;
+				if(!Desc.SzWeights && !Desc.SzBiases) continue;
+
+				Params.resize(Desc.SzWeights + Desc.SzBiases);
+				if(Desc.SzWeights) memCopy(Desc.SzWeights, Params.data(), this->weights(l));
+				if(Desc.SzBiases) memCopy(Desc.SzBiases, Params.data() + Desc.SzWeights, this->biases(l));
+				L->scatter(Params.data(), LayerBuf::PARAMS, false);
+			}
+
+			return true;
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Load model file into network by copying. Custom data and info are optional.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto loadModel ( const str& _File, Network<T,MODE>& _Net, NetworkInfo* _Info = nullptr ) -> bool
+	{
+		const auto Model = ModelMap<T>(_File);
+		if(!Model.load(_Net)) return false;
+		if(_Info) *_Info = Model.info();
+		return true;
+	}
+
+	template<class T, CompClass MODE, class DATA> auto loadModel ( const str& _File, Network<T,MODE>& _Net, NetworkInfo* _Info, DATA& _Data ) -> bool
+	{
+		const auto Model = ModelMap<T>(_File);
+		if(!Model.template data<DATA>() || !Model.load(_Net)) return false;
+		if(_Info) *_Info = Model.info();
+		_Data = *Model.template data<DATA>();
+		return true;
+	}
+}
@@ -9,6 +9,8 @@
 #include "./Layer.hpp"
 #include <vector>
 #include <fstream>
+#include <array>
+#include <cstdio>
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Neural Networks Experiment.
@@ -50,6 +52,17 @@ namespace sx
 		{}
 	};
 
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Profile of single layer. Measured counters stay zero unless built with SX_PROFILE.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct LayerStats
+	{
+		LayerDesc Desc;
+		ProfileCounters Ops[uMAX(LayerOp::COUNT)];
+		LayerCost Cost[uMAX(LayerOp::COUNT)]; // Work of single sample.
+	};
+
+
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	// Network components class.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -190,11 +203,82 @@ namespace sx
 		auto in ( const bool _Connect = true ) -> const T* { if(_Connect) this->connect(); return this->front()->in(); }
 		auto out ( const bool _Connect = true ) -> const T* { if(_Connect) this->connect(); return this->back()->out(); }
 		
-		auto exe ( const T* _Input, const bool _Connect = true ) -> void { if(_Connect) this->connect(); this->front()->setInput(_Input); this->front()->exe(); }
+		auto exe ( const T* _Input, const bool _Connect = true ) -> void { if(_Connect) this->connect(); this->front()->setInput(_Input); SX_MC_PROFILE(this->front(), LayerOp::EXE, this->front()->exe()); }
 		auto reset ( const bool _Connect = true ) -> void { if(_Connect) this->connect(); this->front()->reset(); }
 		auto err ( const T* _Target, const bool _Connect = true ) -> T { if(_Connect) this->connect(); return this->back()->err(_Target); }
-		auto fit ( const T* _Target, const T _ErrParam, const bool _Connect = true ) -> void { if(_Connect) this->connect(); return this->back()->fit(_Target, _ErrParam); }
-		auto apply ( const rMAX _Rate, const uMAX _Iter, const bool _Connect = true ) -> void { if(_Connect) this->connect(); return this->front()->apply(_Rate, _Iter); }
+		auto fit ( const T* _Target, const T _ErrParam, const bool _Connect = true ) -> void { if(_Connect) this->connect(); SX_MC_PROFILE(this->back(), LayerOp::FIT, this->back()->fit(_Target, _ErrParam)); }
+		auto apply ( const rMAX _Rate, const uMAX _Iter, const bool _Connect = true ) -> void { if(_Connect) this->connect(); SX_MC_PROFILE(this->front(), LayerOp::APPLY, this->front()->apply(_Rate, _Iter)); }
+		auto bufSz ( const LayerBuf _Buf, const bool _Connect = true ) -> uMAX { if(_Connect) this->connect(); return this->front()->bufSz(_Buf); }
+		auto gather ( T* _Dst, const LayerBuf _Buf, const bool _Connect = true ) -> T* { if(_Connect) this->connect(); return this->front()->gather(_Dst, _Buf); }
+		auto scatter ( const T* _Src, const LayerBuf _Buf, const bool _Connect = true ) -> const T* { if(_Connect) this->connect(); return this->front()->scatter(_Src, _Buf); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Mirror batch layer functions. Sample n of inputs and targets starts at n * _Stride, outputs are laid out as [N][outSz()].
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto outBatch ( const bool _Connect = true ) -> const T* { if(_Connect) this->connect(); return this->back()->outBatch(); }
+		auto exeBatch ( const T* _Inputs, const uMAX _Stride, const uMAX _Count, const bool _Connect = true ) -> void { if(_Connect) this->connect(); this->front()->setInputBatch(_Inputs, _Stride); SX_MC_PROFILE_BATCH(this->front(), LayerOp::EXE_BATCH, _Count, this->front()->exeBatch(_Count)); }
+		auto errBatch ( const T* _Targets, const uMAX _Stride, const uMAX _Count, const bool _Connect = true ) -> T { if(_Connect) this->connect(); return this->back()->errBatch(_Targets, _Stride, _Count); }
+		auto fitBatch ( const T* _Targets, const uMAX _Stride, const uMAX _Count, const T _ErrParam, const bool _Connect = true ) -> void { if(_Connect) this->connect(); SX_MC_PROFILE_BATCH(this->back(), LayerOp::FIT_BATCH, _Count, this->back()->fitBatch(_Targets, _Stride, _Count, _ErrParam)); }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Collect profile of layers from front to back.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto profile ( const bool _Connect = true ) -> vec<LayerStats>
+		{
+			if(_Connect) this->connect();
+
+			auto Stats = vec<LayerStats>();
+			for(auto l = this->front(); l; l = l->front())
+			{
+				auto Entry = LayerStats{l->desc(), {}, {}};
+				for(auto o = uMAX(0); o < uMAX(LayerOp::COUNT); ++o) Entry.Cost[o] = l->cost(layerOpSample(LayerOp(o)));
+				#if defined(SX_PROFILE)
+				for(auto o = uMAX(0); o < uMAX(LayerOp::COUNT); ++o) Entry.Ops[o] = l->Prof.Ops[o];
+				#endif
+				Stats.push_back(Entry);
+			}
+
+			return Stats;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Clear measured counters of layers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto profileReset ( const bool _Connect = true ) -> void
+		{
+			if(_Connect) this->connect();
+
+			#if defined(SX_PROFILE)
+			for(auto l = this->front(); l; l = l->front()) l->Prof = LayerProfile();
+			#endif
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Print profile table. Rates are derived from layer dimensions and measured time.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto profileReport ( std::ostream& _Stream, const bool _Connect = true ) -> void
+		{
+			const auto Stats = this->profile(_Connect);
+
+			auto Line = std::array<char, 256>();
+			std::snprintf(Line.data(), Line.size(), "%-4s %-12s %-8s %12s %12s %12s %10s %10s %14s %14s\n", "#", "Layer", "Op", "Calls", "Total ms", "Call us", "GFLOP/s", "GB/s", "Cycles", "Cache misses");
+			_Stream << Line.data();
+
+			for(auto l = uMAX(0); l < Stats.size(); ++l) for(auto o = uMAX(0); o < uMAX(LayerOp::COUNT); ++o)
+			{
+				const auto& Ops = Stats[l].Ops[o];
+				const auto& Cost = Stats[l].Cost[o];
+				const auto Nanos = r64(std::max(Ops.Nanos, u64(1)));
+
+				std::snprintf(Line.data(), Line.size(), "%-4zu %-12s %-8s %12llu %12.3f %12.3f %10.3f %10.3f %14llu %14llu\n", size_t(l), layerTypeName(Stats[l].Desc.Type), layerOpName(LayerOp(o)),
+					(unsigned long long)Ops.Calls, r64(Ops.Nanos) / 1e6, r64(Ops.Nanos) / 1e3 / r64(std::max(Ops.Calls, u64(1))),
+					r64(Cost.Flops) * r64(Ops.Samples) / Nanos, r64(Cost.Bytes) * r64(Ops.Samples) / Nanos, (unsigned long long)Ops.Cycles, (unsigned long long)Ops.CacheMisses);
+				_Stream << Line.data();
+			}
+		}
 
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -266,4 +350,31 @@ namespace sx
 			}
 		}
 	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Fill network _Dst from network _Src of same shape, layer by layer. _Convert(Dst, Src, Index) lets layer of _Dst take parameters
+	// of its counterpart and returns true if it did, remaining layers must match and copy them. Returns false on first mismatch.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE, class FN> auto convertNetwork ( Network<T,MODE>& _Dst, Network<T,MODE>& _Src, FN&& _Convert ) -> bool
+	{
+		_Dst.connect();
+		_Src.connect();
+
+		auto Params = vec<T>();
+		auto l = uMAX(0);
+		auto S = _Src.front();
+
+		for(auto D = _Dst.front(); D; D = D->front(), S = S->front(), ++l)
+		{
+			if(!S) return false;
+			if(_Convert(D, S, l)) continue;
+			if(!(D->desc() == S->desc())) return false;
+
+			Params.resize(S->bufSz(LayerBuf::PARAMS, false));
+			S->gather(Params.data(), LayerBuf::PARAMS, false);
+			D->scatter(Params.data(), LayerBuf::PARAMS, false);
+		}
+
+		return S == nullptr;
+	}
 }
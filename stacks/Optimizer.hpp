@@ -57,7 +57,18 @@ namespace sx
 
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Optimized apply.
+	// Scalar operations per parameter. Used to pick grain size.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, FnOptim FN_OPTIM> constexpr inline auto optimCost ( void ) -> uMAX
+	{
+		if constexpr(FN_OPTIM == FnOptim::NONE) return 2;
+		if constexpr(FN_OPTIM == FnOptim::MOMENTUM) return 5;
+		if constexpr(FN_OPTIM == FnOptim::ADAM) return 16;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Optimized apply on range of buffers.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	template
 	<
@@ -65,12 +76,13 @@ namespace sx
 		FnOptim FN_OPTIM
 	>
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	auto optimApply
+	auto optimApplyRange
 	(
 		const T _Rate,
 		const uMAX _Iter,
 		
-		const u64 _Size,
+		const u64 _Beg,
+		const u64 _End,
 		T* _Buff,
 		T* _BuffD,
 		T* _BuffM,
@@ -81,7 +93,7 @@ namespace sx
 	{
 		if constexpr(FN_OPTIM == FnOptim::NONE)
 		{
-			for(auto i = uMAX(0); i < _Size; ++i)
+			for(auto i = _Beg; i < _End; ++i)
 			{
 				_Buff[i] -= _Rate * _BuffD[i];
 			}
@@ -90,7 +102,7 @@ namespace sx
 
 		if constexpr(FN_OPTIM == FnOptim::MOMENTUM)
 		{
-			for(auto i = uMAX(0); i < _Size; ++i)
+			for(auto i = _Beg; i < _End; ++i)
 			{
 				_BuffM[i] = (_BuffD[i] * BETA1F) + (_BuffM[i] * BETA1);
 				_Buff[i] -= _Rate * _BuffM[i];
@@ -102,7 +114,7 @@ namespace sx
 		{
 			const auto Iter = _Iter + 1;
 			
-			for(auto i = uMAX(0); i < _Size; ++i)
+			for(auto i = _Beg; i < _End; ++i)
 			{
 				_BuffM[i] = (BETA1 * _BuffM[i]) + (BETA1F * _BuffD[i]);
 				_BuffV[i] = (BETA2 * _BuffV[i]) + (BETA2F * math::sqr(_BuffD[i]));
@@ -115,4 +127,37 @@ namespace sx
 		}
 	}
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Optimized apply. Splits buffers across thread pool.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template
+	<
+		class T,
+		FnOptim FN_OPTIM
+	>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto optimApply
+	(
+		const T _Rate,
+		const uMAX _Iter,
+		
+		const u64 _Size,
+		T* _Buff,
+		T* _BuffD,
+		T* _BuffM,
+		T* _BuffV
+
+	)
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	{
+		constexpr auto GRAIN = parGrain(optimCost<T,FN_OPTIM>());
+
+		threadPool().parallelFor(_Size, GRAIN, [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+		{
+			optimApplyRange<T,FN_OPTIM>(_Rate, _Iter, _Beg, _End, _Buff, _BuffD, _BuffM, _BuffV);
+		});
+	}
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 }
@@ -0,0 +1,415 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Network.hpp"
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <new>
+#include <thread>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto Q8_BLOCK = uMAX(256); // Values sharing one quantization scale.
+	constexpr auto PROC_POLL = std::chrono::milliseconds(10); // Longest sleep of barrier waiter or launcher before it looks for failure again.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Gradient compression options.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class FnCompress
+	{
+		NONE, // Raw Ts.
+		Q8 // 8 bit quantization with per block scale and error feedback.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Header placed at start of shared memory. Barrier is counter of arrived workers and generation bumped by last of them,
+	// so waiters can also leave when group is aborted.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ProcSharedHeader
+	{
+		std::atomic<u32> Arrived;
+		std::atomic<u32> Generation;
+		std::atomic<u32> Aborted;
+		u64 Workers;
+		u64 Size;
+	};
+	static_assert(std::atomic<u32>::is_always_lock_free, "Shared barrier needs lock free atomics!");
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Group of worker processes on one host exchanging deltas through POSIX shared memory.
+	// Must be constructed before spawnWorkers so every worker inherits the mapping.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class ProcGroup
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		uMAX Workers;
+		uMAX Size;
+		FnCompress Compress;
+		uMAX Blocks;
+		uMAX OffBroadcast;
+		uMAX OffSlots;
+		uMAX SzSlot;
+		uMAX SzMap;
+		u8* Map;
+		vec<T> Local; // Process private staging buffer.
+		vec<T> Residual; // Process private quantization error carried to next exchange.
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ProcGroup ( const uMAX _Workers, const uMAX _Size, const FnCompress _Compress = FnCompress::NONE ) :
+			Workers(_Workers),
+			Size(_Size),
+			Compress(_Compress),
+			Blocks((_Size + Q8_BLOCK - 1) / Q8_BLOCK),
+			OffBroadcast(0),
+			OffSlots(0),
+			SzSlot(0),
+			SzMap(0),
+			Map(nullptr),
+			Local(),
+			Residual()
+		{
+			if(!this->Workers || !this->Size) throw Error("sx"s, "ProcGroup<T>"s, "ProcGroup"s, 0, "Invalid workers or size!"s);
+
+			const auto Align = [](const uMAX _Sz) { return ((_Sz + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT; };
+
+			if(this->Compress == FnCompress::NONE) this->SzSlot = Align(this->Size * sizeof(T));
+			if(this->Compress == FnCompress::Q8) this->SzSlot = Align(this->Blocks * sizeof(r32)) + Align(this->Size * sizeof(i8));
+
+			this->OffBroadcast = Align(sizeof(ProcSharedHeader));
+			this->OffSlots = this->OffBroadcast + Align(this->Size * sizeof(T));
+			this->SzMap = this->OffSlots + this->SzSlot * this->Workers;
+
+
+			// Create segment and drop its name right away. Mapping stays alive in every process that inherits it.
+			static auto Counter = std::atomic<uMAX>(0);
+			const auto Name = "/sx."s + std::to_string(getpid()) + "."s + std::to_string(Counter++);
+
+			const auto Fd = shm_open(Name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if(Fd < 0) throw Error("sx"s, "ProcGroup<T>"s, "ProcGroup"s, 1, "Failed to create shared memory!"s);
+			shm_unlink(Name.c_str());
+
+			if(ftruncate(Fd, this->SzMap) != 0) { close(Fd); throw Error("sx"s, "ProcGroup<T>"s, "ProcGroup"s, 2, "Failed to size shared memory!"s); }
+
+			const auto Mem = mmap(nullptr, this->SzMap, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+			close(Fd);
+			if(Mem == MAP_FAILED) throw Error("sx"s, "ProcGroup<T>"s, "ProcGroup"s, 3, "Failed to map shared memory!"s);
+			this->Map = static_cast<u8*>(Mem);
+
+
+			// Header is built in place, barrier starts empty in generation zero.
+			auto Header = new (this->Map) ProcSharedHeader();
+			Header->Workers = this->Workers;
+			Header->Size = this->Size;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~ProcGroup ( void )
+		{
+			if(this->Map) munmap(this->Map, this->SzMap);
+		}
+
+		ProcGroup ( const ProcGroup& ) = delete;
+		auto operator= ( const ProcGroup& ) -> ProcGroup& = delete;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto workers ( void ) const -> uMAX { return this->Workers; }
+		inline auto size ( void ) const -> uMAX { return this->Size; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Wait for every worker. Throws once group is aborted, so survivors of failed worker do not wait forever.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto barrier ( void ) -> void
+		{
+			SX_MC_TRACE("barrier", nullptr);
+			auto Header = this->header();
+			if(Header->Aborted.load(std::memory_order_acquire)) throw fx::Error("sx"s, "ProcGroup<T>"s, "barrier"s, 0, "Group aborted!"s);
+
+			const auto Generation = Header->Generation.load(std::memory_order_acquire);
+			if(Header->Arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == this->Workers)
+			{
+				Header->Arrived.store(0, std::memory_order_relaxed);
+				Header->Generation.fetch_add(1, std::memory_order_release);
+				ProcGroup::wake(Header->Generation);
+				return;
+			}
+
+			while(Header->Generation.load(std::memory_order_acquire) == Generation)
+			{
+				if(Header->Aborted.load(std::memory_order_acquire)) throw fx::Error("sx"s, "ProcGroup<T>"s, "barrier"s, 0, "Group aborted!"s);
+				ProcGroup::sleep(Header->Generation, Generation);
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Mark group as failed and release every waiting worker. Group can not be used afterwards.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto abort ( void ) -> void
+		{
+			this->header()->Aborted.store(1, std::memory_order_release);
+			ProcGroup::wake(this->header()->Generation);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Copy parameters of rank 0 to every worker.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<CompClass MODE> auto broadcast ( const uMAX _Rank, Network<T,MODE>& _Net ) -> void
+		{
+			SX_MC_TRACE("broadcast", nullptr);
+
+			try
+			{
+				this->check(_Rank, _Net.bufSz(LayerBuf::PARAMS), "broadcast"s);
+				auto Shared = reinterpret_cast<T*>(this->Map + this->OffBroadcast);
+
+				if(_Rank == 0) _Net.gather(Shared, LayerBuf::PARAMS);
+				this->barrier();
+				if(_Rank != 0) _Net.scatter(Shared, LayerBuf::PARAMS);
+				this->barrier();
+			}
+			catch(...) { this->abort(); throw; }
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Sum deltas of all workers. Every worker ends up with identical deltas, so applying them keeps parameters in sync.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<CompClass MODE> auto allReduce ( const uMAX _Rank, Network<T,MODE>& _Net ) -> void
+		{
+			SX_MC_TRACE("allReduce", nullptr);
+
+			try
+			{
+				this->check(_Rank, _Net.bufSz(LayerBuf::DELTAS), "allReduce"s);
+				if(this->Local.size() != this->Size) this->Local.resize(this->Size);
+				_Net.gather(this->Local.data(), LayerBuf::DELTAS);
+
+				this->publish(_Rank);
+				this->barrier();
+				this->reduce();
+				this->barrier();
+
+				_Net.scatter(this->Local.data(), LayerBuf::DELTAS);
+			}
+			catch(...) { this->abort(); throw; }
+		}
+
+		private:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Rank must own slot and network must fill exactly what group was sized for, otherwise gather would run past shared buffers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto check ( const uMAX _Rank, const uMAX _Size, const str& _Func ) const -> void
+		{
+			if(_Rank >= this->Workers) throw Error("sx"s, "ProcGroup<T>"s, _Func, 0, "Invalid rank!"s);
+			if(_Size != this->Size) throw Error("sx"s, "ProcGroup<T>"s, _Func, 1, "Network size does not match group!"s);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Shared memory regions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto header ( void ) -> ProcSharedHeader* { return std::launder(reinterpret_cast<ProcSharedHeader*>(this->Map)); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Sleep while _Word holds _Value, at most PROC_POLL. Wake all sleepers of _Word. Futex is shared, not private, as waiters are other processes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto sleep ( std::atomic<u32>& _Word, const u32 _Value ) -> void
+		{
+			#if defined(__linux__)
+			const auto Timeout = timespec{0, long(std::chrono::nanoseconds(PROC_POLL).count())};
+			syscall(SYS_futex, reinterpret_cast<u32*>(&_Word), FUTEX_WAIT, _Value, &Timeout, nullptr, 0);
+			#else
+			if(_Word.load(std::memory_order_acquire) == _Value) std::this_thread::sleep_for(PROC_POLL);
+			#endif
+		}
+
+		static auto wake ( std::atomic<u32>& _Word ) -> void
+		{
+			#if defined(__linux__)
+			syscall(SYS_futex, reinterpret_cast<u32*>(&_Word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+			#else
+			(void)_Word;
+			#endif
+		}
+		inline auto slot ( const uMAX _Rank ) -> u8* { return this->Map + this->OffSlots + this->SzSlot * _Rank; }
+		inline auto slotScales ( const uMAX _Rank ) -> r32* { return reinterpret_cast<r32*>(this->slot(_Rank)); }
+		inline auto slotValues ( const uMAX _Rank ) -> i8* { return reinterpret_cast<i8*>(this->slot(_Rank) + ((this->Blocks * sizeof(r32) + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Write local deltas to own slot.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto publish ( const uMAX _Rank ) -> void
+		{
+			SX_MC_TRACE("publish", nullptr);
+
+			if(this->Compress == FnCompress::NONE)
+			{
+				memCopy(this->Size, reinterpret_cast<T*>(this->slot(_Rank)), this->Local.data());
+			}
+
+			if(this->Compress == FnCompress::Q8)
+			{
+				if(this->Residual.size() != this->Size) this->Residual.assign(this->Size, T(0));
+
+				auto Scales = this->slotScales(_Rank);
+				auto Values = this->slotValues(_Rank);
+
+				for(auto b = uMAX(0); b < this->Blocks; ++b)
+				{
+					const auto Beg = b * Q8_BLOCK;
+					const auto End = std::min(Beg + Q8_BLOCK, this->Size);
+
+					// Carry error of last exchange into this one.
+					auto Peak = T(0);
+					for(auto i = Beg; i < End; ++i)
+					{
+						this->Local[i] += this->Residual[i];
+						Peak = std::max(Peak, std::abs(this->Local[i]));
+					}
+
+					const auto Scale = (Peak > T(0)) ? (Peak / T(127)) : T(1);
+					Scales[b] = r32(Scale);
+
+					for(auto i = Beg; i < End; ++i)
+					{
+						const auto Q = std::clamp(std::lround(this->Local[i] / Scale), long(-127), long(127));
+						Values[i] = i8(Q);
+						this->Residual[i] = this->Local[i] - T(Q) * T(Scales[b]);
+					}
+				}
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Sum all slots into local buffer. Every worker sums in rank order so results are bit identical.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto reduce ( void ) -> void
+		{
+			SX_MC_TRACE("reduce", nullptr);
+
+			memZero(this->Size, this->Local.data());
+
+			for(auto r = uMAX(0); r < this->Workers; ++r)
+			{
+				if(this->Compress == FnCompress::NONE)
+				{
+					const auto Src = reinterpret_cast<const T*>(this->slot(r));
+					for(auto i = uMAX(0); i < this->Size; ++i) this->Local[i] += Src[i];
+				}
+
+				if(this->Compress == FnCompress::Q8)
+				{
+					const auto Scales = this->slotScales(r);
+					const auto Values = this->slotValues(r);
+
+					for(auto b = uMAX(0); b < this->Blocks; ++b)
+					{
+						const auto Scale = T(Scales[b]);
+						const auto End = std::min((b + 1) * Q8_BLOCK, this->Size);
+						for(auto i = b * Q8_BLOCK; i < End; ++i) this->Local[i] += T(Values[i]) * Scale;
+					}
+				}
+			}
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Local launcher. Forks _Workers processes running _Fn(Rank) and waits for all of them. Returns false if any worker failed
+	// or could not be forked, remaining workers are killed then, so none is left waiting on group barrier for dead peer.
+	// Thread pool is stopped across fork and each worker gets its share of threads.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class FN> auto spawnWorkers ( const uMAX _Workers, const FN& _Fn ) -> bool
+	{
+		auto Pids = vec<pid_t>();
+		const auto Threads = threadPool().size();
+		threadPool().resize(0);
+		std::cout.flush();
+
+		for(auto r = uMAX(0); r < _Workers; ++r)
+		{
+			const auto Pid = fork();
+
+			if(Pid == 0)
+			{
+				auto Code = 0;
+				const auto Share = (Threads + 1) / _Workers; // Calling thread counts as one.
+				threadPool().resize((Share > 1) ? (Share - 1) : 0);
+				try { _Fn(r); }
+				catch(...) { Code = 1; }
+				std::cout.flush();
+				_exit(Code);
+			}
+
+			if(Pid < 0) break;
+			Pids.push_back(Pid);
+		}
+
+		auto Success = (Pids.size() == _Workers);
+		if(!Success) for(auto Pid : Pids) kill(Pid, SIGKILL);
+
+		// Poll instead of blocking on one worker, failure of any other must be noticed right away.
+		while(!Pids.empty())
+		{
+			auto Reaped = false;
+			for(auto p = uMAX(0); p < Pids.size();)
+			{
+				auto Status = 0;
+				const auto Done = waitpid(Pids[p], &Status, WNOHANG);
+				if(Done == 0) { ++p; continue; }
+
+				const auto Failed = (Done != Pids[p]) || !WIFEXITED(Status) || (WEXITSTATUS(Status) != 0);
+				Pids.erase(Pids.begin() + p);
+				Reaped = true;
+
+				if(Failed && Success) for(auto Pid : Pids) kill(Pid, SIGKILL);
+				if(Failed) Success = false;
+			}
+
+			if(!Reaped && !Pids.empty()) std::this_thread::sleep_for(PROC_POLL);
+		}
+
+		threadPool().resize(Threads);
+
+		return Success;
+	}
+}
@@ -0,0 +1,305 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include "./Trace.hpp"
+#if defined(SX_PROFILE) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Macros. Profiled and traced call of layer function, without SX_PROFILE and SX_TRACE it is plain call. Batch calls also count their samples.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	#if defined(SX_PROFILE)
+	#define SX_MC_PROFILE_SCOPE(LAYER, OP, SAMPLES) const auto ProfScope = ProfileScope((LAYER)->Prof.Ops[uMAX(OP)], SAMPLES)
+	#else
+	#define SX_MC_PROFILE_SCOPE(LAYER, OP, SAMPLES) do {} while(false)
+	#endif
+
+	#if defined(SX_TRACE)
+	#define SX_MC_TRACE_LAYER(LAYER, OP) const auto TraceLayer = TraceScope(tracer().enabled() ? layerTypeName((LAYER)->desc().Type) : nullptr, layerOpName(OP))
+	#else
+	#define SX_MC_TRACE_LAYER(LAYER, OP) do {} while(false)
+	#endif
+
+	#if defined(SX_PROFILE) || defined(SX_TRACE)
+	#define SX_MC_PROFILE(LAYER, OP, CALL) do { SX_MC_PROFILE_SCOPE(LAYER, OP, 1); SX_MC_TRACE_LAYER(LAYER, OP); CALL; } while(false)
+	#define SX_MC_PROFILE_BATCH(LAYER, OP, COUNT, CALL) do { SX_MC_PROFILE_SCOPE(LAYER, OP, COUNT); SX_MC_TRACE_LAYER(LAYER, OP); CALL; } while(false)
+	#else
+	#define SX_MC_PROFILE(LAYER, OP, CALL) CALL
+	#define SX_MC_PROFILE_BATCH(LAYER, OP, COUNT, CALL) CALL
+	#endif
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Profiled layer operations.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class LayerOp : u64
+	{
+		EXE,
+		FIT,
+		APPLY,
+		EXE_BATCH,
+		FIT_BATCH,
+		COUNT
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Name of layer operation.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto layerOpName ( const LayerOp _Op ) -> const char*
+	{
+		switch(_Op)
+		{
+			case LayerOp::EXE: return "exe";
+			case LayerOp::FIT: return "fit";
+			case LayerOp::APPLY: return "apply";
+			case LayerOp::EXE_BATCH: return "exeBatch";
+			case LayerOp::FIT_BATCH: return "fitBatch";
+			default: return "none";
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Operation doing work of one sample of _Op. Batch operations cost per sample what single ones cost per call.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto layerOpSample ( const LayerOp _Op ) -> LayerOp
+	{
+		switch(_Op)
+		{
+			case LayerOp::EXE_BATCH: return LayerOp::EXE;
+			case LayerOp::FIT_BATCH: return LayerOp::FIT;
+			default: return _Op;
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Work of single layer operation, derived from layer dimensions. Counts main loops only.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct LayerCost
+	{
+		u64 Flops; // Floating point operations.
+		u64 Bytes; // Bytes read and written.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Accumulated measurements of single layer operation. Time excludes layers called by it.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ProfileCounters
+	{
+		u64 Calls;
+		u64 Samples; // Samples processed by calls, same as calls for single sample operations.
+		u64 Nanos;
+		u64 Cycles; // Hardware counters of calling thread, zero unless enabled and available.
+		u64 CacheMisses;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Measurements of all operations of layer.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct LayerProfile
+	{
+		ProfileCounters Ops[uMAX(LayerOp::COUNT)] = {};
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Switch for hardware counters. They cost system call per measurement, so are off by default.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto profileHardware ( void ) -> std::atomic<bool>&
+	{
+		static auto Enabled = std::atomic<bool>(false);
+		return Enabled;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Point in time of calling thread.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ProfileStamp
+	{
+		u64 Nanos;
+		u64 Cycles;
+		u64 CacheMisses;
+	};
+
+
+	#if defined(SX_PROFILE)
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Hardware counters of calling thread. Cycles lead group with cache misses so both are read at once.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class ProfileHw
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		int Leader;
+		int Member;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Open counter of calling thread.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto open ( const u64 _Config, const int _Group ) -> int
+		{
+			#if defined(__linux__)
+			auto Attr = perf_event_attr();
+			std::memset(&Attr, 0, sizeof(Attr));
+			Attr.size = sizeof(Attr);
+			Attr.type = PERF_TYPE_HARDWARE;
+			Attr.config = _Config;
+			Attr.exclude_kernel = 1;
+			Attr.exclude_hv = 1;
+			Attr.read_format = PERF_FORMAT_GROUP;
+			return int(syscall(SYS_perf_event_open, &Attr, 0, -1, _Group, 0));
+			#else
+			return -1;
+			#endif
+		}
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ProfileHw ( void ) : Leader(-1), Member(-1)
+		{
+			#if defined(__linux__)
+			this->Leader = ProfileHw::open(PERF_COUNT_HW_CPU_CYCLES, -1);
+			if(this->Leader >= 0) this->Member = ProfileHw::open(PERF_COUNT_HW_CACHE_MISSES, this->Leader);
+			#endif
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~ProfileHw ( void )
+		{
+			#if defined(__linux__)
+			if(this->Member >= 0) close(this->Member);
+			if(this->Leader >= 0) close(this->Leader);
+			#endif
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Read counters. Unavailable ones read as zero.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto read ( ProfileStamp& _Stamp ) const -> void
+		{
+			#if defined(__linux__)
+			u64 Values[3] = {};
+			if(this->Leader >= 0 && ::read(this->Leader, Values, sizeof(Values)) > 0)
+			{
+				_Stamp.Cycles = Values[1];
+				_Stamp.CacheMisses = (Values[0] > 1) ? Values[2] : 0;
+			}
+			#endif
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Counters of calling thread, opened on first use.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto local ( void ) -> const ProfileHw&
+		{
+			thread_local const auto Hw = ProfileHw();
+			return Hw;
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Take stamp of calling thread.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto profileStamp ( void ) -> ProfileStamp
+	{
+		auto Stamp = ProfileStamp{u64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()), 0, 0};
+		if(profileHardware().load(std::memory_order_relaxed)) ProfileHw::local().read(Stamp);
+		return Stamp;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Measures one layer operation. Scopes nest per thread: parent is paused while chained layer runs,
+	// so every layer is charged only its own work.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class ProfileScope
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ProfileCounters& Counters;
+		ProfileScope* Parent;
+		ProfileStamp Beg;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Innermost scope of calling thread.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto current ( void ) -> ProfileScope*&
+		{
+			thread_local ProfileScope* Current = nullptr;
+			return Current;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Charge time since last resume.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto charge ( const ProfileStamp& _Now ) -> void
+		{
+			this->Counters.Nanos += _Now.Nanos - this->Beg.Nanos;
+			this->Counters.Cycles += _Now.Cycles - this->Beg.Cycles;
+			this->Counters.CacheMisses += _Now.CacheMisses - this->Beg.CacheMisses;
+		}
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ProfileScope ( ProfileCounters& _Counters, const uMAX _Samples = 1 ) : Counters(_Counters), Parent(ProfileScope::current()), Beg(profileStamp())
+		{
+			if(this->Parent) this->Parent->charge(this->Beg);
+			ProfileScope::current() = this;
+			this->Counters.Calls++;
+			this->Counters.Samples += _Samples;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~ProfileScope ( void )
+		{
+			const auto Now = profileStamp();
+			this->charge(Now);
+			ProfileScope::current() = this->Parent;
+			if(this->Parent) this->Parent->Beg = Now;
+		}
+
+		ProfileScope ( const ProfileScope& ) = delete;
+		auto operator= ( const ProfileScope& ) -> ProfileScope& = delete;
+	};
+	#endif
+}
@@ -0,0 +1,165 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <fx/Types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto QUANT_MAX = i32(127); // Symmetric range, -128 is never produced so sign tricks of dot products stay exact.
+	constexpr auto QUANT_PAD = uMAX(32); // Int8 rows are padded with zeros to multiple of one AVX2 register.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Padded length of int8 row.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr inline auto quantPad ( const uMAX _Count ) -> uMAX { return ((_Count + QUANT_PAD - 1) / QUANT_PAD) * QUANT_PAD; }
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Largest magnitude of values.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto quantMaxAbs ( const uMAX _Count, const T* _Src ) -> T
+	{
+		auto Peak = T(0);
+		for(auto i = uMAX(0); i < _Count; ++i) Peak = std::max(Peak, std::abs(_Src[i]));
+		return Peak;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Scale mapping range [-_MaxAbs, _MaxAbs] onto int8.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> constexpr inline auto quantScale ( const T _MaxAbs ) -> T { return (_MaxAbs > T(0)) ? (_MaxAbs / T(QUANT_MAX)) : T(1); }
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Quantize T to int8. _Dst[i] = round(_Src[i] / _Scale), rounds to nearest even and saturates.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto quantizeS8 ( const uMAX _Count, const T* _Src, i8* _Dst, const T _Scale ) -> void
+	{
+		auto i = uMAX(0);
+		const auto Inv = T(1) / _Scale;
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T,r32>)
+		{
+			const auto Mul = _mm256_set1_ps(Inv);
+			const auto Hi = _mm256_set1_ps(r32(QUANT_MAX));
+			const auto Lo = _mm256_set1_ps(-r32(QUANT_MAX));
+			const auto Order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+			const auto load = [&]( const uMAX _At ) { return _mm256_cvtps_epi32(_mm256_max_ps(Lo, _mm256_min_ps(Hi, _mm256_mul_ps(_mm256_loadu_ps(_Src + _At), Mul)))); };
+
+			for(; i + 32 <= _Count; i += 32)
+			{
+				const auto Words = _mm256_packs_epi32(load(i), load(i + 8));
+				const auto Words2 = _mm256_packs_epi32(load(i + 16), load(i + 24));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(_Dst + i), _mm256_permutevar8x32_epi32(_mm256_packs_epi16(Words, Words2), Order));
+			}
+		}
+		#endif
+
+		for(; i < _Count; ++i) _Dst[i] = i8(std::nearbyint(std::clamp(_Src[i] * Inv, -T(QUANT_MAX), T(QUANT_MAX))));
+	}
+
+
+	#if defined(__AVX2__)
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Products of 32 int8 pairs summed into eight int32 lanes. _Abs holds |w| and _X is x with sign of w applied,
+	// so unsigned by signed multiply gives w * x without overflow while both stay within QUANT_MAX.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto quantMadd ( const __m256i _Abs, const __m256i _X, const __m256i _Sign ) -> __m256i
+	{
+		return _mm256_madd_epi16(_mm256_maddubs_epi16(_Abs, _mm256_sign_epi8(_X, _Sign)), _mm256_set1_epi16(1));
+	}
+
+	inline auto quantSum ( const __m256i _Acc ) -> i32
+	{
+		const auto Half = _mm_add_epi32(_mm256_castsi256_si128(_Acc), _mm256_extracti128_si256(_Acc, 1));
+		const auto Quarter = _mm_add_epi32(Half, _mm_shuffle_epi32(Half, 0x4E));
+		return _mm_cvtsi128_si32(_mm_add_epi32(Quarter, _mm_shuffle_epi32(Quarter, 0xB1)));
+	}
+	#endif
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Dot product of int8 vectors with int32 accumulation.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto dotS8 ( const uMAX _Count, const i8* _W, const i8* _X ) -> i32
+	{
+		auto i = uMAX(0);
+		auto Sum = i32(0);
+
+		#if defined(__AVX2__)
+		auto Acc = _mm256_setzero_si256();
+		for(; i + 32 <= _Count; i += 32)
+		{
+			const auto W = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_W + i));
+			Acc = _mm256_add_epi32(Acc, quantMadd(_mm256_abs_epi8(W), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_X + i)), W));
+		}
+		Sum = quantSum(Acc);
+		#endif
+
+		for(; i < _Count; ++i) Sum += i32(_W[i]) * i32(_X[i]);
+		return Sum;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Dot products of one int8 row with four int8 vectors. Row is loaded once for all of them.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto dotS8x4 ( const uMAX _Count, const i8* _W, const i8* _X0, const i8* _X1, const i8* _X2, const i8* _X3, i32* _Sums ) -> void
+	{
+		auto i = uMAX(0);
+		_Sums[0] = _Sums[1] = _Sums[2] = _Sums[3] = 0;
+
+		#if defined(__AVX2__)
+		auto Acc0 = _mm256_setzero_si256(), Acc1 = _mm256_setzero_si256(), Acc2 = _mm256_setzero_si256(), Acc3 = _mm256_setzero_si256();
+		for(; i + 32 <= _Count; i += 32)
+		{
+			const auto W = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_W + i));
+			const auto Abs = _mm256_abs_epi8(W);
+			Acc0 = _mm256_add_epi32(Acc0, quantMadd(Abs, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_X0 + i)), W));
+			Acc1 = _mm256_add_epi32(Acc1, quantMadd(Abs, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_X1 + i)), W));
+			Acc2 = _mm256_add_epi32(Acc2, quantMadd(Abs, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_X2 + i)), W));
+			Acc3 = _mm256_add_epi32(Acc3, quantMadd(Abs, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_X3 + i)), W));
+		}
+		_Sums[0] = quantSum(Acc0);
+		_Sums[1] = quantSum(Acc1);
+		_Sums[2] = quantSum(Acc2);
+		_Sums[3] = quantSum(Acc3);
+		#endif
+
+		for(; i < _Count; ++i)
+		{
+			_Sums[0] += i32(_W[i]) * i32(_X0[i]);
+			_Sums[1] += i32(_W[i]) * i32(_X1[i]);
+			_Sums[2] += i32(_W[i]) * i32(_X2[i]);
+			_Sums[3] += i32(_W[i]) * i32(_X3[i]);
+		}
+	}
+}
@@ -0,0 +1,388 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./SamplesShards.hpp"
+#include "./Network.hpp"
+#include "./Telemetry.hpp"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto SAMPLER_PREFETCH_DIST = uMAX(2); // Samples ahead to prefetch.
+	constexpr auto SAMPLER_PREFETCH_LINES = uMAX(8); // Cache lines to prefetch per sample, hardware picks up rest.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Random access samples source. Gather copies samples with given ids to _Dst, _Stride Ts apart. Referenced samples must outlive source.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> struct BatchSource
+	{
+		uMAX Count;
+		uMAX SampleSz; // In Ts.
+		std::function<void(const uMAX* _Ids, const uMAX _Count, T* _Dst, const uMAX _Stride)> Gather;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Prefetch start of sample.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto prefetchSample ( const void* _Data, const uMAX _Size ) -> void
+	{
+		const auto Data = static_cast<const char*>(_Data);
+		const auto Size = std::min(_Size, SAMPLER_PREFETCH_LINES * 64);
+		for(auto b = uMAX(0); b < Size; b += 64) __builtin_prefetch(Data + b);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Source over in memory samples.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto batchSource ( const vec<vec<T>>& _Samples ) -> BatchSource<T>
+	{
+		const auto SampleSz = _Samples.empty() ? uMAX(0) : uMAX(_Samples[0].size());
+		return BatchSource<T>{_Samples.size(), SampleSz, [&_Samples, SampleSz]( const uMAX* _Ids, const uMAX _Count, T* _Dst, const uMAX _Stride )
+		{
+			for(auto i = uMAX(0); i < _Count; ++i)
+			{
+				if(i + SAMPLER_PREFETCH_DIST < _Count) prefetchSample(_Samples[_Ids[i + SAMPLER_PREFETCH_DIST]].data(), SampleSz * sizeof(T));
+				memCopy(SampleSz, _Dst + i * _Stride, _Samples[_Ids[i]].data());
+			}
+		}};
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Source over memory mapped samples file.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto batchSource ( const SamplesMap<T>& _Samples ) -> BatchSource<T>
+	{
+		return BatchSource<T>{_Samples.size(), _Samples.sampleSz(), [&_Samples]( const uMAX* _Ids, const uMAX _Count, T* _Dst, const uMAX _Stride )
+		{
+			const auto Native = (_Samples.format() == SamplesFormat::NATIVE);
+			for(auto i = uMAX(0); i < _Count; ++i)
+			{
+				if(Native && (i + SAMPLER_PREFETCH_DIST < _Count)) prefetchSample(_Samples[_Ids[i + SAMPLER_PREFETCH_DIST]], _Samples.sampleSz() * sizeof(T));
+				_Samples.decode(_Ids[i], 1, _Dst + i * _Stride);
+			}
+		}};
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Source over sharded samples.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto batchSource ( const SamplesShards<T>& _Samples ) -> BatchSource<T>
+	{
+		return BatchSource<T>{_Samples.size(), _Samples.sampleSz(), [&_Samples]( const uMAX* _Ids, const uMAX _Count, T* _Dst, const uMAX _Stride )
+		{
+			if(!_Samples.gather(_Ids, _Count, _Dst, _Stride)) throw Error("sx"s, "BatchSource<T>"s, "Gather"s, 0, "Failed to read samples!"s);
+		}};
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Mini-batch. Samples are contiguous and aligned, Stride Ts apart.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> struct SamplesBatch
+	{
+		const T* Inputs;
+		const T* Targets; // Same as Inputs when sampler has no targets.
+		const uMAX* Ids; // Sample ids in source.
+		uMAX Count;
+		uMAX Stride; // Of inputs in Ts.
+		uMAX StrideTargets; // In Ts.
+
+		SamplesBatch ( void ) : Inputs(nullptr), Targets(nullptr), Ids(nullptr), Count(0), Stride(0), StrideTargets(0) {}
+		inline auto input ( const uMAX _Idx ) const -> const T* { return this->Inputs + _Idx * this->Stride; }
+		inline auto target ( const uMAX _Idx ) const -> const T* { return this->Targets + _Idx * this->StrideTargets; }
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Transform applied to every gathered batch, for example augmentation. Apply reads raw batch and writes inputs and targets
+	// of SampleSz and SampleSzTargets Ts, _Stride and _StrideTargets Ts apart. Raw targets are raw inputs when sampler has no targets.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> struct BatchStage
+	{
+		uMAX SampleSz; // In Ts.
+		uMAX SampleSzTargets; // In Ts.
+		std::function<void(const SamplesBatch<T>& _Raw, T* _Inputs, T* _Targets, const uMAX _Stride, const uMAX _StrideTargets)> Apply;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Shuffled mini-batch sampler. Every epoch visits samples in new random order, batches are gathered into aligned buffers.
+	// With _Ahead set, helper thread gathers next batch while current one is used. Optional stage runs on same thread after gather.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class BatchSampler
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Batch buffer.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Slot
+		{
+			T* Inputs;
+			T* Targets;
+			vec<uMAX> Ids;
+			uMAX Count;
+			bool Ready;
+			bool Last; // Last batch of epoch.
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		BatchSource<T> Inputs;
+		BatchSource<T> Targets;
+		BatchStage<T> Stage;
+		uMAX BatchSz;
+		uMAX Batches; // Per epoch.
+		uMAX Stride;
+		uMAX StrideTargets;
+		uMAX StrideRaw; // Of gathered batch when staged.
+		uMAX StrideRawTargets;
+		T* RawInputs;
+		T* RawTargets;
+		std::mt19937_64 Rng;
+		vec<uMAX> Order;
+		uMAX Produced; // Batches gathered since start.
+		uMAX Consumed; // Batches returned since start.
+		Slot Slots[2];
+		bool Held;
+		bool Ahead;
+		bool Quit;
+		bool Failed;
+		std::mutex Lock;
+		std::condition_variable Wake;
+		std::thread Helper;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor. Empty _Targets source means inputs are targets.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		BatchSampler ( const BatchSource<T>& _Inputs, const uMAX _BatchSz, const u64 _Seed = 0, const bool _Ahead = true, const BatchSource<T>& _Targets = BatchSource<T>(), const BatchStage<T>& _Stage = BatchStage<T>() ) :
+			Inputs(_Inputs),
+			Targets(_Targets),
+			Stage(_Stage),
+			BatchSz(std::max(_BatchSz, uMAX(1))),
+			Batches((_Inputs.Count + this->BatchSz - 1) / this->BatchSz),
+			Stride(samplesStride((_Stage.Apply ? _Stage.SampleSz : _Inputs.SampleSz) * sizeof(T)) / sizeof(T)),
+			StrideTargets(samplesStride((_Stage.Apply ? _Stage.SampleSzTargets : _Targets.SampleSz) * sizeof(T)) / sizeof(T)),
+			StrideRaw(samplesStride(_Inputs.SampleSz * sizeof(T)) / sizeof(T)),
+			StrideRawTargets(samplesStride(_Targets.SampleSz * sizeof(T)) / sizeof(T)),
+			RawInputs(nullptr),
+			RawTargets(nullptr),
+			Rng(_Seed),
+			Order(_Inputs.Count),
+			Produced(0),
+			Consumed(0),
+			Slots(),
+			Held(false),
+			Ahead(_Ahead),
+			Quit(false),
+			Failed(false),
+			Lock(),
+			Wake(),
+			Helper()
+		{
+			if(this->Inputs.Count == 0) throw Error("sx"s, "BatchSampler<T>"s, "BatchSampler"s, 0, "No samples!"s);
+			if(this->Targets.Gather && (this->Targets.Count != this->Inputs.Count)) throw Error("sx"s, "BatchSampler<T>"s, "BatchSampler"s, 1, "Inputs and targets differ in count!"s);
+
+			if(this->Stage.Apply)
+			{
+				this->RawInputs = static_cast<T*>(std::aligned_alloc(ALIGNMENT, this->BatchSz * this->StrideRaw * sizeof(T)));
+				this->RawTargets = this->Targets.Gather ? static_cast<T*>(std::aligned_alloc(ALIGNMENT, this->BatchSz * this->StrideRawTargets * sizeof(T))) : nullptr;
+			}
+
+			for(auto& S : this->Slots)
+			{
+				S.Inputs = static_cast<T*>(std::aligned_alloc(ALIGNMENT, this->BatchSz * this->Stride * sizeof(T)));
+				S.Targets = (this->Targets.Gather || this->Stage.Apply) ? static_cast<T*>(std::aligned_alloc(ALIGNMENT, this->BatchSz * this->StrideTargets * sizeof(T))) : nullptr;
+				S.Ids.resize(this->BatchSz);
+				S.Count = 0;
+				S.Ready = false;
+				S.Last = false;
+			}
+
+			std::iota(this->Order.begin(), this->Order.end(), uMAX(0));
+			if(this->Ahead) this->Helper = std::thread([this]( void ) { this->help(); });
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~BatchSampler ( void )
+		{
+			if(this->Helper.joinable())
+			{
+				{ auto Guard = std::lock_guard(this->Lock); this->Quit = true; }
+				this->Wake.notify_all();
+				this->Helper.join();
+			}
+
+			for(auto& S : this->Slots) { std::free(S.Inputs); std::free(S.Targets); }
+			std::free(this->RawInputs);
+			std::free(this->RawTargets);
+		}
+
+		BatchSampler ( const BatchSampler& ) = delete;
+		auto operator= ( const BatchSampler& ) -> BatchSampler& = delete;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Get next batch. Previously returned batch becomes invalid. Returns false once at end of every epoch, next call starts new epoch.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto next ( SamplesBatch<T>& _Batch ) -> bool
+		{
+			auto Guard = std::unique_lock(this->Lock);
+
+			// Hand previous slot back.
+			if(this->Held)
+			{
+				auto& Prev = this->Slots[(this->Consumed - 1) % 2];
+				const auto WasLast = Prev.Last;
+				Prev.Ready = false;
+				this->Held = false;
+				this->Wake.notify_all();
+				if(WasLast) return false;
+			}
+
+			auto& S = this->Slots[this->Consumed % 2];
+			if(this->Ahead) { SX_MC_TRACE("sampler", "wait"); this->Wake.wait(Guard, [&]( void ) { return S.Ready || this->Failed; }); }
+			else { this->fill(S); S.Ready = true; this->Produced++; }
+			if(!S.Ready) throw Error("sx"s, "BatchSampler<T>"s, "next"s, 0, "Failed to gather batch!"s);
+
+			_Batch.Inputs = S.Inputs;
+			_Batch.Targets = S.Targets ? S.Targets : S.Inputs;
+			_Batch.Ids = S.Ids.data();
+			_Batch.Count = S.Count;
+			_Batch.Stride = this->Stride;
+			_Batch.StrideTargets = S.Targets ? this->StrideTargets : this->Stride;
+
+			this->Consumed++;
+			this->Held = true;
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto size ( void ) const -> uMAX { return this->Inputs.Count; }
+		inline auto batchSz ( void ) const -> uMAX { return this->BatchSz; }
+		inline auto batches ( void ) const -> uMAX { return this->Batches; } // Per epoch.
+
+		private:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Gather next batch into its slot. Slot is not visible to consumer until marked ready.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto fill ( Slot& _Slot ) -> void
+		{
+			SX_MC_TRACE("sampler", "fill");
+
+			const auto Batch = this->Produced % this->Batches;
+			if(Batch == 0) std::shuffle(this->Order.begin(), this->Order.end(), this->Rng);
+
+			const auto First = Batch * this->BatchSz;
+			_Slot.Count = std::min(this->BatchSz, this->Inputs.Count - First);
+			std::copy(this->Order.begin() + First, this->Order.begin() + First + _Slot.Count, _Slot.Ids.begin());
+
+			if(this->Stage.Apply)
+			{
+				auto Raw = SamplesBatch<T>();
+				this->Inputs.Gather(_Slot.Ids.data(), _Slot.Count, this->RawInputs, this->StrideRaw);
+				if(this->RawTargets) this->Targets.Gather(_Slot.Ids.data(), _Slot.Count, this->RawTargets, this->StrideRawTargets);
+
+				Raw.Inputs = this->RawInputs;
+				Raw.Targets = this->RawTargets ? this->RawTargets : this->RawInputs;
+				Raw.Ids = _Slot.Ids.data();
+				Raw.Count = _Slot.Count;
+				Raw.Stride = this->StrideRaw;
+				Raw.StrideTargets = this->RawTargets ? this->StrideRawTargets : this->StrideRaw;
+				this->Stage.Apply(Raw, _Slot.Inputs, _Slot.Targets, this->Stride, this->StrideTargets);
+			}
+
+			else
+			{
+				this->Inputs.Gather(_Slot.Ids.data(), _Slot.Count, _Slot.Inputs, this->Stride);
+				if(_Slot.Targets) this->Targets.Gather(_Slot.Ids.data(), _Slot.Count, _Slot.Targets, this->StrideTargets);
+			}
+
+			_Slot.Last = (Batch + 1 == this->Batches);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Helper loop. Stays at most one batch ahead of consumer.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto help ( void ) -> void
+		{
+			traceThread("sampler");
+
+			while(true)
+			{
+				auto& S = this->Slots[this->Produced % 2];
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->Wake.wait(Guard, [&]( void ) { return this->Quit || !S.Ready; });
+					if(this->Quit) return;
+				}
+
+				auto Success = true;
+				try { this->fill(S); }
+				catch(...) { Success = false; }
+
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					if(Success) { S.Ready = true; this->Produced++; }
+					else this->Failed = true;
+				}
+				this->Wake.notify_all();
+				if(!Success) return;
+			}
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Train network on one batch. Batch passes every layer at once, deltas of all samples are applied together and reset for next batch. Returns mean error.
+	// With _Telemetry step loss and throughput are published, and layer norms when due.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, CompClass MODE> auto trainBatch ( Network<T,MODE>& _Net, const SamplesBatch<T>& _Batch, const T _ErrParam, const rMAX _Rate, const uMAX _Iter, Telemetry* _Telemetry = nullptr ) -> T
+	{
+		const auto Beg = _Telemetry ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+		_Net.connect();
+
+		_Net.exeBatch(_Batch.Inputs, _Batch.Stride, _Batch.Count, false);
+		const auto Err = _Net.errBatch(_Batch.Targets, _Batch.StrideTargets, _Batch.Count, false);
+		_Net.fitBatch(_Batch.Targets, _Batch.StrideTargets, _Batch.Count, _ErrParam, false);
+
+		if(_Telemetry) _Telemetry->publishLayers(_Net, _Iter);
+		_Net.apply(_Rate, _Iter, false);
+		_Net.reset(false);
+
+		if(_Telemetry) _Telemetry->publishStep(_Iter, Err, _Batch.Count, std::chrono::duration<r64>(std::chrono::steady_clock::now() - Beg).count());
+		return Err;
+	}
+}
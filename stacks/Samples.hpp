@@ -10,6 +10,10 @@
 #include <fx/Types.hpp>
 #include <fx/Image.hpp>
 #include <fx/Files.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "./Trace.hpp"
 
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -106,71 +110,173 @@ namespace sx
 
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Build samples cache from images.
+	// Load image and transform it into samples. Throws if image can not be decoded.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	template<class T> auto buildImageSamplesCache ( const str& _SrcDir, const str& _DstFile, const CfgBuildImgChc& _Cfg ) -> void
+	template<class T> auto buildImageSample ( const std::filesystem::path& _File, const CfgBuildImgChc& _Cfg ) -> vec<Image<T>>
 	{
-		// Open cache file.
-		std::cout << "Building samples cache from ["s << _SrcDir << "].\n"s; 
-		auto CacheFile = std::ofstream(_DstFile, std::ios::binary);
+		// Load image.
+		auto Img = Image<u8>(_File.string());
+
+
+		// Rescale image.
+		if((Img.width() != _Cfg.Width) || (Img.height() != _Cfg.Height)) Img = img::resize(Img, _Cfg.Width, _Cfg.Height);
 		
 
-		// Metadata.
-		auto SamplesCount = u64(0);
-		auto SampleSize = u64(0);
+		// Degrade image by downscaling and upscaling.
+		if(_Cfg.DownUp != 1)
+		{
+			Img = img::resize(Img, _Cfg.Width / _Cfg.DownUp, _Cfg.Height / _Cfg.DownUp);
+			Img = img::resize(Img, _Cfg.Width, _Cfg.Height);
+		}
 
-		if(_Cfg.SplitChannels) SampleSize = _Cfg.Width * _Cfg.Height * sizeof(T);
-		else SampleSize = _Cfg.Width * _Cfg.Height * 3 * sizeof(T);
 
+		// Convert to template type.
+		auto ImgT = Image<T>(Img); 
 
-		// Process images.
-		auto Files = files::buildFileList(_SrcDir, true);
-		for(auto& File : Files)
+
+		// Split channels. Convolutional layer needs sequential channels.
+		return img::split(ImgT);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Transform images into samples. Worker threads decode and transform images, calling thread passes them to _Consume in file list order.
+	// Workers run at most few images ahead of consumer, so memory use does not grow with number of images. Zero _Workers uses every core.
+	// _Consume ( const std::filesystem::path& File, const bool Success, vec<Image<T>>& Channels ) -> void.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, class FN> auto processImageSamples ( const vec<std::filesystem::path>& _Files, const CfgBuildImgChc& _Cfg, const uMAX _Workers, FN&& _Consume ) -> void
+	{
+		// Reorder window. Image i is stored in slot i % Window until consumed.
+		struct Slot
 		{
-			try
-			{
-				// Load image.
-				std::cout << "Processing ["s << File.string() << "].'\n"s; 
-				auto Img = Image<u8>(File.string());
+			bool Done;
+			bool Success;
+			vec<Image<T>> Channels;
+		};
 
+		const auto Workers = (_Workers != 0) ? _Workers : std::max(uMAX(std::thread::hardware_concurrency()), uMAX(1));
+		const auto Window = Workers * 4;
 
-				// Rescale image.
-				if((Img.width() != _Cfg.Width) || (Img.height() != _Cfg.Height)) Img = img::resize(Img, _Cfg.Width, _Cfg.Height);
-				
+		auto Slots = vec<Slot>(Window);
+		auto Next = uMAX(0); // Next image to claim.
+		auto Consumed = uMAX(0); // Images consumed.
+		auto Stop = false; // Consumer left early, workers take no more images.
+		auto Lock = std::mutex();
+		auto Ready = std::condition_variable(); // Signals consumer.
+		auto Room = std::condition_variable(); // Signals workers.
 
-				// Degrade image by downscaling and upscaling.
-				if(_Cfg.DownUp != 1)
+
+		// Process images.
+		auto Work = [&]( void )
+		{
+			while(true)
+			{
+				auto Idx = uMAX(0);
 				{
-					Img = img::resize(Img, _Cfg.Width / _Cfg.DownUp, _Cfg.Height / _Cfg.DownUp);
-					Img = img::resize(Img, _Cfg.Width, _Cfg.Height);
+					auto Guard = std::unique_lock(Lock);
+					Room.wait(Guard, [&]( void ) { return Stop || (Next >= _Files.size()) || (Next < Consumed + Window); });
+					if(Stop || (Next >= _Files.size())) return;
+					Idx = Next++;
 				}
 
+				auto Channels = vec<Image<T>>();
+				auto Success = true;
+				try { SX_MC_TRACE("image", "decode"); Channels = buildImageSample<T>(_Files[Idx], _Cfg); }
+				catch(...) { Success = false; }
 
-				// Convert to template type.
-				auto ImgT = Image<T>(Img); 
+				{
+					auto Guard = std::lock_guard(Lock);
+					auto& S = Slots[Idx % Window];
+					S.Channels = std::move(Channels);
+					S.Success = Success;
+					S.Done = true;
+				}
+				Ready.notify_all();
+			}
+		};
 
+		// Workers are stopped and joined on every exit, destroying joinable thread would terminate process.
+		auto Threads = vec<std::thread>();
+		const auto stop = [&]( void )
+		{
+			{
+				auto Guard = std::lock_guard(Lock);
+				Stop = true;
+			}
+			Room.notify_all();
+			for(auto& Thread : Threads) Thread.join();
+		};
 
-				// Split channels. Convolutional layer needs sequential channels.
-				auto ImgTC = img::split(ImgT);
 
+		// Consume in order.
+		try
+		{
+			for(auto w = uMAX(0); w < std::min(Workers, uMAX(_Files.size())); ++w) Threads.emplace_back(Work);
 
-				// Write samples to cache.
-				for(auto& Channel : ImgTC)
+			for(auto f = uMAX(0); f < _Files.size(); ++f)
+			{
+				auto Channels = vec<Image<T>>();
+				auto Success = false;
 				{
-					CacheFile.write(reinterpret_cast<const char*>(Channel.data()), _Cfg.Width * _Cfg.Height * sizeof(T));
-					if(_Cfg.SplitChannels) SamplesCount++;
+					auto Guard = std::unique_lock(Lock);
+					auto& S = Slots[f % Window];
+					Ready.wait(Guard, [&]( void ) { return S.Done; });
+
+					Channels = std::move(S.Channels);
+					Success = S.Success;
+					S.Channels.clear();
+					S.Done = false;
 				}
 
-				if(!_Cfg.SplitChannels) SamplesCount++;
+				_Consume(_Files[f], Success, Channels);
+				if(!Success) std::cout << "Failed ["s << _Files[f].string() << "]!\n"s;
+				if(((f + 1) % 1000 == 0) || (f + 1 == _Files.size())) std::cout << "Processed ["s << f + 1 << "/"s << _Files.size() << "].\n"s;
+
+				{
+					auto Guard = std::lock_guard(Lock);
+					Consumed = f + 1;
+				}
+				Room.notify_all();
 			}
+		}
+		catch(...) { stop(); throw; }
+
+		stop();
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Build samples cache from images. Images are decoded in parallel, see processImageSamples.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto buildImageSamplesCache ( const str& _SrcDir, const str& _DstFile, const CfgBuildImgChc& _Cfg, const uMAX _Workers = 0 ) -> void
+	{
+		// Open cache file.
+		std::cout << "Building samples cache from ["s << _SrcDir << "].\n"s; 
+		auto CacheFile = std::ofstream(_DstFile, std::ios::binary);
+		
 
+		// Metadata.
+		auto SamplesCount = u64(0);
+		auto SampleSize = u64(0);
 
-			catch(...)
+		if(_Cfg.SplitChannels) SampleSize = _Cfg.Width * _Cfg.Height * sizeof(T);
+		else SampleSize = _Cfg.Width * _Cfg.Height * 3 * sizeof(T);
+
+
+		// Process images.
+		processImageSamples<T>(files::buildFileList(_SrcDir, true), _Cfg, _Workers, [&]( const std::filesystem::path&, const bool _Success, vec<Image<T>>& _Channels )
+		{
+			if(!_Success) return;
+
+			// Write samples to cache.
+			for(auto& Channel : _Channels)
 			{
-				std::cout << "Failed ["s << File.string() << "]!\n"s;
-				continue;
+				CacheFile.write(reinterpret_cast<const char*>(Channel.data()), _Cfg.Width * _Cfg.Height * sizeof(T));
+				if(_Cfg.SplitChannels) SamplesCount++;
 			}
-		}
+
+			if(!_Cfg.SplitChannels) SamplesCount++;
+		});
 
 
 		// Write metadata.
@@ -0,0 +1,402 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Samples.hpp"
+#include "./Mmap.hpp"
+#include "./Convert.hpp"
+#include <cstddef>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto SAMPLES_MAGIC = u64(0x00534C504D535853); // "SXSMPLS".
+	constexpr auto SAMPLES_VERSION = u64(2);
+	constexpr auto SAMPLES_OFF_DATA = u64(4096); // Samples start on page boundary.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Storage format of samples.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class SamplesFormat : u64
+	{
+		NATIVE, // As T.
+		U8, // Bytes, decoded as Value * Scale + Offset.
+		F16 // Half floats, decoded as Value * Scale + Offset.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Samples file header. Samples follow at OffData, each one Stride bytes apart.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct SamplesHeader
+	{
+		u64 Magic;
+		u64 Version;
+		u64 SzHeader;
+		u64 SzT; // Of stored element.
+		u64 IsFloat; // Of stored element.
+		u64 Count;
+		u64 SampleSz; // In bytes.
+		u64 Stride; // In bytes. Multiple of ALIGNMENT.
+		u64 OffData;
+		SamplesFormat Format; // Version 2.
+		r64 Scale; // Version 2.
+		r64 Offset; // Version 2.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Stride of sample in bytes.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr inline auto samplesStride ( const u64 _SampleSz ) -> u64 { return ((_SampleSz + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT; }
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Size of stored element in bytes.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> constexpr inline auto samplesElemSz ( const SamplesFormat _Format ) -> u64
+	{
+		if(_Format == SamplesFormat::U8) return sizeof(u8);
+		if(_Format == SamplesFormat::F16) return sizeof(u16);
+		return sizeof(T);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Stride of sample decoded to T in Ts.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> inline auto samplesDecodedStride ( const SamplesHeader& _Header ) -> uMAX
+	{
+		return samplesStride((_Header.SampleSz / _Header.SzT) * sizeof(T)) / sizeof(T);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Validate samples file header against T and file size. Version 1 files have no format fields,
+	// writer zero fills header block so they read as native.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto samplesValid ( const SamplesHeader& _Header, const uMAX _FileSz ) -> bool
+	{
+		const auto Native = (_Header.Format == SamplesFormat::NATIVE);
+		const auto SzHeader = (_Header.Version == 1) ? offsetof(SamplesHeader, Format) : sizeof(SamplesHeader);
+
+		auto Valid = true;
+		Valid = Valid && (_Header.Magic == SAMPLES_MAGIC);
+		Valid = Valid && ((_Header.Version == 1) || (_Header.Version == SAMPLES_VERSION));
+		Valid = Valid && (_Header.SzHeader == SzHeader);
+		Valid = Valid && (_Header.Format <= SamplesFormat::F16);
+		Valid = Valid && (Native || std::is_floating_point_v<T>);
+		Valid = Valid && (_Header.SzT == samplesElemSz<T>(_Header.Format));
+		Valid = Valid && (!Native || (_Header.IsFloat == u64(std::is_floating_point_v<T>)));
+		Valid = Valid && (_Header.SampleSz % _Header.SzT == 0);
+		Valid = Valid && (_Header.Stride != 0) && (_Header.Stride % ALIGNMENT == 0) && (_Header.Stride >= _Header.SampleSz);
+		Valid = Valid && (_Header.OffData >= sizeof(SamplesHeader)) && (_Header.OffData % ALIGNMENT == 0) && (_Header.OffData <= _FileSz);
+		Valid = Valid && (_Header.Count <= (_FileSz - _Header.OffData) / _Header.Stride); // Sums and products of header fields could overflow.
+		return Valid;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Decode _Count consecutive samples starting at _Src to T. _DstStride is in Ts.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto samplesDecode ( const SamplesHeader& _Header, const u8* _Src, const uMAX _Count, T* _Dst, const uMAX _DstStride ) -> void
+	{
+		const auto Elems = _Header.SampleSz / _Header.SzT;
+
+		for(auto s = uMAX(0); s < _Count; ++s)
+		{
+			const auto Src = _Src + s * _Header.Stride;
+			const auto Dst = _Dst + s * _DstStride;
+
+			if(_Header.Format == SamplesFormat::U8) widenU8(Elems, Src, Dst, _Header.Scale, _Header.Offset);
+			else if(_Header.Format == SamplesFormat::F16) widenF16(Elems, reinterpret_cast<const u16*>(Src), Dst, _Header.Scale, _Header.Offset);
+			else memCopy(Elems, Dst, reinterpret_cast<const T*>(Src));
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Sequential samples file writer. Header is rewritten with final count on close.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class SamplesWriter
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		std::ofstream File;
+		SamplesHeader Header;
+		vec<char> Padding;
+		vec<u8> Buffer; // Quantized sample.
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SamplesWriter ( void ) : File(), Header(), Padding(), Buffer() {}
+		SamplesWriter ( const str& _File, const uMAX _SampleSz, const SamplesFormat _Format = SamplesFormat::NATIVE, const r64 _Scale = 1.0, const r64 _Offset = 0.0 ) : SamplesWriter() { this->open(_File, _SampleSz, _Format, _Scale, _Offset); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~SamplesWriter ( void ) { this->close(); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Create file for samples of _SampleSz Ts. Quantized formats store (Value - _Offset) / _Scale.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto open ( const str& _File, const uMAX _SampleSz, const SamplesFormat _Format = SamplesFormat::NATIVE, const r64 _Scale = 1.0, const r64 _Offset = 0.0 ) -> bool
+		{
+			this->close();
+			if((_Format != SamplesFormat::NATIVE) && (!std::is_floating_point_v<T> || (_Scale == 0.0))) return false;
+
+			this->Header = SamplesHeader();
+			this->Header.Magic = SAMPLES_MAGIC;
+			this->Header.Version = SAMPLES_VERSION;
+			this->Header.SzHeader = sizeof(SamplesHeader);
+			this->Header.SzT = samplesElemSz<T>(_Format);
+			this->Header.IsFloat = u64((_Format == SamplesFormat::NATIVE) ? std::is_floating_point_v<T> : (_Format == SamplesFormat::F16));
+			this->Header.Count = 0;
+			this->Header.SampleSz = _SampleSz * this->Header.SzT;
+			this->Header.Stride = samplesStride(this->Header.SampleSz);
+			this->Header.OffData = SAMPLES_OFF_DATA;
+			this->Header.Format = _Format;
+			this->Header.Scale = _Scale;
+			this->Header.Offset = _Offset;
+			this->Padding.assign(this->Header.Stride - this->Header.SampleSz, 0);
+			this->Buffer.assign(this->Header.SampleSz, 0);
+
+			this->File.open(_File, std::ios::binary | std::ios::trunc);
+			if(!this->File.is_open()) return false;
+
+			this->File.write(reinterpret_cast<const char*>(&this->Header), sizeof(SamplesHeader));
+			while(u64(this->File.tellp()) < this->Header.OffData) this->File.put(0);
+			return this->File.good();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Append sample.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto push ( const T* _Sample ) -> void
+		{
+			const auto Elems = this->Header.SampleSz / this->Header.SzT;
+			auto Data = reinterpret_cast<const char*>(_Sample);
+
+			if(this->Header.Format == SamplesFormat::U8) { narrowU8(Elems, _Sample, this->Buffer.data(), this->Header.Scale, this->Header.Offset); Data = reinterpret_cast<const char*>(this->Buffer.data()); }
+			if(this->Header.Format == SamplesFormat::F16) { narrowF16(Elems, _Sample, reinterpret_cast<u16*>(this->Buffer.data()), this->Header.Scale, this->Header.Offset); Data = reinterpret_cast<const char*>(this->Buffer.data()); }
+
+			this->File.write(Data, this->Header.SampleSz);
+			if(!this->Padding.empty()) this->File.write(this->Padding.data(), this->Padding.size());
+			this->Header.Count++;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Finish file. Returns false if any write failed.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto close ( void ) -> bool
+		{
+			if(!this->File.is_open()) return true;
+
+			this->File.seekp(0);
+			this->File.write(reinterpret_cast<const char*>(&this->Header), sizeof(SamplesHeader));
+			const auto Success = this->File.good();
+			this->File.close();
+			return Success;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto count ( void ) const -> uMAX { return this->Header.Count; }
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Memory mapped samples file. Samples are aligned, contiguous and read straight from page cache without copying.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class SamplesMap
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		FileMap Map;
+		const SamplesHeader* Header;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Raw access reinterprets stored bytes as T, which is only right for native format.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto native ( const char* _Func ) const -> void
+		{
+			if(this->Header->Format != SamplesFormat::NATIVE) throw fx::Error("sx"s, "SamplesMap<T>"s, str(_Func), 0, "Native format only, use decode!"s);
+		}
+
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SamplesMap ( void ) : Map(), Header(nullptr) {}
+		SamplesMap ( const str& _File ) : Map(), Header(nullptr) { this->open(_File); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Map and validate file.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto open ( const str& _File ) -> bool
+		{
+			this->Header = nullptr;
+			if(!this->Map.open(_File) || (this->Map.size() < sizeof(SamplesHeader))) { this->Map.close(); return false; }
+
+			const auto Header = this->Map.template at<SamplesHeader>(0);
+			if(!samplesValid<T>(*Header, this->Map.size())) { this->Map.close(); return false; }
+
+			this->Header = Header;
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Decode _Count samples starting at _First to T. Works for every format. _DstStride is in Ts, zero means packed.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto decode ( const uMAX _First, const uMAX _Count, T* _Dst, const uMAX _DstStride = 0 ) const -> void
+		{
+			const auto Src = this->Map.data() + this->Header->OffData + _First * this->Header->Stride;
+			samplesDecode(*this->Header, Src, _Count, _Dst, (_DstStride != 0) ? _DstStride : this->sampleSz());
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Hint access pattern of whole file. Takes MADV_* value.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto advise ( const int _Advice ) const -> void { this->Map.advise(_Advice, this->Header->OffData); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto isOpen ( void ) const -> bool { return this->Header != nullptr; }
+		inline auto size ( void ) const -> uMAX { return this->Header->Count; }
+		inline auto header ( void ) const -> const SamplesHeader& { return *this->Header; }
+		inline auto format ( void ) const -> SamplesFormat { return this->Header->Format; }
+		inline auto sampleSz ( void ) const -> uMAX { return this->Header->SampleSz / this->Header->SzT; } // In Ts.
+		inline auto stride ( void ) const -> uMAX { this->native("stride"); return this->Header->Stride / sizeof(T); } // In Ts. Native format only, throws otherwise.
+		inline auto data ( void ) const -> const T* { this->native("data"); return this->Map.template at<T>(this->Header->OffData); } // Native format only, throws otherwise.
+		inline auto operator[] ( const uMAX _Idx ) const -> const T* { this->native("operator[]"); return this->Map.template at<T>(this->Header->OffData + _Idx * this->Header->Stride); } // Native format only, throws otherwise.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Store samples to mapped samples file.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto storeSamplesMap ( const str& _File, const vec<vec<T>>& _Samples, const SamplesFormat _Format = SamplesFormat::NATIVE, const r64 _Scale = 1.0, const r64 _Offset = 0.0 ) -> bool
+	{
+		if(_Samples.empty()) return false;
+
+		auto Writer = SamplesWriter<T>();
+		if(!Writer.open(_File, _Samples[0].size(), _Format, _Scale, _Offset)) return false;
+		for(const auto& Sample : _Samples) Writer.push(Sample.data());
+		return Writer.close();
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Convert samples cache with trailing metadata to mapped samples file. Streams one sample at time.
+	// Output is written to temporary file and renamed over _File once complete, so failure never leaves truncated file that passes validation.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto convertSamplesCache ( const str& _CacheFile, const str& _File, const SamplesFormat _Format = SamplesFormat::NATIVE, const r64 _Scale = 1.0, const r64 _Offset = 0.0 ) -> bool
+	{
+		auto CacheFile = std::ifstream(_CacheFile, std::ios::binary);
+		if(!CacheFile.is_open()) return false;
+
+		auto SamplesCount = u64(0);
+		auto SampleSize = u64(0);
+		CacheFile.seekg(-(sizeof(u64)*2), CacheFile.end);
+		CacheFile.read(reinterpret_cast<char*>(&SamplesCount), sizeof(u64));
+		CacheFile.read(reinterpret_cast<char*>(&SampleSize), sizeof(u64));
+		CacheFile.seekg(0, CacheFile.beg);
+		if(!CacheFile || (SampleSize == 0) || (SampleSize % sizeof(T) != 0)) return false;
+
+		const auto Temp = _File + ".tmp"s;
+		const auto write = [&]( void ) -> bool
+		{
+			auto Writer = SamplesWriter<T>();
+			if(!Writer.open(Temp, SampleSize / sizeof(T), _Format, _Scale, _Offset)) return false;
+
+			auto Sample = vec<T>(SampleSize / sizeof(T));
+			for(auto s = uMAX(0); s < SamplesCount; ++s)
+			{
+				CacheFile.read(reinterpret_cast<char*>(Sample.data()), SampleSize);
+				if(!CacheFile) return false;
+				Writer.push(Sample.data());
+			}
+
+			return Writer.close();
+		};
+
+		auto Success = write();
+		auto Ec = std::error_code();
+		if(Success) { std::filesystem::rename(Temp, _File, Ec); Success = !Ec; }
+		if(!Success) std::filesystem::remove(Temp, Ec);
+		return Success;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Size of one image sample in elements.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto imageSampleSz ( const CfgBuildImgChc& _Cfg ) -> uMAX { return _Cfg.SplitChannels ? (_Cfg.Width * _Cfg.Height) : (_Cfg.Width * _Cfg.Height * 3); }
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Write channels of one image as samples. _Sample is scratch space for joining channels.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto pushImageSamples ( SamplesWriter<T>& _Writer, const CfgBuildImgChc& _Cfg, vec<Image<T>>& _Channels, vec<T>& _Sample ) -> void
+	{
+		if(_Cfg.SplitChannels) { for(auto& Channel : _Channels) _Writer.push(Channel.data()); return; }
+
+		const auto SzChannel = _Cfg.Width * _Cfg.Height;
+		_Sample.resize(SzChannel * 3);
+		for(auto c = uMAX(0); c < std::min(_Channels.size(), uMAX(3)); ++c) memCopy(SzChannel, _Sample.data() + c * SzChannel, _Channels[c].data());
+		_Writer.push(_Sample.data());
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Build samples file from list of images. Images are decoded in parallel, see processImageSamples. Default scale suits images converted to [0, 1].
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto buildImageSamplesMap ( const vec<std::filesystem::path>& _Files, const str& _DstFile, const CfgBuildImgChc& _Cfg, const SamplesFormat _Format = SamplesFormat::NATIVE, const r64 _Scale = 1.0 / 255.0, const r64 _Offset = 0.0, const uMAX _Workers = 0 ) -> bool
+	{
+		auto Writer = SamplesWriter<T>();
+		if(!Writer.open(_DstFile, imageSampleSz(_Cfg), _Format, _Scale, _Offset)) return false;
+
+		auto Sample = vec<T>();
+		processImageSamples<T>(_Files, _Cfg, _Workers, [&]( const std::filesystem::path&, const bool _Success, vec<Image<T>>& _Channels )
+		{
+			if(_Success) pushImageSamples(Writer, _Cfg, _Channels, Sample);
+		});
+
+		return Writer.close();
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Build samples file from images in directory.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto buildImageSamplesMap ( const str& _SrcDir, const str& _DstFile, const CfgBuildImgChc& _Cfg, const SamplesFormat _Format = SamplesFormat::NATIVE, const r64 _Scale = 1.0 / 255.0, const r64 _Offset = 0.0, const uMAX _Workers = 0 ) -> bool
+	{
+		std::cout << "Building samples file from ["s << _SrcDir << "].\n"s;
+		return buildImageSamplesMap<T>(files::buildFileList(_SrcDir, true), _DstFile, _Cfg, _Format, _Scale, _Offset, _Workers);
+	}
+}
@@ -0,0 +1,384 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./SamplesMap.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <filesystem>
+#include <thread>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto SHARDS_MAGIC = u64(0x0044524148535853); // "SXSHARD".
+	constexpr auto SHARDS_VERSION = u64(1);
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Shard index header. Followed by shard paths, each as u64 length and characters padded to 8 bytes,
+	// then by one entry per sample at OffEntries.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ShardsHeader
+	{
+		u64 Magic;
+		u64 Version;
+		u64 SzHeader;
+		u64 Count; // Samples.
+		u64 Shards;
+		u64 OffEntries;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Location of one sample.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ShardEntry
+	{
+		u64 Shard;
+		u64 Offset; // In bytes from start of shard file.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Shard file name for given prefix.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto shardFile ( const str& _Prefix, const uMAX _Shard ) -> str
+	{
+		auto Idx = std::to_string(_Shard);
+		if(Idx.size() < 4) Idx.insert(0, 4 - Idx.size(), '0');
+		return _Prefix + "."s + Idx + ".sxs"s;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Shard file names for given prefix.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto shardFiles ( const str& _Prefix, const uMAX _Shards ) -> vec<str>
+	{
+		auto Files = vec<str>();
+		for(auto s = uMAX(0); s < _Shards; ++s) Files.push_back(shardFile(_Prefix, s));
+		return Files;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Check samples in two headers decode same way.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto samplesCompatible ( const SamplesHeader& _A, const SamplesHeader& _B ) -> bool
+	{
+		return (_A.SzT == _B.SzT) && (_A.IsFloat == _B.IsFloat) && (_A.SampleSz == _B.SampleSz) && (_A.Format == _B.Format) && (_A.Scale == _B.Scale) && (_A.Offset == _B.Offset);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Write index with given entries. Shards next to index are stored by name only, others by absolute path.
+	// Index is written under temporary name and renamed, readers never see partial index.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto storeShardsIndex ( const str& _IndexFile, const vec<str>& _Shards, const vec<ShardEntry>& _Entries ) -> bool
+	{
+		namespace fs = std::filesystem;
+
+
+		// Shard paths.
+		auto Code = std::error_code();
+		const auto IndexDir = fs::weakly_canonical(fs::absolute(_IndexFile), Code).parent_path();
+
+		auto Paths = vec<str>();
+		for(const auto& Shard : _Shards)
+		{
+			const auto Path = fs::weakly_canonical(fs::absolute(Shard), Code);
+			Paths.push_back((Path.parent_path() == IndexDir) ? Path.filename().string() : Path.string());
+		}
+
+
+		// Write index.
+		const auto IndexTmp = _IndexFile + ".tmp"s;
+		auto File = std::ofstream(IndexTmp, std::ios::binary | std::ios::trunc);
+		if(!File.is_open()) return false;
+
+		auto Header = ShardsHeader();
+		Header.Magic = SHARDS_MAGIC;
+		Header.Version = SHARDS_VERSION;
+		Header.SzHeader = sizeof(ShardsHeader);
+		Header.Count = _Entries.size();
+		Header.Shards = _Shards.size();
+		Header.OffEntries = sizeof(ShardsHeader);
+		for(const auto& Path : Paths) Header.OffEntries += sizeof(u64) + ((Path.size() + 7) / 8) * 8;
+		Header.OffEntries = ((Header.OffEntries + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+
+		File.write(reinterpret_cast<const char*>(&Header), sizeof(ShardsHeader));
+		for(const auto& Path : Paths)
+		{
+			const auto Len = u64(Path.size());
+			File.write(reinterpret_cast<const char*>(&Len), sizeof(u64));
+			File.write(Path.data(), Path.size());
+			for(auto p = Path.size(); p % 8 != 0; ++p) File.put(0);
+		}
+
+		while(u64(File.tellp()) < Header.OffEntries) File.put(0);
+		File.write(reinterpret_cast<const char*>(_Entries.data()), _Entries.size() * sizeof(ShardEntry));
+
+		File.close();
+		if(!File || (std::rename(IndexTmp.c_str(), _IndexFile.c_str()) != 0)) { std::remove(IndexTmp.c_str()); return false; }
+		return true;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Write index over every sample of samples files. Global ids follow shard order.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto storeShardsIndex ( const str& _IndexFile, const vec<str>& _Shards ) -> bool
+	{
+		if(_Shards.empty()) return false;
+
+		auto Entries = vec<ShardEntry>();
+		auto First = SamplesHeader();
+
+		for(auto s = uMAX(0); s < _Shards.size(); ++s)
+		{
+			const auto Shard = SamplesMap<T>(_Shards[s]);
+			if(!Shard.isOpen()) return false;
+
+			const auto& Header = Shard.header();
+			if(s == 0) First = Header;
+			if(!samplesCompatible(First, Header)) return false;
+
+			for(auto i = uMAX(0); i < Header.Count; ++i) Entries.push_back(ShardEntry{s, Header.OffData + i * Header.Stride});
+		}
+
+		return storeShardsIndex(_IndexFile, _Shards, Entries);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Sharded samples. Index is memory mapped, samples are fetched with pread so any number of threads can read at random ids concurrently.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class SamplesShards
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		FileMap Index;
+		const ShardsHeader* Header;
+		const ShardEntry* Entries;
+		SamplesHeader Sample; // Header of first shard, every shard decodes same way.
+		vec<int> Fds;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SamplesShards ( void ) : Index(), Header(nullptr), Entries(nullptr), Sample(), Fds() {}
+		SamplesShards ( const str& _IndexFile ) : SamplesShards() { this->open(_IndexFile); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~SamplesShards ( void ) { this->close(); }
+
+		SamplesShards ( const SamplesShards& ) = delete;
+		auto operator= ( const SamplesShards& ) -> SamplesShards& = delete;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Open index and every shard.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto open ( const str& _IndexFile ) -> bool
+		{
+			namespace fs = std::filesystem;
+			this->close();
+
+
+			// Map and validate index.
+			if(!this->Index.open(_IndexFile) || (this->Index.size() < sizeof(ShardsHeader))) return this->fail();
+
+			const auto Header = this->Index.template at<ShardsHeader>(0);
+			auto Valid = true;
+			Valid = Valid && (Header->Magic == SHARDS_MAGIC);
+			Valid = Valid && (Header->Version == SHARDS_VERSION);
+			Valid = Valid && (Header->SzHeader == sizeof(ShardsHeader));
+			Valid = Valid && (Header->Shards != 0);
+			Valid = Valid && (Header->OffEntries % alignof(ShardEntry) == 0);
+			Valid = Valid && (Header->OffEntries <= this->Index.size()) && (Header->Count <= (this->Index.size() - Header->OffEntries) / sizeof(ShardEntry));
+			if(!Valid) return this->fail();
+
+
+			// Open shards.
+			const auto IndexDir = fs::path(_IndexFile).parent_path();
+			auto Sizes = vec<uMAX>();
+			auto Off = uMAX(sizeof(ShardsHeader));
+
+			for(auto s = uMAX(0); s < Header->Shards; ++s)
+			{
+				if(Off + sizeof(u64) > Header->OffEntries) return this->fail();
+				const auto Len = *this->Index.template at<u64>(Off);
+				if(Len > Header->OffEntries - Off - sizeof(u64)) return this->fail();
+
+				auto Path = fs::path(str(this->Index.template at<char>(Off + sizeof(u64)), Len));
+				if(Path.is_relative()) Path = IndexDir / Path;
+				Off += sizeof(u64) + ((Len + 7) / 8) * 8;
+
+				const auto Fd = ::open(Path.c_str(), O_RDONLY);
+				if(Fd < 0) return this->fail();
+				this->Fds.push_back(Fd);
+
+				struct stat Stat;
+				auto Shard = SamplesHeader();
+				if((fstat(Fd, &Stat) != 0) || !readAll(Fd, &Shard, sizeof(SamplesHeader), 0)) return this->fail();
+				if(!samplesValid<T>(Shard, uMAX(Stat.st_size))) return this->fail();
+
+				if(s == 0) this->Sample = Shard;
+				if(!samplesCompatible(this->Sample, Shard)) return this->fail();
+
+				Sizes.push_back(uMAX(Stat.st_size));
+				posix_fadvise(Fd, 0, 0, POSIX_FADV_RANDOM);
+			}
+
+
+			// Check every entry points inside its shard.
+			const auto Entries = this->Index.template at<ShardEntry>(Header->OffEntries);
+			for(auto i = uMAX(0); i < Header->Count; ++i)
+			{
+				const auto& E = Entries[i];
+				if((E.Shard >= Header->Shards) || (E.Offset > Sizes[E.Shard]) || (Sizes[E.Shard] - E.Offset < this->Sample.SampleSz)) return this->fail();
+			}
+
+			this->Index.advise(MADV_RANDOM, Header->OffEntries);
+			this->Header = Header;
+			this->Entries = Entries;
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Close index and shards.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto close ( void ) -> void
+		{
+			for(const auto Fd : this->Fds) ::close(Fd);
+			this->Fds.clear();
+			this->Index.close();
+			this->Header = nullptr;
+			this->Entries = nullptr;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Read sample to _Dst decoded to T. Safe to call from many threads.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto read ( const uMAX _Id, T* _Dst ) const -> bool
+		{
+			if(_Id >= this->Header->Count) return false;
+			const auto& E = this->Entries[_Id];
+
+			if(this->Sample.Format == SamplesFormat::NATIVE) return readAll(this->Fds[E.Shard], _Dst, this->Sample.SampleSz, E.Offset);
+
+			thread_local auto Scratch = vec<u8>();
+			Scratch.resize(this->Sample.SampleSz);
+			if(!readAll(this->Fds[E.Shard], Scratch.data(), this->Sample.SampleSz, E.Offset)) return false;
+
+			samplesDecode(this->Sample, Scratch.data(), 1, _Dst, this->sampleSz());
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Read samples with given ids, for example shuffled mini-batch. _DstStride is in Ts, zero means packed.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto gather ( const uMAX* _Ids, const uMAX _Count, T* _Dst, const uMAX _DstStride = 0 ) const -> bool
+		{
+			const auto Stride = (_DstStride != 0) ? _DstStride : this->sampleSz();
+			for(auto i = uMAX(0); i < _Count; ++i) if(!this->read(_Ids[i], _Dst + i * Stride)) return false;
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto isOpen ( void ) const -> bool { return this->Header != nullptr; }
+		inline auto size ( void ) const -> uMAX { return this->Header->Count; }
+		inline auto shards ( void ) const -> uMAX { return this->Header->Shards; }
+		inline auto format ( void ) const -> SamplesFormat { return this->Sample.Format; }
+		inline auto sampleSz ( void ) const -> uMAX { return this->Sample.SampleSz / this->Sample.SzT; } // In Ts.
+		inline auto entry ( const uMAX _Id ) const -> const ShardEntry& { return this->Entries[_Id]; }
+
+		private:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Release everything after failed open.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto fail ( void ) -> bool { this->close(); return false; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Read whole range at offset. Does not touch file position.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto readAll ( const int _Fd, void* _Dst, const uMAX _Size, const uMAX _Offset ) -> bool
+		{
+			auto Dst = static_cast<char*>(_Dst);
+			auto Done = uMAX(0);
+
+			while(Done < _Size)
+			{
+				const auto Got = ::pread(_Fd, Dst + Done, _Size - Done, _Offset + Done);
+				if(Got < 0) { if(errno == EINTR) continue; return false; }
+				if(Got == 0) return false;
+				Done += uMAX(Got);
+			}
+
+			return true;
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Build sharded samples from images. Images are split into contiguous runs, one per shard, and shards are built concurrently,
+	// each by its own writer with share of workers. Global ids follow file list order. Zero _Workers uses every core.
+	// Shard that throws is reported and counts as failed.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto buildImageSamplesShards ( const str& _SrcDir, const str& _IndexFile, const vec<str>& _Shards, const CfgBuildImgChc& _Cfg, const SamplesFormat _Format = SamplesFormat::NATIVE, const r64 _Scale = 1.0 / 255.0, const r64 _Offset = 0.0, const uMAX _Workers = 0 ) -> bool
+	{
+		if(_Shards.empty()) return false;
+		std::cout << "Building "s << _Shards.size() << " samples shards from ["s << _SrcDir << "].\n"s;
+
+		const auto Files = files::buildFileList(_SrcDir, true);
+		const auto Workers = (_Workers != 0) ? _Workers : std::max(uMAX(std::thread::hardware_concurrency()), uMAX(1));
+		const auto WorkersShard = std::max(Workers / _Shards.size(), uMAX(1));
+
+		auto Success = vec<u8>(_Shards.size(), 0);
+		auto Threads = vec<std::thread>();
+
+		const auto build = [&]( const uMAX _Shard )
+		{
+			const auto Beg = Files.begin() + (_Shard * Files.size()) / _Shards.size();
+			const auto End = Files.begin() + ((_Shard + 1) * Files.size()) / _Shards.size();
+
+			try { Success[_Shard] = buildImageSamplesMap<T>(vec<std::filesystem::path>(Beg, End), _Shards[_Shard], _Cfg, _Format, _Scale, _Offset, WorkersShard); }
+			catch(const std::exception& _Error) { std::cout << "Failed to build shard ["s + _Shards[_Shard] + "], "s + _Error.what() + "!\n"s; }
+			catch(...) { std::cout << "Failed to build shard ["s + _Shards[_Shard] + "]!\n"s; }
+		};
+
+		try { for(auto s = uMAX(0); s < _Shards.size(); ++s) Threads.emplace_back(build, s); }
+		catch(...) { for(auto& Thread : Threads) Thread.join(); throw; }
+
+		for(auto& Thread : Threads) Thread.join();
+
+		if(std::find(Success.begin(), Success.end(), 0) != Success.end()) return false;
+		return storeShardsIndex<T>(_IndexFile, _Shards);
+	}
+}
@@ -0,0 +1,285 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./SamplesMap.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto STREAM_BLOCK = uMAX(4096); // Read granularity required by direct I/O.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// View of consecutive samples.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> struct SamplesChunk
+	{
+		const T* Data;
+		uMAX Count; // Samples in chunk.
+		uMAX Stride; // In Ts.
+		uMAX First; // Index of first sample in file.
+
+		SamplesChunk ( void ) : Data(nullptr), Count(0), Stride(0), First(0) {}
+		inline auto operator[] ( const uMAX _Idx ) const -> const T* { return this->Data + _Idx * this->Stride; }
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Streaming samples file reader. Background thread reads fixed size chunks into ring of aligned buffers,
+	// so next chunk is ready before current one is consumed. Memory use is independent of file size.
+	// Quantized samples are decoded to T by loader thread, chunks always hold Ts.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class SamplesStream
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Ring slot.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Slot
+		{
+			u8* Buffer;
+			T* Decoded; // Quantized formats only.
+			SamplesChunk<T> Chunk;
+			bool Ready;
+			bool Last; // Last chunk of pass.
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		int Fd;
+		bool Direct;
+		bool DropCache; // Drop pages of buffered reads once consumed.
+		SamplesHeader Header;
+		uMAX ChunkSamples;
+		uMAX Chunks;
+		uMAX SzBuffer;
+		uMAX StrideT; // Stride of chunk samples in Ts.
+		vec<Slot> Ring;
+		uMAX Read; // Chunks consumed since open.
+		bool Held; // Consumer holds slot of last returned chunk.
+		bool Quit;
+		bool Failed;
+		std::mutex Lock;
+		std::condition_variable Wake;
+		std::thread Loader;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SamplesStream ( void ) : Fd(-1), Direct(false), DropCache(false), Header(), ChunkSamples(0), Chunks(0), SzBuffer(0), StrideT(0), Ring(), Read(0), Held(false), Quit(false), Failed(false) {}
+		SamplesStream ( const str& _File, const uMAX _ChunkSamples = 1024, const uMAX _Buffers = 2, const bool _Direct = false, const bool _DropCache = false ) : SamplesStream() { this->open(_File, _ChunkSamples, _Buffers, _Direct, _DropCache); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~SamplesStream ( void ) { this->close(); }
+
+		SamplesStream ( const SamplesStream& ) = delete;
+		auto operator= ( const SamplesStream& ) -> SamplesStream& = delete;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Open samples file and start loading. _Direct bypasses page cache when file system supports it.
+		// _DropCache evicts pages of buffered reads behind loader, for datasets larger than memory. Off by default, since it also evicts
+		// pages other readers of same file would reuse.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto open ( const str& _File, const uMAX _ChunkSamples = 1024, const uMAX _Buffers = 2, const bool _Direct = false, const bool _DropCache = false ) -> bool
+		{
+			this->close();
+			this->DropCache = _DropCache;
+
+
+			// Open file. Direct I/O falls back to buffered reads where unsupported.
+			this->Direct = _Direct;
+			if(this->Direct) this->Fd = ::open(_File.c_str(), O_RDONLY | O_DIRECT);
+			if(this->Fd < 0) { this->Direct = false; this->Fd = ::open(_File.c_str(), O_RDONLY); }
+			if(this->Fd < 0) return false;
+
+			struct stat Stat;
+			auto Block = static_cast<u8*>(std::aligned_alloc(STREAM_BLOCK, STREAM_BLOCK));
+			const auto Valid = (fstat(this->Fd, &Stat) == 0) && (::pread(this->Fd, Block, STREAM_BLOCK, 0) >= iMAX(sizeof(SamplesHeader)));
+			if(Valid) std::memcpy(&this->Header, Block, sizeof(SamplesHeader));
+			std::free(Block);
+
+			if(!Valid || !samplesValid<T>(this->Header, uMAX(Stat.st_size)) || (this->Header.Count == 0)) { ::close(this->Fd); this->Fd = -1; return false; }
+			if(!this->Direct) posix_fadvise(this->Fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+
+			// Allocate ring. Buffers have room to round reads out to block boundaries.
+			this->ChunkSamples = std::clamp(_ChunkSamples, uMAX(1), uMAX(this->Header.Count));
+			this->Chunks = (this->Header.Count + this->ChunkSamples - 1) / this->ChunkSamples;
+			this->SzBuffer = ((this->ChunkSamples * this->Header.Stride + STREAM_BLOCK - 1) / STREAM_BLOCK + 1) * STREAM_BLOCK;
+			this->StrideT = samplesDecodedStride<T>(this->Header);
+
+			const auto Quantized = (this->Header.Format != SamplesFormat::NATIVE);
+			const auto SzDecoded = this->ChunkSamples * this->StrideT * sizeof(T);
+
+			this->Ring.resize(std::max(_Buffers, uMAX(2)));
+			for(auto& S : this->Ring)
+			{
+				S.Buffer = static_cast<u8*>(std::aligned_alloc(STREAM_BLOCK, this->SzBuffer));
+				S.Decoded = Quantized ? static_cast<T*>(std::aligned_alloc(ALIGNMENT, SzDecoded)) : nullptr;
+				S.Ready = false;
+				S.Last = false;
+			}
+
+			this->Read = 0;
+			this->Held = false;
+			this->Quit = false;
+			this->Failed = false;
+			this->Loader = std::thread([this]( void ) { this->load(); });
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Stop loading and release buffers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto close ( void ) -> void
+		{
+			if(this->Loader.joinable())
+			{
+				{ auto Guard = std::lock_guard(this->Lock); this->Quit = true; }
+				this->Wake.notify_all();
+				this->Loader.join();
+			}
+
+			for(auto& S : this->Ring) { std::free(S.Buffer); std::free(S.Decoded); }
+			this->Ring.clear();
+
+			if(this->Fd >= 0) ::close(this->Fd);
+			this->Fd = -1;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Get next chunk. Previously returned chunk becomes invalid. Returns false once at end of every pass, next call starts new pass.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto next ( SamplesChunk<T>& _Chunk ) -> bool
+		{
+			auto Guard = std::unique_lock(this->Lock);
+
+			// Hand previous slot back to loader.
+			if(this->Held)
+			{
+				auto& Prev = this->Ring[(this->Read - 1) % this->Ring.size()];
+				const auto WasLast = Prev.Last;
+				Prev.Ready = false;
+				this->Held = false;
+				this->Wake.notify_all();
+				if(WasLast) return false;
+			}
+
+			auto& S = this->Ring[this->Read % this->Ring.size()];
+			this->Wake.wait(Guard, [&]( void ) { return S.Ready || this->Failed; });
+			if(!S.Ready) return false;
+
+			_Chunk = S.Chunk;
+			this->Read++;
+			this->Held = true;
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto isOpen ( void ) const -> bool { return this->Fd >= 0; }
+		inline auto failed ( void ) -> bool { auto Guard = std::lock_guard(this->Lock); return this->Failed; }
+		inline auto size ( void ) const -> uMAX { return this->Header.Count; }
+		inline auto format ( void ) const -> SamplesFormat { return this->Header.Format; }
+		inline auto sampleSz ( void ) const -> uMAX { return this->Header.SampleSz / this->Header.SzT; } // In Ts.
+		inline auto stride ( void ) const -> uMAX { return this->StrideT; } // In Ts.
+
+		private:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Read range of file into buffer. Returns pointer to first requested byte.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto readRange ( u8* _Buffer, const uMAX _Offset, const uMAX _Size ) -> const u8*
+		{
+			const auto Beg = (_Offset / STREAM_BLOCK) * STREAM_BLOCK;
+			const auto End = this->Direct ? (((_Offset + _Size + STREAM_BLOCK - 1) / STREAM_BLOCK) * STREAM_BLOCK) : (_Offset + _Size);
+			const auto Need = _Offset + _Size - Beg;
+
+			auto Done = uMAX(0);
+			while(Done < Need)
+			{
+				const auto Got = ::pread(this->Fd, _Buffer + Done, End - Beg - Done, Beg + Done);
+				if(Got < 0) { if(errno == EINTR) continue; return nullptr; }
+				if(Got == 0) return nullptr;
+				Done += uMAX(Got);
+			}
+
+			if(!this->Direct && this->DropCache) posix_fadvise(this->Fd, Beg, End - Beg, POSIX_FADV_DONTNEED);
+			return _Buffer + (_Offset - Beg);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Loader loop. Cycles over file until closed.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto load ( void ) -> void
+		{
+			traceThread("stream");
+
+			for(auto c = uMAX(0);; ++c)
+			{
+				auto& S = this->Ring[c % this->Ring.size()];
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->Wake.wait(Guard, [&]( void ) { return this->Quit || !S.Ready; });
+					if(this->Quit) return;
+				}
+
+				const auto Idx = c % this->Chunks;
+				const auto First = Idx * this->ChunkSamples;
+				const auto Count = std::min(this->ChunkSamples, uMAX(this->Header.Count) - First);
+				const auto Offset = this->Header.OffData + First * this->Header.Stride;
+
+				// Hint kernel to start on chunk after this one.
+				auto Data = (const u8*)(nullptr);
+				{
+					SX_MC_TRACE("stream", "read");
+					if(!this->Direct) posix_fadvise(this->Fd, Offset + Count * this->Header.Stride, this->ChunkSamples * this->Header.Stride, POSIX_FADV_WILLNEED);
+					Data = this->readRange(S.Buffer, Offset, Count * this->Header.Stride);
+					if(Data && S.Decoded) samplesDecode(this->Header, Data, Count, S.Decoded, this->StrideT);
+				}
+
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					if(!Data) { this->Failed = true; this->Wake.notify_all(); return; }
+
+					S.Chunk.Data = S.Decoded ? S.Decoded : reinterpret_cast<const T*>(Data);
+					S.Chunk.Count = Count;
+					S.Chunk.Stride = this->StrideT;
+					S.Chunk.First = First;
+					S.Last = (Idx + 1) == this->Chunks;
+					S.Ready = true;
+				}
+				this->Wake.notify_all();
+			}
+		}
+	};
+}
@@ -0,0 +1,300 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./SamplesShards.hpp"
+#include "./Threads.hpp"
+#include <filesystem>
+#include <map>
+#include <unordered_map>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto MANIFEST_MAGIC = u64(0x0046494E414D5853); // "SXMANIF".
+	constexpr auto MANIFEST_VERSION = u64(1);
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Settings samples were built with. Any difference means every image has to be rebuilt.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ManifestSettings
+	{
+		u64 SzT;
+		u64 IsFloat;
+		u64 Width;
+		u64 Height;
+		u64 SplitChannels;
+		u64 DownUp;
+		SamplesFormat Format;
+		r64 Scale;
+		r64 Offset;
+
+		inline auto operator== ( const ManifestSettings& _Other ) const -> bool = default;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Fingerprint of source image and samples built from it. Samples are consecutive in shard.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct SourcePrint
+	{
+		u64 Size;
+		i64 Time; // Last write time.
+		u64 Hash; // FNV-1a of content.
+		u64 Shard;
+		u64 First; // Index of first sample in shard.
+		u64 Count; // Zero if image failed to load.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Source image.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct SamplesSource
+	{
+		str Path;
+		SourcePrint Print;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Record of incrementally built samples.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct SamplesManifest
+	{
+		ManifestSettings Settings;
+		u64 NextShard; // Id of next shard to write.
+		vec<SamplesSource> Sources;
+
+		SamplesManifest ( void ) : Settings(), NextShard(0), Sources() {}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Hash file content. Returns false if file can not be read.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto hashFile ( const str& _File, u64& _Hash ) -> bool
+	{
+		auto File = std::ifstream(_File, std::ios::binary);
+		if(!File.is_open()) return false;
+
+		auto Hash = u64(0xCBF29CE484222325);
+		auto Block = vec<char>(1 << 16);
+
+		while(File)
+		{
+			File.read(Block.data(), Block.size());
+			const auto Got = uMAX(File.gcount());
+			for(auto i = uMAX(0); i < Got; ++i) Hash = (Hash ^ u8(Block[i])) * u64(0x100000001B3);
+		}
+
+		_Hash = Hash;
+		return File.eof();
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Load manifest.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto loadSamplesManifest ( const str& _File, SamplesManifest& _Manifest ) -> bool
+	{
+		auto File = std::ifstream(_File, std::ios::binary);
+		if(!File.is_open()) return false;
+
+		auto Magic = u64(0);
+		auto Version = u64(0);
+		auto Count = u64(0);
+		File.read(reinterpret_cast<char*>(&Magic), sizeof(u64));
+		File.read(reinterpret_cast<char*>(&Version), sizeof(u64));
+		File.read(reinterpret_cast<char*>(&_Manifest.Settings), sizeof(ManifestSettings));
+		File.read(reinterpret_cast<char*>(&_Manifest.NextShard), sizeof(u64));
+		File.read(reinterpret_cast<char*>(&Count), sizeof(u64));
+		if(!File || (Magic != MANIFEST_MAGIC) || (Version != MANIFEST_VERSION)) return false;
+
+		_Manifest.Sources.clear();
+		for(auto s = uMAX(0); s < Count; ++s)
+		{
+			auto Source = SamplesSource();
+			auto Len = u64(0);
+			File.read(reinterpret_cast<char*>(&Len), sizeof(u64));
+			if(!File || (Len > (1 << 16))) return false;
+
+			Source.Path.resize(Len);
+			File.read(Source.Path.data(), Len);
+			File.read(reinterpret_cast<char*>(&Source.Print), sizeof(SourcePrint));
+			if(!File) return false;
+
+			_Manifest.Sources.push_back(std::move(Source));
+		}
+
+		return true;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Store manifest under temporary name and rename it once complete.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto storeSamplesManifest ( const str& _File, const SamplesManifest& _Manifest ) -> bool
+	{
+		const auto FileTmp = _File + ".tmp"s;
+		auto File = std::ofstream(FileTmp, std::ios::binary | std::ios::trunc);
+		if(!File.is_open()) return false;
+
+		const auto Count = u64(_Manifest.Sources.size());
+		File.write(reinterpret_cast<const char*>(&MANIFEST_MAGIC), sizeof(u64));
+		File.write(reinterpret_cast<const char*>(&MANIFEST_VERSION), sizeof(u64));
+		File.write(reinterpret_cast<const char*>(&_Manifest.Settings), sizeof(ManifestSettings));
+		File.write(reinterpret_cast<const char*>(&_Manifest.NextShard), sizeof(u64));
+		File.write(reinterpret_cast<const char*>(&Count), sizeof(u64));
+
+		for(const auto& Source : _Manifest.Sources)
+		{
+			const auto Len = u64(Source.Path.size());
+			File.write(reinterpret_cast<const char*>(&Len), sizeof(u64));
+			File.write(Source.Path.data(), Len);
+			File.write(reinterpret_cast<const char*>(&Source.Print), sizeof(SourcePrint));
+		}
+
+		File.close();
+		if(!File || (std::rename(FileTmp.c_str(), _File.c_str()) != 0)) { std::remove(FileTmp.c_str()); return false; }
+		return true;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Build or update sharded samples from images. Writes _Prefix.sxi index, _Prefix.sxf manifest and _Prefix.NNNN.sxs shards.
+	// Images whose size and write time match manifest are kept as they are, others are hashed and only new or changed content is built,
+	// into one new shard per update. Samples of deleted or changed images are left out of index and shards nothing refers to are removed.
+	// Images that failed to load have no samples to keep and are retried on every update.
+	// Changing settings rebuilds everything.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto updateImageSamplesShards ( const str& _SrcDir, const str& _Prefix, const CfgBuildImgChc& _Cfg, const SamplesFormat _Format = SamplesFormat::NATIVE, const r64 _Scale = 1.0 / 255.0, const r64 _Offset = 0.0, const uMAX _Workers = 0 ) -> bool
+	{
+		namespace fs = std::filesystem;
+
+		const auto IndexFile = _Prefix + ".sxi"s;
+		const auto ManifestFile = _Prefix + ".sxf"s;
+		const auto Settings = ManifestSettings{sizeof(T), u64(std::is_floating_point_v<T>), _Cfg.Width, _Cfg.Height, u64(_Cfg.SplitChannels), _Cfg.DownUp, _Format, _Scale, _Offset};
+
+
+		// Load previous state.
+		auto Old = SamplesManifest();
+		if(!loadSamplesManifest(ManifestFile, Old)) Old = SamplesManifest();
+		if(Old.Settings != Settings) Old.Sources.clear();
+
+		auto Known = std::unordered_map<str,uMAX>();
+		for(auto s = uMAX(0); s < Old.Sources.size(); ++s) Known.emplace(Old.Sources[s].Path, s);
+
+		auto New = SamplesManifest();
+		New.Settings = Settings;
+		New.NextShard = Old.NextShard;
+
+
+		// Fingerprint sources. Hashing only happens when size or time differ.
+		const auto Files = files::buildFileList(_SrcDir, true);
+		auto Build = vec<u8>(Files.size(), 0);
+		auto Kept = vec<u8>(Old.Sources.size(), 0);
+		New.Sources.resize(Files.size());
+
+		threadPool().parallelFor(Files.size(), 16, [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+		{
+			for(auto f = _Beg; f < _End; ++f)
+			{
+				auto Code = std::error_code();
+				auto& Source = New.Sources[f];
+				auto& Print = Source.Print;
+				Source.Path = Files[f].string();
+				Print = SourcePrint();
+				Print.Size = u64(fs::file_size(Files[f], Code));
+				Print.Time = i64(fs::last_write_time(Files[f], Code).time_since_epoch().count());
+
+				const auto It = Known.find(Source.Path);
+				const auto Prev = ((It != Known.end()) && (Old.Sources[It->second].Print.Count != 0)) ? &Old.Sources[It->second].Print : nullptr;
+
+				if(Prev && (Prev->Size == Print.Size) && (Prev->Time == Print.Time)) { Print = *Prev; Kept[It->second] = 1; continue; }
+				const auto Hashed = hashFile(Source.Path, Print.Hash);
+				if(Prev && Hashed && (Prev->Size == Print.Size) && (Prev->Hash == Print.Hash)) { Print.Shard = Prev->Shard; Print.First = Prev->First; Print.Count = Prev->Count; Kept[It->second] = 1; continue; }
+
+				Build[f] = 1;
+			}
+		});
+
+
+		// Build new and changed images into new shard.
+		auto Pending = vec<std::filesystem::path>();
+		auto PendingIdx = vec<uMAX>();
+		for(auto f = uMAX(0); f < Files.size(); ++f) if(Build[f]) { Pending.push_back(Files[f]); PendingIdx.push_back(f); }
+
+		std::cout << "Updating samples ["s << _Prefix << "], "s << Pending.size() << " to build, "s << (Old.Sources.size() - std::count(Kept.begin(), Kept.end(), 1)) << " removed or changed.\n"s;
+
+		if(!Pending.empty())
+		{
+			const auto Shard = New.NextShard++;
+
+			// Reserve shard number before its file is written. Index published later refers to it, so crash before
+			// final manifest must not let next update truncate it under same number.
+			auto Reserved = Old;
+			Reserved.NextShard = New.NextShard;
+			if(!storeSamplesManifest(ManifestFile, Reserved)) return false;
+
+			auto Writer = SamplesWriter<T>();
+			if(!Writer.open(shardFile(_Prefix, Shard), imageSampleSz(_Cfg), _Format, _Scale, _Offset)) return false;
+
+			auto Next = uMAX(0);
+			auto Sample = vec<T>();
+			processImageSamples<T>(Pending, _Cfg, _Workers, [&]( const std::filesystem::path&, const bool _Success, vec<Image<T>>& _Channels )
+			{
+				auto& Print = New.Sources[PendingIdx[Next++]].Print;
+				Print.Shard = Shard;
+				Print.First = Writer.count();
+				if(_Success) pushImageSamples(Writer, _Cfg, _Channels, Sample);
+				Print.Count = Writer.count() - Print.First;
+			});
+
+			if(!Writer.close()) return false;
+		}
+
+
+		// Index live samples in file list order.
+		const auto Stride = samplesStride(imageSampleSz(_Cfg) * samplesElemSz<T>(_Format));
+
+		auto Used = std::map<u64,u64>();
+		for(const auto& Source : New.Sources) if(Source.Print.Count) Used.emplace(Source.Print.Shard, 0);
+
+		auto Shards = vec<str>();
+		for(auto& [Shard, Idx] : Used) { Idx = Shards.size(); Shards.push_back(shardFile(_Prefix, Shard)); }
+
+		auto Entries = vec<ShardEntry>();
+		for(const auto& Source : New.Sources)
+		{
+			const auto& Print = Source.Print;
+			for(auto s = uMAX(0); s < Print.Count; ++s) Entries.push_back(ShardEntry{Used[Print.Shard], SAMPLES_OFF_DATA + (Print.First + s) * Stride});
+		}
+
+		if(Shards.empty()) return false;
+		if(!storeShardsIndex(IndexFile, Shards, Entries) || !storeSamplesManifest(ManifestFile, New)) return false;
+
+
+		// Drop shards nothing refers to.
+		for(auto s = uMAX(0); s < New.NextShard; ++s) if(!Used.count(s)) std::remove(shardFile(_Prefix, s).c_str());
+		return true;
+	}
+}
@@ -0,0 +1,511 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Network.hpp"
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto SERVER_HIST_SUB = uMAX(8); // Latency buckets per power of two.
+	constexpr auto SERVER_HIST = uMAX(62) * SERVER_HIST_SUB; // Covers every u64 value.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Configuration of inference server.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct CfgServer
+	{
+		uMAX MaxBatch; // Most requests executed together.
+		r64 MaxDelay; // Seconds oldest request of batch may wait for others to join.
+		uMAX Replicas; // Networks executing batches in parallel.
+
+		CfgServer ( const uMAX _MaxBatch = 32, const r64 _MaxDelay = 0.001, const uMAX _Replicas = 1 ) :
+		MaxBatch(std::max(_MaxBatch, uMAX(1))),
+		MaxDelay(_MaxDelay),
+		Replicas(std::max(_Replicas, uMAX(1)))
+		{}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Server measurements since start or last reset. Latency is from submit to completed future.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ServerStats
+	{
+		u64 Requests;
+		u64 Batches;
+		r64 MeanBatch;
+		r64 P50; // Seconds.
+		r64 P99; // Seconds.
+		r64 Throughput; // Requests per second.
+		r64 Seconds;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Monotonic time in nanoseconds.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto serverNow ( void ) -> u64
+	{
+		return u64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Latency histogram. Buckets are log linear, so percentiles are within eighth of true value. Any thread may add.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class ServerHist
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		std::unique_ptr<std::atomic<u64>[]> Counts;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Bucket of value and lowest value of bucket.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto index ( const u64 _Nanos ) -> uMAX
+		{
+			if(_Nanos < SERVER_HIST_SUB) return uMAX(_Nanos);
+			const auto Exp = uMAX(std::bit_width(_Nanos)) - 1;
+			return (Exp - 2) * SERVER_HIST_SUB + ((_Nanos >> (Exp - 3)) & (SERVER_HIST_SUB - 1));
+		}
+
+		static auto lower ( const uMAX _Index ) -> u64
+		{
+			if(_Index < SERVER_HIST_SUB) return u64(_Index);
+			const auto Exp = _Index / SERVER_HIST_SUB + 2;
+			return (u64(SERVER_HIST_SUB) + (_Index % SERVER_HIST_SUB)) << (Exp - 3);
+		}
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ServerHist ( void ) : Counts(new std::atomic<u64>[SERVER_HIST]) { this->reset(); }
+
+		auto add ( const u64 _Nanos ) -> void { this->Counts[ServerHist::index(_Nanos)].fetch_add(1, std::memory_order_relaxed); }
+		auto reset ( void ) -> void { for(auto i = uMAX(0); i < SERVER_HIST; ++i) this->Counts[i].store(0, std::memory_order_relaxed); }
+
+		// Value below which _Quantile of samples lie, as middle of its bucket.
+		auto percentile ( const r64 _Quantile ) const -> u64
+		{
+			auto Total = u64(0);
+			for(auto i = uMAX(0); i < SERVER_HIST; ++i) Total += this->Counts[i].load(std::memory_order_relaxed);
+			if(Total == 0) return 0;
+
+			const auto Rank = u64(std::ceil(_Quantile * r64(Total)));
+			auto Seen = u64(0);
+			for(auto i = uMAX(0); i < SERVER_HIST; ++i)
+			{
+				Seen += this->Counts[i].load(std::memory_order_relaxed);
+				if(Seen >= std::max(Rank, u64(1))) return (ServerHist::lower(i) + ServerHist::lower(i + 1)) / 2;
+			}
+
+			return ServerHist::lower(SERVER_HIST - 1);
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Inference request. Input is copied at submit, so callers may reuse their buffer.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> struct ServerRequest
+	{
+		std::atomic<ServerRequest*> Next;
+		vec<T> Input;
+		std::promise<vec<T>> Result;
+		u64 Arrival;
+
+		ServerRequest ( void ) : Next(nullptr), Input(), Result(), Arrival(0) {}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Intrusive multi producer single consumer queue. Push is single exchange and never waits.
+	// Pop may miss request whose producer is between exchange and link, empty() then reports false until link lands.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class ServerQueue
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		alignas(64) std::atomic<ServerRequest<T>*> Head; // Last pushed, swapped by producers.
+		alignas(64) ServerRequest<T>* Tail; // Next to pop, owned by consumer.
+		ServerRequest<T> Stub;
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ServerQueue ( void ) : Head(&Stub), Tail(&Stub), Stub() {}
+
+		ServerQueue ( const ServerQueue& ) = delete;
+		auto operator= ( const ServerQueue& ) -> ServerQueue& = delete;
+
+		auto push ( ServerRequest<T>* _Request ) -> void
+		{
+			_Request->Next.store(nullptr, std::memory_order_relaxed);
+			const auto Prev = this->Head.exchange(_Request, std::memory_order_acq_rel);
+			Prev->Next.store(_Request, std::memory_order_release);
+		}
+
+		// Consumer only.
+		auto pop ( void ) -> ServerRequest<T>*
+		{
+			auto Tail = this->Tail;
+			auto Next = Tail->Next.load(std::memory_order_acquire);
+
+			if(Tail == &this->Stub)
+			{
+				if(!Next) return nullptr;
+				this->Tail = Next;
+				Tail = Next;
+				Next = Next->Next.load(std::memory_order_acquire);
+			}
+
+			if(Next) { this->Tail = Next; return Tail; }
+			if(Tail != this->Head.load(std::memory_order_acquire)) return nullptr;
+
+			// Tail is last request, put stub behind it so it can be taken.
+			this->push(&this->Stub);
+			Next = Tail->Next.load(std::memory_order_acquire);
+			if(Next) { this->Tail = Next; return Tail; }
+			return nullptr;
+		}
+
+		// Consumer only.
+		auto empty ( void ) const -> bool { return (this->Tail == &this->Stub) && (this->Head.load(std::memory_order_acquire) == &this->Stub); }
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Batched inference server. Client threads submit single samples and get futures. Dispatcher thread groups requests
+	// into batches of up to MaxBatch, waiting at most MaxDelay after first of them arrived, and hands each batch to idle replica.
+	// While every replica is busy requests keep queueing, so batches grow with load.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class Server
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		using Net = Network<T,CompClass::LAYERS>;
+		using Request = ServerRequest<T>;
+
+		struct Replica
+		{
+			std::unique_ptr<Net> Model;
+			BatchBuf<T> Inputs;
+			vec<Request*> Batch;
+			bool Assigned;
+			std::condition_variable Ready;
+			std::thread Worker;
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		CfgServer Cfg;
+		uMAX SzIn;
+		uMAX SzOut;
+		ServerQueue<T> Queue;
+		vec<std::unique_ptr<Replica>> Replicas;
+		vec<Replica*> Idle;
+
+		std::mutex Lock; // Guards handoff and sleeping, taken by producers only while dispatcher sleeps.
+		std::condition_variable Wake;
+		std::atomic<bool> Sleeping;
+		bool Signaled;
+		std::atomic<bool> Running;
+		bool Quit; // Dispatcher drains queue and exits.
+		bool Retire; // Replicas exit, set once dispatcher is gone.
+		std::thread Dispatcher;
+
+		ServerHist Latency;
+		std::atomic<u64> Requests;
+		std::atomic<u64> Batches;
+		std::atomic<u64> Begin;
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor. _Build attaches layers of one replica and is called once per replica, for example binding shared ModelMap.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Server ( const CfgServer& _Cfg, const std::function<void(Net&)>& _Build ) :
+			Cfg(_Cfg),
+			SzIn(0),
+			SzOut(0),
+			Queue(),
+			Replicas(),
+			Idle(),
+			Sleeping(false),
+			Signaled(false),
+			Running(true),
+			Quit(false),
+			Retire(false),
+			Latency(),
+			Requests(0),
+			Batches(0),
+			Begin(serverNow())
+		{
+			for(auto r = uMAX(0); r < this->Cfg.Replicas; ++r)
+			{
+				auto R = std::make_unique<Replica>();
+				R->Model = std::make_unique<Net>();
+				R->Assigned = false;
+				_Build(*R->Model);
+				R->Model->connect();
+
+				const auto SzIn = uMAX(R->Model->front()->desc().SzIn);
+				const auto SzOut = uMAX(R->Model->back()->outSz());
+				if(r > 0 && (SzIn != this->SzIn || SzOut != this->SzOut)) throw Error("sx"s, "Server<T>"s, "Server"s, 0, "Replicas differ in shape!"s);
+				this->SzIn = SzIn;
+				this->SzOut = SzOut;
+
+				R->Inputs.reserve(this->Cfg.MaxBatch * this->SzIn);
+				R->Batch.reserve(this->Cfg.MaxBatch);
+				this->Replicas.push_back(std::move(R));
+			}
+
+			for(auto& R : this->Replicas)
+			{
+				const auto Ptr = R.get();
+				this->Idle.push_back(Ptr);
+				Ptr->Worker = std::thread([this, Ptr]( void ) { this->work(*Ptr); });
+			}
+
+			this->Dispatcher = std::thread([this]( void ) { this->dispatch(); });
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~Server ( void ) { this->stop(); }
+
+		Server ( const Server& ) = delete;
+		auto operator= ( const Server& ) -> Server& = delete;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Queue inference of single sample of inSz() Ts. Never blocks. Must not race stop.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto submit ( const T* _Input ) -> std::future<vec<T>>
+		{
+			if(!this->Running.load(std::memory_order_acquire)) throw Error("sx"s, "Server<T>"s, "submit"s, 0, "Server is stopped!"s);
+
+			auto R = new Request();
+			R->Input.assign(_Input, _Input + this->SzIn);
+			R->Arrival = serverNow();
+			auto Future = R->Result.get_future();
+
+			this->Queue.push(R);
+
+			// Pairs with fence of sleeping dispatcher, one of both sees the other.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(this->Sleeping.load(std::memory_order_relaxed))
+			{
+				{ auto Guard = std::lock_guard(this->Lock); this->Signaled = true; }
+				this->Wake.notify_all();
+			}
+
+			return Future;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Complete queued requests and join threads.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto stop ( void ) -> void
+		{
+			if(!this->Running.exchange(false)) return;
+
+			{ auto Guard = std::lock_guard(this->Lock); this->Quit = true; }
+			this->Wake.notify_all();
+			this->Dispatcher.join();
+
+			{ auto Guard = std::lock_guard(this->Lock); this->Retire = true; }
+			for(auto& R : this->Replicas) R->Ready.notify_all();
+			for(auto& R : this->Replicas) R->Worker.join();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto inSz ( void ) const -> uMAX { return this->SzIn; }
+		inline auto outSz ( void ) const -> uMAX { return this->SzOut; }
+
+		auto stats ( void ) const -> ServerStats
+		{
+			const auto Requests = this->Requests.load(std::memory_order_relaxed);
+			const auto Batches = this->Batches.load(std::memory_order_relaxed);
+			const auto Seconds = r64(serverNow() - this->Begin.load(std::memory_order_relaxed)) * 1e-9;
+
+			return ServerStats
+			{
+				Requests,
+				Batches,
+				r64(Requests) / r64(std::max(Batches, u64(1))),
+				r64(this->Latency.percentile(0.5)) * 1e-9,
+				r64(this->Latency.percentile(0.99)) * 1e-9,
+				r64(Requests) / std::max(Seconds, 1e-9),
+				Seconds
+			};
+		}
+
+		auto statsReset ( void ) -> void
+		{
+			this->Latency.reset();
+			this->Requests.store(0, std::memory_order_relaxed);
+			this->Batches.store(0, std::memory_order_relaxed);
+			this->Begin.store(serverNow(), std::memory_order_relaxed);
+		}
+
+		private:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Dispatcher loop. Takes idle replica first, so batch collects for as long as replicas are busy.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto dispatch ( void ) -> void
+		{
+			traceThread("server");
+
+			while(true)
+			{
+				auto Target = static_cast<Replica*>(nullptr);
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->Wake.wait(Guard, [&]( void ) { return !this->Idle.empty(); });
+					Target = this->Idle.back();
+					this->Idle.pop_back();
+				}
+
+				if(!this->collect(Target->Batch)) break;
+
+				{ auto Guard = std::lock_guard(this->Lock); Target->Assigned = true; }
+				Target->Ready.notify_one();
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Gather batch. Returns false once stopped and nothing is left.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto collect ( vec<Request*>& _Batch ) -> bool
+		{
+			auto Deadline = std::chrono::steady_clock::time_point::max();
+
+			while(_Batch.size() < this->Cfg.MaxBatch)
+			{
+				if(const auto R = this->Queue.pop())
+				{
+					if(_Batch.empty()) Deadline = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(R->Arrival + u64(this->Cfg.MaxDelay * 1e9)));
+					_Batch.push_back(R);
+					continue;
+				}
+
+				if(!this->Queue.empty()) { std::this_thread::yield(); continue; }
+				if(!_Batch.empty() && (std::chrono::steady_clock::now() >= Deadline)) break;
+
+				auto Guard = std::unique_lock(this->Lock);
+				if(this->Quit) { if(_Batch.empty()) return false; break; }
+
+				this->Sleeping.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				if(this->Queue.empty())
+				{
+					const auto Woken = [&]( void ) { return this->Signaled || this->Quit; };
+					if(_Batch.empty()) this->Wake.wait(Guard, Woken);
+					else this->Wake.wait_until(Guard, Deadline, Woken);
+				}
+
+				this->Signaled = false;
+				this->Sleeping.store(false, std::memory_order_relaxed);
+			}
+
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Replica loop.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto work ( Replica& _Replica ) -> void
+		{
+			traceThread("server replica");
+
+			while(true)
+			{
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					_Replica.Ready.wait(Guard, [&]( void ) { return _Replica.Assigned || this->Retire; });
+					if(!_Replica.Assigned) return;
+				}
+
+				this->execute(_Replica);
+
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					_Replica.Assigned = false;
+					this->Idle.push_back(&_Replica);
+				}
+				this->Wake.notify_all();
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Run batch through replica and complete its requests.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto execute ( Replica& _Replica ) -> void
+		{
+			SX_MC_TRACE("server", "batch");
+
+			auto& Batch = _Replica.Batch;
+			const auto Count = Batch.size();
+			auto Done = uMAX(0); // Requests already given result, promise can be satisfied only once.
+
+			try
+			{
+				const auto Inputs = _Replica.Inputs.reserve(Count * this->SzIn);
+				for(auto n = uMAX(0); n < Count; ++n) memCopy(this->SzIn, Inputs + n * this->SzIn, Batch[n]->Input.data());
+
+				_Replica.Model->exeBatch(Inputs, this->SzIn, Count, false);
+				const auto Outputs = _Replica.Model->outBatch(false);
+				for(; Done < Count; ++Done) Batch[Done]->Result.set_value(vec<T>(Outputs + Done * this->SzOut, Outputs + (Done + 1) * this->SzOut));
+			}
+
+			catch(...)
+			{
+				for(auto n = Done; n < Count; ++n) Batch[n]->Result.set_exception(std::current_exception());
+			}
+
+			const auto Now = serverNow();
+			for(auto n = uMAX(0); n < Count; ++n) { this->Latency.add(Now - Batch[n]->Arrival); delete Batch[n]; }
+
+			this->Requests.fetch_add(Count, std::memory_order_relaxed);
+			this->Batches.fetch_add(1, std::memory_order_relaxed);
+			Batch.clear();
+		}
+	};
+}
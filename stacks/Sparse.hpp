@@ -0,0 +1,126 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Convert.hpp"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto SPARSE_DENSITY = r64(0.3); // Share of non zero values below which visiting only them beats dense pass.
+	constexpr auto SPARSE_DENSITY_STORED = r64(0.05); // Same for narrowed storage, whose dense pass is vectorized while sparse one gathers scalars.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Count non zero values. Compare masks are counted eight at time without touching values, so dense input costs one cheap pass.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto sparseCount ( const uMAX _Count, const T* _Src ) -> uMAX
+	{
+		auto i = uMAX(0);
+		auto n = uMAX(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T,r32>)
+		{
+			const auto Zero = _mm256_setzero_ps();
+			for(; i + 8 <= _Count; i += 8) n += uMAX(__builtin_popcount(u32(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(_Src + i), Zero, _CMP_NEQ_UQ)))));
+		}
+		#endif
+
+		for(; i < _Count; ++i) n += (_Src[i] != T(0));
+		return n;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Compact non zero values. Positions go to _Idx, values to _Val, returns their count.
+	// Zeros are found eight at time with compare mask, only set bits of mask are visited.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto sparseCompact ( const uMAX _Count, const T* _Src, u32* _Idx, T* _Val ) -> uMAX
+	{
+		auto i = uMAX(0);
+		auto n = uMAX(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T,r32>)
+		{
+			const auto Zero = _mm256_setzero_ps();
+			for(; i + 8 <= _Count; i += 8)
+			{
+				auto Mask = u32(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(_Src + i), Zero, _CMP_NEQ_UQ)));
+				while(Mask)
+				{
+					const auto Bit = u32(__builtin_ctz(Mask));
+					_Idx[n] = u32(i + Bit);
+					_Val[n++] = _Src[i + Bit];
+					Mask &= Mask - 1;
+				}
+			}
+		}
+		#endif
+
+		for(; i < _Count; ++i) if(_Src[i] != T(0)) { _Idx[n] = u32(i); _Val[n++] = _Src[i]; }
+		return n;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Dot product of compacted values with row at their positions. Row is in storage format, sum is in T.
+	// Serves compressed rows too, with their column positions and values against input.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<FnStore FN_STORE, class T, class IDX> auto sparseDot ( const uMAX _Count, const IDX* _Idx, const T* _Val, const StoreT<FN_STORE,T>* _Row ) -> T
+	{
+		auto j = uMAX(0);
+		auto Sum = T(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T,r32> && (FN_STORE == FnStore::FP32))
+		{
+			auto Acc = _mm256_setzero_ps();
+			for(; j + 8 <= _Count; j += 8)
+			{
+				auto Idx = _mm256_setzero_si256();
+				if constexpr(sizeof(IDX) == 2) Idx = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_Idx + j)));
+				else Idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_Idx + j));
+				Acc = _mm256_add_ps(Acc, _mm256_mul_ps(_mm256_loadu_ps(_Val + j), _mm256_i32gather_ps(_Row, Idx, 4)));
+			}
+
+			alignas(32) r32 Lanes[8];
+			_mm256_store_ps(Lanes, Acc);
+			for(auto l = 0; l < 8; ++l) Sum += Lanes[l];
+		}
+		#endif
+
+		for(; j < _Count; ++j) Sum += _Val[j] * storeWiden<FN_STORE,T>(_Row[_Idx[j]]);
+		return Sum;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Accumulate compacted values times constant at their positions. _Out[_Idx[j]] += _Val[j] * _Const.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto sparseAxpy ( const uMAX _Count, const u32* _Idx, const T* _Val, T* _Out, const T _Const ) -> void
+	{
+		for(auto j = uMAX(0); j < _Count; ++j) _Out[_Idx[j]] += _Val[j] * _Const;
+	}
+}
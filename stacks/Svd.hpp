@@ -0,0 +1,214 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <fx/Types.hpp>
+#include "./Threads.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto SVD_OVERSAMPLE = uMAX(8); // Extra directions sampled beyond rank, they absorb tail of spectrum that would otherwise leak into kept ones.
+	constexpr auto SVD_ITERS = uMAX(4); // Subspace iterations, each one sharpens separation of kept and dropped singular values.
+	constexpr auto SVD_SWEEPS = uMAX(64); // Limit of Jacobi sweeps, small symmetric matrices converge in few.
+	constexpr auto SVD_SEED = u64(0x5EED5EED); // Sampling is deterministic, same weights give same factors.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Orthonormalize columns of _Rows x _Cols row major matrix in place. Gram-Schmidt runs twice, which keeps columns orthogonal
+	// to working precision. Columns dependent on previous ones become zero.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto svdOrthonormalize ( const uMAX _Rows, const uMAX _Cols, r64* _A ) -> void
+	{
+		for(auto c = uMAX(0); c < _Cols; ++c)
+		{
+			auto Norm0 = r64(0);
+			for(auto i = uMAX(0); i < _Rows; ++i) Norm0 += _A[i * _Cols + c] * _A[i * _Cols + c];
+
+			for(auto Pass = 0; Pass < 2; ++Pass) for(auto p = uMAX(0); p < c; ++p)
+			{
+				auto Dot = r64(0);
+				for(auto i = uMAX(0); i < _Rows; ++i) Dot += _A[i * _Cols + p] * _A[i * _Cols + c];
+				for(auto i = uMAX(0); i < _Rows; ++i) _A[i * _Cols + c] -= Dot * _A[i * _Cols + p];
+			}
+
+			auto Norm = r64(0);
+			for(auto i = uMAX(0); i < _Rows; ++i) Norm += _A[i * _Cols + c] * _A[i * _Cols + c];
+
+			const auto Scale = (Norm > Norm0 * 1e-24) && (Norm > 0.0) ? (1.0 / std::sqrt(Norm)) : 0.0;
+			for(auto i = uMAX(0); i < _Rows; ++i) _A[i * _Cols + c] *= Scale;
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Eigen decomposition of symmetric _N x _N matrix by cyclic Jacobi rotations. _A is destroyed, eigen values go to _Vals
+	// in descending order and matching eigen vectors to columns of _Vecs.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto svdEigenSym ( const uMAX _N, r64* _A, r64* _Vecs, r64* _Vals ) -> void
+	{
+		auto Vecs = vec<r64>(_N * _N, 0.0);
+		for(auto i = uMAX(0); i < _N; ++i) Vecs[i * _N + i] = 1.0;
+
+		for(auto Sweep = uMAX(0); Sweep < SVD_SWEEPS; ++Sweep)
+		{
+			auto Off = r64(0);
+			auto Diag = r64(0);
+			for(auto p = uMAX(0); p < _N; ++p) { Diag += _A[p * _N + p] * _A[p * _N + p]; for(auto q = p + 1; q < _N; ++q) Off += _A[p * _N + q] * _A[p * _N + q]; }
+			if(Off <= Diag * 1e-30) break;
+
+			for(auto p = uMAX(0); p < _N; ++p) for(auto q = p + 1; q < _N; ++q)
+			{
+				const auto Apq = _A[p * _N + q];
+				if(Apq == 0.0) continue;
+
+				// Rotation zeroing (p,q), smaller angle root keeps it stable.
+				const auto Theta = (_A[q * _N + q] - _A[p * _N + p]) / (2.0 * Apq);
+				const auto Tan = ((Theta >= 0.0) ? 1.0 : -1.0) / (std::abs(Theta) + std::sqrt(Theta * Theta + 1.0));
+				const auto Cos = 1.0 / std::sqrt(Tan * Tan + 1.0);
+				const auto Sin = Tan * Cos;
+
+				for(auto k = uMAX(0); k < _N; ++k)
+				{
+					const auto Akp = _A[k * _N + p], Akq = _A[k * _N + q];
+					_A[k * _N + p] = Cos * Akp - Sin * Akq;
+					_A[k * _N + q] = Sin * Akp + Cos * Akq;
+
+					const auto Vkp = Vecs[k * _N + p], Vkq = Vecs[k * _N + q];
+					Vecs[k * _N + p] = Cos * Vkp - Sin * Vkq;
+					Vecs[k * _N + q] = Sin * Vkp + Cos * Vkq;
+				}
+
+				for(auto k = uMAX(0); k < _N; ++k)
+				{
+					const auto Apk = _A[p * _N + k], Aqk = _A[q * _N + k];
+					_A[p * _N + k] = Cos * Apk - Sin * Aqk;
+					_A[q * _N + k] = Sin * Apk + Cos * Aqk;
+				}
+			}
+		}
+
+		auto Order = vec<uMAX>(_N);
+		std::iota(Order.begin(), Order.end(), uMAX(0));
+		std::sort(Order.begin(), Order.end(), [&]( const uMAX _L, const uMAX _R ) { return _A[_L * _N + _L] > _A[_R * _N + _R]; });
+
+		for(auto j = uMAX(0); j < _N; ++j)
+		{
+			_Vals[j] = _A[Order[j] * _N + Order[j]];
+			for(auto k = uMAX(0); k < _N; ++k) _Vecs[k * _N + j] = Vecs[k * _N + Order[j]];
+		}
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Truncated singular value decomposition of _Rows x _Cols row major matrix, _A ~ _U * diag(_S) * _Vt with _Rank terms.
+	// _U is _Rows x _Rank, _Vt is _Rank x _Cols, both row major, _S is descending. Randomized subspace iteration finds basis
+	// of dominant column space, so only products with _A are needed and small projected problem is solved exactly.
+	// Terms past numerical rank of _A come out zero.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto svdTruncated ( const uMAX _Rows, const uMAX _Cols, const T* _A, const uMAX _Rank, T* _U, T* _S, T* _Vt, const uMAX _Iters = SVD_ITERS ) -> void
+	{
+		const auto K = std::min(_Rank + SVD_OVERSAMPLE, std::min(_Rows, _Cols));
+
+		// _Y = _A * _X, chunks own rows of _Y.
+		const auto mul = [&]( const r64* _X, r64* _Y )
+		{
+			threadPool().parallelFor(_Rows, parGrain(_Cols * K * 2), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto i = _Beg; i < _End; ++i)
+				{
+					const auto Y = _Y + i * K;
+					std::fill(Y, Y + K, 0.0);
+					for(auto j = uMAX(0); j < _Cols; ++j) { const auto A = r64(_A[i * _Cols + j]); for(auto k = uMAX(0); k < K; ++k) Y[k] += A * _X[j * K + k]; }
+				}
+			});
+		};
+
+		// _X = _A' * _Y, chunks own rows of _X.
+		const auto mulT = [&]( const r64* _Y, r64* _X )
+		{
+			threadPool().parallelFor(_Cols, parGrain(_Rows * K * 2), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				std::fill(_X + _Beg * K, _X + _End * K, 0.0);
+				for(auto i = uMAX(0); i < _Rows; ++i) for(auto j = _Beg; j < _End; ++j)
+				{
+					const auto A = r64(_A[i * _Cols + j]);
+					if(A != 0.0) for(auto k = uMAX(0); k < K; ++k) _X[j * K + k] += A * _Y[i * K + k];
+				}
+			});
+		};
+
+		auto Y = vec<r64>(_Rows * K);
+		auto X = vec<r64>(_Cols * K);
+
+		auto Gen = std::mt19937_64(SVD_SEED);
+		auto Nrm = std::normal_distribution<r64>(0.0, 1.0);
+		for(auto& Value : X) Value = Nrm(Gen);
+
+		mul(X.data(), Y.data());
+		svdOrthonormalize(_Rows, K, Y.data());
+
+		for(auto It = uMAX(0); It < _Iters; ++It)
+		{
+			mulT(Y.data(), X.data());
+			svdOrthonormalize(_Cols, K, X.data());
+			mul(X.data(), Y.data());
+			svdOrthonormalize(_Rows, K, Y.data());
+		}
+
+		// Projection B = Y' * _A is X' with X = _A' * Y. Eigen vectors W of B * B' = X' * X rotate Y onto left singular vectors,
+		// right ones are B' * W scaled by inverse singular values.
+		mulT(Y.data(), X.data());
+
+		auto Gram = vec<r64>(K * K, 0.0);
+		for(auto j = uMAX(0); j < _Cols; ++j) for(auto p = uMAX(0); p < K; ++p) for(auto q = uMAX(0); q < K; ++q) Gram[p * K + q] += X[j * K + p] * X[j * K + q];
+
+		auto W = vec<r64>(K * K);
+		auto Vals = vec<r64>(K);
+		svdEigenSym(K, Gram.data(), W.data(), Vals.data());
+
+		const auto Tiny = std::sqrt(std::max(Vals[0], 0.0)) * 1e-12;
+
+		for(auto r = uMAX(0); r < _Rank; ++r)
+		{
+			const auto Sigma = (r < K) ? std::sqrt(std::max(Vals[r], 0.0)) : 0.0;
+			const auto Kept = (Sigma > Tiny) && (Sigma > 0.0);
+			_S[r] = Kept ? T(Sigma) : T(0);
+
+			for(auto i = uMAX(0); i < _Rows; ++i)
+			{
+				auto Sum = r64(0);
+				if(Kept) for(auto k = uMAX(0); k < K; ++k) Sum += Y[i * K + k] * W[k * K + r];
+				_U[i * _Rank + r] = T(Sum);
+			}
+
+			for(auto j = uMAX(0); j < _Cols; ++j)
+			{
+				auto Sum = r64(0);
+				if(Kept) for(auto k = uMAX(0); k < K; ++k) Sum += X[j * K + k] * W[k * K + r];
+				_Vt[r * _Cols + j] = Kept ? T(Sum / Sigma) : T(0);
+			}
+		}
+	}
+}
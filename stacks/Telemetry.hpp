@@ -0,0 +1,326 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "./Network.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto TELEMETRY_RING = uMAX(1) << 14; // Default records in flight.
+	constexpr auto TELEMETRY_POLL_MS = u64(50); // Consumer drain period.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Kinds of telemetry records.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class TelemetryKind : u64
+	{
+		STEP, // Loss and throughput of training step.
+		LAYER // Norms of single layer.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Telemetry record. Plain data so it can be copied through ring.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct TelemetryRecord
+	{
+		TelemetryKind Kind;
+		u64 Step;
+		u64 Layer; // Index from front, LAYER records only.
+		LayerType Type; // LAYER records only.
+		r64 Loss; // Mean loss of step.
+		r64 Samples; // Samples in step.
+		r64 Seconds; // Duration of step.
+		r64 NormParams;
+		r64 NormDeltas;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Telemetry stream. Any thread publishes into bounded lock free ring and never waits, records that do not fit are dropped.
+	// Background consumer aggregates records into NetworkInfo and writes them as JSON lines to file and or local datagram socket.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Telemetry
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Ring slot. Sequence tells whether slot is free for producer or filled for consumer.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Slot
+		{
+			std::atomic<u64> Seq;
+			TelemetryRecord Record;
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		std::unique_ptr<Slot[]> Ring;
+		u64 Mask;
+		alignas(64) std::atomic<u64> Head; // Next slot to claim by producers.
+		alignas(64) u64 Tail; // Next slot to read by consumer.
+		std::atomic<u64> Dropped;
+		std::atomic<u64> Consumed;
+
+		uMAX LayerInterval;
+		std::atomic<u64> LayerNext; // Step from which layer norms are due.
+
+		mutable std::mutex Lock; // Guards aggregates and outputs, never taken by producers.
+		std::condition_variable Wake;
+		std::thread Consumer;
+		bool Quit;
+
+		NetworkInfo Info;
+		u64 Steps;
+		r64 Seconds;
+		std::ofstream File;
+		int Socket;
+		sockaddr_un SocketAddr;
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor. Layer norms are published at most every _LayerInterval steps, as they cost pass over all parameters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Telemetry ( const uMAX _Capacity = TELEMETRY_RING, const uMAX _LayerInterval = 100 ) :
+			Ring(),
+			Mask(0),
+			Head(0),
+			Tail(0),
+			Dropped(0),
+			Consumed(0),
+			LayerInterval(std::max(_LayerInterval, uMAX(1))),
+			LayerNext(0),
+			Quit(false),
+			Info(),
+			Steps(0),
+			Seconds(0),
+			Socket(-1),
+			SocketAddr()
+		{
+			auto Capacity = uMAX(2);
+			while(Capacity < _Capacity) Capacity <<= 1;
+
+			this->Ring.reset(new Slot[Capacity]);
+			this->Mask = Capacity - 1;
+			for(auto i = uMAX(0); i < Capacity; ++i) this->Ring[i].Seq.store(i, std::memory_order_relaxed);
+
+			this->Consumer = std::thread([this]( void ) { this->consume(); });
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor. Drains what was published.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~Telemetry ( void )
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Quit = true;
+			}
+			this->Wake.notify_all();
+			this->Consumer.join();
+
+			if(this->Socket >= 0) close(this->Socket);
+		}
+
+		Telemetry ( const Telemetry& ) = delete;
+		auto operator= ( const Telemetry& ) -> Telemetry& = delete;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Append records to _File as JSON lines.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto openFile ( const str& _File ) -> bool
+		{
+			auto Guard = std::lock_guard(this->Lock);
+			this->File.open(_File, std::ios::app);
+			return this->File.is_open();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Send records as datagrams to unix socket at _Path. Sends do not block, records are lost while nobody listens.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto openSocket ( const str& _Path ) -> bool
+		{
+			auto Guard = std::lock_guard(this->Lock);
+			if(_Path.size() >= sizeof(this->SocketAddr.sun_path)) return false;
+
+			if(this->Socket < 0) this->Socket = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+			if(this->Socket < 0) return false;
+
+			this->SocketAddr = sockaddr_un();
+			this->SocketAddr.sun_family = AF_UNIX;
+			std::memcpy(this->SocketAddr.sun_path, _Path.data(), _Path.size());
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Publish record. Returns false if ring was full and record was dropped.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto publish ( const TelemetryRecord& _Record ) -> bool
+		{
+			auto Pos = this->Head.load(std::memory_order_relaxed);
+
+			while(true)
+			{
+				auto& S = this->Ring[Pos & this->Mask];
+				const auto Seq = S.Seq.load(std::memory_order_acquire);
+
+				if(Seq == Pos)
+				{
+					if(this->Head.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+					{
+						S.Record = _Record;
+						S.Seq.store(Pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+
+				else if(Seq < Pos)
+				{
+					this->Dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+
+				else Pos = this->Head.load(std::memory_order_relaxed);
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Publish training step.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto publishStep ( const u64 _Step, const r64 _Loss, const uMAX _Samples, const r64 _Seconds ) -> bool
+		{
+			return this->publish(TelemetryRecord{TelemetryKind::STEP, _Step, 0, LayerType::NONE, _Loss, r64(_Samples), _Seconds, 0.0, 0.0});
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Publish norms of every layer, if due at _Step. Call before deltas are reset.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class T, CompClass MODE> auto publishLayers ( Network<T,MODE>& _Net, const u64 _Step ) -> void
+		{
+			auto Next = this->LayerNext.load(std::memory_order_relaxed);
+			if(_Step < Next || !this->LayerNext.compare_exchange_strong(Next, _Step + this->LayerInterval, std::memory_order_relaxed)) return;
+
+			auto Index = u64(0);
+			for(auto l = _Net.front(); l; l = l->front(), ++Index)
+			{
+				const auto Norms = l->norms();
+				this->publish(TelemetryRecord{TelemetryKind::LAYER, _Step, Index, l->desc().Type, 0.0, 0.0, 0.0, r64(Norms.Params), r64(Norms.Deltas)});
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Wait until consumer has processed everything published before call.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto flush ( void ) -> void
+		{
+			const auto Target = this->Head.load(std::memory_order_acquire);
+			auto Guard = std::unique_lock(this->Lock);
+			this->Wake.notify_all();
+			this->Wake.wait(Guard, [&]( void ) { return this->Consumed.load() >= Target || this->Quit; });
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Getters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto info ( void ) const -> NetworkInfo { auto Guard = std::lock_guard(this->Lock); return this->Info; } // Error statistics over all published steps.
+		inline auto dropped ( void ) const -> u64 { return this->Dropped.load(std::memory_order_relaxed); }
+
+		private:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Consumer loop.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto consume ( void ) -> void
+		{
+			auto Guard = std::unique_lock(this->Lock);
+
+			while(true)
+			{
+				this->drain();
+				this->Wake.notify_all();
+				if(this->Quit) return;
+				this->Wake.wait_for(Guard, std::chrono::milliseconds(TELEMETRY_POLL_MS));
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Process filled slots. Called under lock.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto drain ( void ) -> void
+		{
+			char Line[256];
+
+			while(true)
+			{
+				auto& S = this->Ring[this->Tail & this->Mask];
+				if(S.Seq.load(std::memory_order_acquire) != this->Tail + 1) break;
+
+				const auto Record = S.Record;
+				S.Seq.store(this->Tail + this->Mask + 1, std::memory_order_release);
+				this->Tail++;
+
+				auto Size = 0;
+				if(Record.Kind == TelemetryKind::STEP)
+				{
+					this->aggregate(Record);
+					Size = std::snprintf(Line, sizeof(Line), "{\"kind\":\"step\",\"step\":%llu,\"loss\":%.9g,\"samples\":%.0f,\"samples_per_sec\":%.3f}\n",
+						(unsigned long long)Record.Step, Record.Loss, Record.Samples, Record.Samples / std::max(Record.Seconds, 1e-12));
+				}
+
+				if(Record.Kind == TelemetryKind::LAYER)
+				{
+					Size = std::snprintf(Line, sizeof(Line), "{\"kind\":\"layer\",\"step\":%llu,\"layer\":%llu,\"type\":\"%s\",\"norm_params\":%.9g,\"norm_deltas\":%.9g}\n",
+						(unsigned long long)Record.Step, (unsigned long long)Record.Layer, layerTypeName(Record.Type), Record.NormParams, Record.NormDeltas);
+				}
+
+				Size = std::min(Size, int(sizeof(Line) - 1));
+				if(this->File.is_open()) this->File.write(Line, Size);
+				if(this->Socket >= 0) sendto(this->Socket, Line, Size, MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&this->SocketAddr), sizeof(this->SocketAddr));
+
+				this->Consumed.fetch_add(1, std::memory_order_release);
+			}
+
+			if(this->File.is_open()) this->File.flush();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Fold step into network info. Train time is kept in milliseconds.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto aggregate ( const TelemetryRecord& _Record ) -> void
+		{
+			this->Info.ErrMin = (this->Steps == 0) ? _Record.Loss : std::min(this->Info.ErrMin, rMAX(_Record.Loss));
+			this->Info.ErrMax = (this->Steps == 0) ? _Record.Loss : std::max(this->Info.ErrMax, rMAX(_Record.Loss));
+			this->Steps++;
+			this->Info.ErrAvg += (rMAX(_Record.Loss) - this->Info.ErrAvg) / rMAX(this->Steps);
+			this->Seconds += _Record.Seconds;
+			this->Info.TrainTime = uMAX(this->Seconds * 1e3);
+		}
+	};
+}
@@ -0,0 +1,355 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto PAR_MIN_WORK = uMAX(1) << 15; // Smallest amount of scalar operations worth sending to another thread.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Grain size for loop with given amount of work per iteration. Intended to be evaluated from compile time layer dimensions.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr inline auto parGrain ( const uMAX _WorkPerItem ) -> uMAX
+	{
+		return std::max(uMAX(1), PAR_MIN_WORK / std::max(uMAX(1), _WorkPerItem));
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Parallel loop shared by all its chunks.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ThreadJob
+	{
+		void (*Call) ( const void*, const uMAX, const uMAX, const uMAX ); // Type erased loop body.
+		const void* Fn;
+		uMAX Count;
+		uMAX Chunks;
+		std::atomic<uMAX> Pending;
+		bool Posted; // Detached job, body frees it and nobody waits for it.
+		std::atomic<bool> Failed;
+		std::exception_ptr Failure; // First exception escaped from chunk, set once by thread winning Failed.
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Single chunk of parallel loop.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct ThreadTask
+	{
+		ThreadJob* Job;
+		uMAX Chunk;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Work stealing thread pool. Each worker owns a queue and steals from the others once it runs dry.
+	// Thread calling parallelFor takes part in the work, so nested or concurrent calls always make progress.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class ThreadPool
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Per worker queue.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Queue
+		{
+			std::mutex Lock;
+			std::deque<ThreadTask> Tasks;
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		vec<std::thread> Workers;
+		vec<std::unique_ptr<Queue>> Queues;
+		std::atomic<uMAX> Queued;
+		std::atomic<uMAX> Next;
+		std::atomic<bool> Quit;
+		std::mutex SleepLock;
+		std::condition_variable Wake;
+		std::atomic<uMAX> PostPending; // Posted tasks not finished yet.
+		std::mutex PostLock;
+		std::exception_ptr PostFailure; // First exception escaped from posted task since last wait().
+
+		static inline thread_local bool InTask = false;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ThreadPool ( const uMAX _Threads = ThreadPool::defaultThreads() ) : Workers(), Queues(), Queued(0), Next(0), Quit(false), PostPending(0), PostFailure() { this->start(_Threads); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~ThreadPool ( void ) { this->stop(); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Library wide pool.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto global ( void ) -> ThreadPool&
+		{
+			static auto Pool = ThreadPool();
+			return Pool;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Default amount of workers. Calling thread is counted as one.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto defaultThreads ( void ) -> uMAX
+		{
+			const auto Hw = uMAX(std::thread::hardware_concurrency());
+			return (Hw > 1) ? (Hw - 1) : 0;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Get amount of workers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto size ( void ) const -> uMAX { return this->Workers.size(); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Change amount of workers. Must not be called while loops are running.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto resize ( const uMAX _Threads ) -> void
+		{
+			this->stop();
+			this->start(_Threads);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Amount of chunks loop of given size and grain will be split into.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto chunks ( const uMAX _Count, const uMAX _Grain ) const -> uMAX
+		{
+			if(InTask || this->Workers.empty()) return std::min(_Count, uMAX(1));
+			return std::min((_Count + _Grain - 1) / _Grain, this->size() + 1);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Run _Fn(Beg, End, Chunk) over [0, _Count) split into chunks(_Count, _Grain) parts.
+		// Chunk index is unique within call and can be used to select private accumulation buffer.
+		// Exception escaped from any chunk is rethrown here once all chunks finished, first one wins.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class FN> auto parallelFor ( const uMAX _Count, const uMAX _Grain, const FN& _Fn ) -> void
+		{
+			const auto Chunks = this->chunks(_Count, _Grain);
+
+			if(Chunks <= 1)
+			{
+				if(_Count) _Fn(uMAX(0), _Count, uMAX(0));
+				return;
+			}
+
+			auto Job = ThreadJob();
+			Job.Call = []( const void* _Fn, const uMAX _Beg, const uMAX _End, const uMAX _Chunk ) { (*static_cast<const FN*>(_Fn))(_Beg, _End, _Chunk); };
+			Job.Fn = &_Fn;
+			Job.Count = _Count;
+			Job.Chunks = Chunks;
+			Job.Pending.store(Chunks, std::memory_order_relaxed);
+
+			// Spread chunks over worker queues. First chunk is kept for calling thread.
+			const auto First = this->Next.fetch_add(Chunks - 1, std::memory_order_relaxed);
+			for(auto c = uMAX(1); c < Chunks; ++c)
+			{
+				auto& Q = *this->Queues[(First + c) % this->size()];
+				auto Lock = std::lock_guard(Q.Lock);
+				Q.Tasks.push_back(ThreadTask{&Job, c});
+			}
+
+			this->Queued.fetch_add(Chunks - 1, std::memory_order_release);
+			{ auto Lock = std::lock_guard(this->SleepLock); }
+			this->Wake.notify_all();
+
+			// Work until every chunk of this job is finished.
+			this->run(ThreadTask{&Job, 0});
+
+			auto Task = ThreadTask();
+			while(Job.Pending.load(std::memory_order_acquire) != 0)
+			{
+				if(this->pop(First % this->size(), Task)) this->run(Task);
+				else std::this_thread::yield();
+			}
+
+			if(Job.Failure) std::rethrow_exception(Job.Failure);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Run _Fn() once on some worker and return immediately. Body runs as pool task, so parallel loops inside it stay on its thread.
+		// Exception escaped from body is kept for wait(). Without workers it runs on calling thread before return and throws there.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class FN> auto post ( FN&& _Fn ) -> void
+		{
+			if(this->Workers.empty())
+			{
+				_Fn();
+				return;
+			}
+
+			struct Body : ThreadJob { std::decay_t<FN> Work; };
+			auto Job = new Body{{}, std::forward<FN>(_Fn)};
+			Job->Call = []( const void* _Job, const uMAX, const uMAX, const uMAX ) { const auto B = std::unique_ptr<Body>(static_cast<Body*>(const_cast<void*>(_Job))); B->Work(); };
+			Job->Fn = Job;
+			Job->Count = 1;
+			Job->Chunks = 1;
+			Job->Posted = true;
+
+			{
+				auto& Q = *this->Queues[this->Next.fetch_add(1, std::memory_order_relaxed) % this->size()];
+				auto Lock = std::lock_guard(Q.Lock);
+				Q.Tasks.push_back(ThreadTask{Job, 0});
+			}
+
+			this->PostPending.fetch_add(1, std::memory_order_relaxed);
+			this->Queued.fetch_add(1, std::memory_order_release);
+			{ auto Lock = std::lock_guard(this->SleepLock); }
+			this->Wake.notify_one();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Wait until posted tasks finished, helping with queued work meanwhile. First exception escaped from posted task since
+		// last wait is rethrown. Must not be called from pool task.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto wait ( void ) -> void
+		{
+			auto Task = ThreadTask();
+			while(this->PostPending.load(std::memory_order_acquire) != 0)
+			{
+				if(this->pop(0, Task)) this->run(Task);
+				else std::this_thread::yield();
+			}
+
+			auto Failure = std::exception_ptr();
+			{ auto Lock = std::lock_guard(this->PostLock); std::swap(Failure, this->PostFailure); }
+			if(Failure) std::rethrow_exception(Failure);
+		}
+
+		private:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Spawn workers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto start ( const uMAX _Threads ) -> void
+		{
+			this->Quit = false;
+			for(auto t = uMAX(0); t < _Threads; ++t) this->Queues.push_back(std::make_unique<Queue>());
+			for(auto t = uMAX(0); t < _Threads; ++t) this->Workers.emplace_back([this, t]( void ) { this->work(t); });
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Join workers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto stop ( void ) -> void
+		{
+			{ auto Lock = std::lock_guard(this->SleepLock); this->Quit = true; }
+			this->Wake.notify_all();
+
+			for(auto& Worker : this->Workers) Worker.join();
+			this->Workers.clear();
+			this->Queues.clear();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute single chunk. Exceptions are caught so they never leave worker, they are handed to thread waiting for job.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto run ( const ThreadTask& _Task ) -> void
+		{
+			auto& Job = *_Task.Job;
+			const auto Beg = (Job.Count * _Task.Chunk) / Job.Chunks;
+			const auto End = (Job.Count * (_Task.Chunk + 1)) / Job.Chunks;
+
+			const auto Posted = Job.Posted;
+			const auto InTaskLast = InTask;
+			InTask = true;
+
+			try
+			{
+				Job.Call(Job.Fn, Beg, End, _Task.Chunk);
+			}
+
+			catch(...)
+			{
+				if(Posted) { auto Lock = std::lock_guard(this->PostLock); if(!this->PostFailure) this->PostFailure = std::current_exception(); }
+				else if(!Job.Failed.exchange(true, std::memory_order_relaxed)) Job.Failure = std::current_exception();
+			}
+
+			InTask = InTaskLast;
+
+			if(Posted) this->PostPending.fetch_sub(1, std::memory_order_release);
+			else Job.Pending.fetch_sub(1, std::memory_order_acq_rel);
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Take task from own queue back or steal from front of other queues.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto pop ( const uMAX _Id, ThreadTask& _Task ) -> bool
+		{
+			if(this->Queued.load(std::memory_order_acquire) == 0) return false;
+
+			for(auto i = uMAX(0); i < this->size(); ++i)
+			{
+				auto& Q = *this->Queues[(_Id + i) % this->size()];
+				auto Lock = std::lock_guard(Q.Lock);
+				if(Q.Tasks.empty()) continue;
+
+				if(i == 0) { _Task = Q.Tasks.back(); Q.Tasks.pop_back(); }
+				else { _Task = Q.Tasks.front(); Q.Tasks.pop_front(); }
+
+				this->Queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+
+			return false;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Worker loop.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto work ( const uMAX _Id ) -> void
+		{
+			auto Task = ThreadTask();
+
+			while(true)
+			{
+				if(this->pop(_Id, Task)) { this->run(Task); continue; }
+
+				auto Lock = std::unique_lock(this->SleepLock);
+				this->Wake.wait(Lock, [&]( void ) { return this->Quit || (this->Queued.load(std::memory_order_acquire) != 0); });
+				if(this->Quit && (this->Queued.load(std::memory_order_acquire) == 0)) return;
+			}
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Shortcut to library wide pool.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto threadPool ( void ) -> ThreadPool& { return ThreadPool::global(); }
+}
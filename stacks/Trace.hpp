@@ -0,0 +1,344 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Macros. Traced scope, without SX_TRACE it is nothing. _Name and _Detail must be string literals or otherwise outlive trace.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	#define SX_MC_TRACE_CAT2(A, B) A##B
+	#define SX_MC_TRACE_CAT(A, B) SX_MC_TRACE_CAT2(A, B)
+	#if defined(SX_TRACE)
+	#define SX_MC_TRACE(NAME, DETAIL) const auto SX_MC_TRACE_CAT(TraceScope, __LINE__) = sx::TraceScope(NAME, DETAIL)
+	#else
+	#define SX_MC_TRACE(NAME, DETAIL) do {} while(false)
+	#endif
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr auto TRACE_RING = uMAX(1) << 16; // Default events per thread ring.
+	constexpr auto TRACE_FLUSH_MS = u64(20); // Period of asynchronous flush.
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Complete event. Names are not copied.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct TraceEvent
+	{
+		const char* Name;
+		const char* Detail;
+		u64 Beg; // Nanoseconds since start of trace.
+		u64 End;
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Single producer single consumer ring of one thread. Owner pushes without locks, flusher drains.
+	// Events that do not fit are dropped and counted, owner never waits.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct TraceRing
+	{
+		std::vector<TraceEvent> Events;
+		u64 Mask;
+		u64 Tid;
+		std::atomic<const char*> ThreadName;
+		bool NameWritten;
+		std::atomic<bool> Closed; // Owner thread ended.
+		std::atomic<u64> Dropped;
+		alignas(64) std::atomic<u64> Head; // Written by owner.
+		alignas(64) std::atomic<u64> Tail; // Written by flusher.
+
+		TraceRing ( const uMAX _Capacity, const u64 _Tid ) : Events(_Capacity), Mask(_Capacity - 1), Tid(_Tid), ThreadName(nullptr), NameWritten(false), Closed(false), Dropped(0), Head(0), Tail(0) {}
+
+		inline auto push ( const TraceEvent& _Event ) -> void
+		{
+			const auto H = this->Head.load(std::memory_order_relaxed);
+			if(H - this->Tail.load(std::memory_order_acquire) > this->Mask) { this->Dropped.fetch_add(1, std::memory_order_relaxed); return; }
+
+			this->Events[H & this->Mask] = _Event;
+			this->Head.store(H + 1, std::memory_order_release);
+		}
+
+		template<class FN> auto drain ( const FN& _Fn ) -> void
+		{
+			const auto T = this->Tail.load(std::memory_order_relaxed);
+			const auto H = this->Head.load(std::memory_order_acquire);
+
+			for(auto i = T; i < H; ++i) _Fn(this->Events[i & this->Mask]);
+			this->Tail.store(H, std::memory_order_release);
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Process wide tracer writing Chrome trace event JSON, viewable in chrome://tracing or Perfetto.
+	// Traces are per process: workers started by spawnWorkers should each start their own after fork.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Tracer
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		std::mutex Lock;
+		std::condition_variable Wake;
+		std::vector<std::shared_ptr<TraceRing>> Rings;
+		std::ofstream File;
+		std::thread Flusher;
+		std::atomic<bool> Enabled;
+		std::atomic<u64> Session; // Incremented by every start so threads register new rings.
+		std::chrono::steady_clock::time_point Origin;
+		uMAX Capacity;
+		u64 NextTid;
+		bool Quit;
+		bool First;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Ring of calling thread, registered on first use in session.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Local
+		{
+			std::shared_ptr<TraceRing> Ring;
+			u64 Session = 0;
+			~Local ( void ) { if(this->Ring) this->Ring->Closed = true; }
+		};
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Tracer ( void ) : Enabled(false), Session(0), Capacity(TRACE_RING), NextTid(0), Quit(false), First(true) {}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~Tracer ( void ) { this->stop(); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Start tracing into _File. Returns false if already tracing or file can not be created.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto start ( const str& _File, const uMAX _Capacity = TRACE_RING ) -> bool
+		{
+			auto Guard = std::lock_guard(this->Lock);
+			if(this->Enabled) return false;
+
+			this->File.open(_File, std::ios::trunc);
+			if(!this->File.is_open()) return false;
+			this->File << "{\"traceEvents\":[\n";
+
+			auto Capacity = uMAX(1);
+			while(Capacity < _Capacity) Capacity <<= 1;
+
+			this->Capacity = Capacity;
+			this->Rings.clear();
+			this->Origin = std::chrono::steady_clock::now();
+			this->Quit = false;
+			this->First = true;
+			this->Session++;
+			this->Enabled = true;
+			this->Flusher = std::thread([this]( void ) { this->flushLoop(); });
+
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Stop tracing, write remaining events and close file. Events of scopes still open are lost.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto stop ( void ) -> void
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				if(!this->Enabled) return;
+				this->Enabled = false;
+				this->Quit = true;
+			}
+			this->Wake.notify_all();
+			this->Flusher.join();
+
+			auto Guard = std::lock_guard(this->Lock);
+			this->flush();
+
+			auto Dropped = u64(0);
+			for(const auto& Ring : this->Rings) Dropped += Ring->Dropped;
+
+			this->File << "\n],\"otherData\":{\"dropped\":" << Dropped << "}}\n";
+			this->File.close();
+			this->Rings.clear();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Accessors.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto enabled ( void ) const -> bool { return this->Enabled.load(std::memory_order_acquire); }
+		inline auto session ( void ) const -> u64 { return this->Session.load(std::memory_order_acquire); }
+		inline auto now ( void ) const -> u64 { return u64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->Origin).count()); }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Ring of calling thread. Only valid while tracing.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto ring ( void ) -> TraceRing&
+		{
+			thread_local auto Mine = Local();
+
+			const auto Session = this->Session.load(std::memory_order_acquire);
+			if(Mine.Session != Session)
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				if(Mine.Ring) Mine.Ring->Closed = true;
+				Mine.Ring = std::make_shared<TraceRing>(this->Capacity, this->NextTid++);
+				Mine.Session = Session;
+				this->Rings.push_back(Mine.Ring);
+			}
+
+			return *Mine.Ring;
+		}
+
+		private:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Flusher loop.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto flushLoop ( void ) -> void
+		{
+			auto Guard = std::unique_lock(this->Lock);
+			while(!this->Quit)
+			{
+				this->Wake.wait_for(Guard, std::chrono::milliseconds(TRACE_FLUSH_MS), [this]( void ) { return this->Quit; });
+				this->flush();
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Drain all rings to file and forget rings of ended threads. Called under lock.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto flush ( void ) -> void
+		{
+			const auto Pid = u64(getpid());
+			char Line[512];
+
+			const auto emit = [&]( const int _Size )
+			{
+				if(!this->First) this->File << ",\n";
+				this->File.write(Line, std::min(_Size, int(sizeof(Line) - 1)));
+				this->First = false;
+			};
+
+			for(auto& Ring : this->Rings)
+			{
+				// Closed is read before draining, so ring dropped below has nothing left.
+				const auto Closed = Ring->Closed.load(std::memory_order_acquire);
+
+				const auto ThreadName = Ring->ThreadName.load();
+				if(ThreadName && !Ring->NameWritten)
+				{
+					emit(std::snprintf(Line, sizeof(Line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%llu,\"tid\":%llu,\"args\":{\"name\":\"%s\"}}", (unsigned long long)Pid, (unsigned long long)Ring->Tid, ThreadName));
+					Ring->NameWritten = true;
+				}
+
+				Ring->drain([&]( const TraceEvent& _Event )
+				{
+					emit(std::snprintf(Line, sizeof(Line), "{\"name\":\"%s%s%s\",\"cat\":\"sx\",\"ph\":\"X\",\"pid\":%llu,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+						_Event.Name, _Event.Detail ? "." : "", _Event.Detail ? _Event.Detail : "", (unsigned long long)Pid, (unsigned long long)Ring->Tid, r64(_Event.Beg) / 1e3, r64(_Event.End - _Event.Beg) / 1e3));
+				});
+
+				if(Closed) Ring.reset();
+			}
+
+			this->Rings.erase(std::remove(this->Rings.begin(), this->Rings.end(), nullptr), this->Rings.end());
+			this->File.flush();
+		}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Process tracer.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto tracer ( void ) -> Tracer&
+	{
+		static auto Instance = Tracer();
+		return Instance;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Start and stop tracing into Chrome trace file.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto traceStart ( const str& _File, const uMAX _Capacity = TRACE_RING ) -> bool { return tracer().start(_File, _Capacity); }
+	inline auto traceStop ( void ) -> void { tracer().stop(); }
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Name calling thread in trace. _Name must outlive trace.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto traceThread ( const char* _Name ) -> void
+	{
+		if(tracer().enabled()) tracer().ring().ThreadName = _Name;
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Records complete event from construction to destruction, if tracing was enabled at construction.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class TraceScope
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		TraceRing* Ring;
+		TraceEvent Event;
+		u64 Session;
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		TraceScope ( const char* _Name, const char* _Detail = nullptr ) : Ring(nullptr), Event{_Name, _Detail, 0, 0}, Session(0)
+		{
+			if(!_Name || !tracer().enabled()) return;
+			this->Ring = &tracer().ring();
+			this->Session = tracer().session();
+			this->Event.Beg = tracer().now();
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Destructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		~TraceScope ( void )
+		{
+			if(!this->Ring || this->Session != tracer().session()) return; // Ring of ended session may be gone.
+			this->Event.End = tracer().now();
+			this->Ring->push(this->Event);
+		}
+
+		TraceScope ( const TraceScope& ) = delete;
+		auto operator= ( const TraceScope& ) -> TraceScope& = delete;
+	};
+}
@@ -16,7 +16,8 @@ namespace sx
 
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Convolutional layer 2d.
+	// Convolutional layer 2d. With FN_STORE other than FP32 kernels are read in narrowed format and summed in T,
+	// pre-activations of batch are kept narrowed for backpropagation.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	template
 	<
@@ -28,12 +29,13 @@ namespace sx
 		uMAX RADIUS = 1,
 		bool USE_BIASES = true,
 		class FN_TRANS = FnTrRelu<T>,
-		FnOptim FN_OPTIM = FnOptim::ADAM
+		FnOptim FN_OPTIM = FnOptim::ADAM,
+		FnStore FN_STORE = FnStore::FP32
 	>
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	class Conv2 :
 		public Layer<T>,
-		LDWeights<T, FN_OPTIM, uMAX(((RADIUS*2)+1)*((RADIUS*2)+1))*KERNELS*DEPTH_IN, WIDTH_IN*HEIGHT_IN*DEPTH_IN, WIDTH_IN*HEIGHT_IN*KERNELS, FnInitWeights::DEFAULT>,
+		LDWeights<T, FN_OPTIM, uMAX(((RADIUS*2)+1)*((RADIUS*2)+1))*KERNELS*DEPTH_IN, WIDTH_IN*HEIGHT_IN*DEPTH_IN, WIDTH_IN*HEIGHT_IN*KERNELS, FnInitWeights::DEFAULT, FN_STORE>,
 		LDBiases<T, WIDTH_IN*HEIGHT_IN*KERNELS, 0, 0, FN_OPTIM>
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	{
@@ -53,48 +55,62 @@ namespace sx
 		constexpr static auto SZ_BUF_B = WIDTH_IN * HEIGHT_IN * KERNELS;
 		constexpr static auto SZ_IN = WIDTH_IN * HEIGHT_IN * DEPTH_IN;
 		constexpr static auto SZ_OUT = WIDTH_IN * HEIGHT_IN * KERNELS;
+		constexpr static auto SZ_OUT_K = WIDTH_IN * HEIGHT_IN;
+		constexpr static auto GRAIN_K = parGrain(SZ_KER * DEPTH_IN * SZ_OUT_K * 2); // Kernels per chunk.
 		
 
 		alignas(ALIGNMENT) T OutTrans[SZ_OUT];
 		alignas(ALIGNMENT) T OutTemp[SZ_OUT];
 		alignas(ALIGNMENT) T Gradient[SZ_IN];
+		vec<T> GradientPart; // Private gradient accumulators of parallel chunks.
+		BatchBuf<T> OutTransBatch;
+		BatchBuf<StoreT<FN_STORE,T>> OutTempBatch;
+		BatchBuf<T> DerBatch; // Transfer derivatives of batch.
+		BatchBuf<T> GradientBatch;
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Generated functions.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_MC_LAYER_TRIVIAL(Conv2, SZ_OUT, this->OutTrans, this->Gradient)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->OutTransBatch.data(), this->GradientBatch.data())
 
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		// Execute. Optimized for sequential access.
+		// Execute. Optimized for sequential access. Kernels are split across thread pool.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_FNSIG_LAYER_EXE final
 		{
-			memZero(SZ_OUT, this->OutTemp);
+			this->ready();
 
+			threadPool().parallelFor(KERNELS, GRAIN_K, [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				T KernelWide[SZ_KER];
+				memZero((_End - _Beg) * SZ_OUT_K, this->OutTemp + _Beg * SZ_OUT_K);
 
-			for(auto k = uMAX(0); k < KERNELS; ++k)
-			{ 
-				// Apply kernel on input.
-				for(auto d = uMAX(0); d < DEPTH_IN; ++d) { for(auto y = RADIUS; y < (HEIGHT_IN - RADIUS); ++y)
-				{
-					auto LineKernel = this->Weights + math::index_c(0, d, k, SZ_KER, DEPTH_IN);
-					auto LineOutTemp = this->OutTemp + math::index_c(RADIUS, y, k, WIDTH_IN, HEIGHT_IN);
 
-					for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
+				for(auto k = _Beg; k < _End; ++k)
+				{ 
+					// Apply kernel on input.
+					for(auto d = uMAX(0); d < DEPTH_IN; ++d) { for(auto y = RADIUS; y < (HEIGHT_IN - RADIUS); ++y)
 					{
-						auto LineInput = this->Input + math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
-						for(auto x = uMAX(0); x < LINE_LEN; ++x) for(auto w = uMAX(0); w < SZ_KER_EDGE; ++w) LineOutTemp[x] += LineInput[x+w] * LineKernel[math::index_c(w, kr, SZ_KER_EDGE)];
-					}
-				}}
-			}
+						auto LineKernel = this->weightsAt(math::index_c(0, d, k, SZ_KER, DEPTH_IN), SZ_KER, KernelWide);
+						auto LineOutTemp = this->OutTemp + math::index_c(RADIUS, y, k, WIDTH_IN, HEIGHT_IN);
 
-			// Apply biases and transfer values.
-			for(auto o = uMAX(0); o < (WIDTH_IN * HEIGHT_IN * KERNELS); ++o)
-			{
-				if constexpr(USE_BIASES) this->OutTemp[o] += this->Biases[o];
-				this->OutTrans[o] = FN_TRANS::trans(this->OutTemp[o]);
-			}
+						for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
+						{
+							auto LineInput = this->Input + math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
+							for(auto x = uMAX(0); x < LINE_LEN; ++x) for(auto w = uMAX(0); w < SZ_KER_EDGE; ++w) LineOutTemp[x] += LineInput[x+w] * LineKernel[math::index_c(w, kr, SZ_KER_EDGE)];
+						}
+					}}
+				}
+
+				// Apply biases and transfer values.
+				for(auto o = _Beg * SZ_OUT_K; o < (_End * SZ_OUT_K); ++o)
+				{
+					if constexpr(USE_BIASES) this->OutTemp[o] += this->BiasesSrc[o];
+					this->OutTrans[o] = FN_TRANS::trans(this->OutTemp[o]);
+				}
+			});
 
 
 			SX_MC_LAYER_NEXT_EXE;
@@ -102,75 +118,230 @@ namespace sx
 
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		// Backpropagate. Optimized for memory order.
+		// Backpropagate. Optimized for memory order. Each chunk accumulates gradient privately, partial gradients are reduced afterwards.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_FNSIG_LAYER_FIT final
 		{
-			memZero(SZ_IN, this->Gradient);
-
+			this->ready(!this->IsLocked);
 
 			if(!this->IsLocked)
 			{
-				T LineDerTrans[LINE_LEN];
+				const auto Chunks = threadPool().chunks(KERNELS, GRAIN_K);
+				if(this->GradientPart.size() < (Chunks - 1) * SZ_IN) this->GradientPart.resize((Chunks - 1) * SZ_IN);
+
 				auto PtrFrontGradient = this->Front->gradient();
 				auto PtrTrDerSrc = this->OutTemp;
 				if constexpr(!FN_TRANS::RAW) PtrTrDerSrc = this->OutTrans;
 
-				for(auto k = uMAX(0); k < KERNELS; ++k)
-				{ 
-					// For each channel.
-					for(auto d = uMAX(0); d < DEPTH_IN; ++d) { for(auto y = RADIUS; y < (HEIGHT_IN - RADIUS); ++y)
+				threadPool().parallelFor(KERNELS, GRAIN_K, [&]( const uMAX _Beg, const uMAX _End, const uMAX _Chunk )
+				{
+					T LineDerTrans[LINE_LEN];
+					T KernelWide[SZ_KER];
+					auto Gradient = (_Chunk == 0) ? this->Gradient : (this->GradientPart.data() + (_Chunk - 1) * SZ_IN);
+					memZero(SZ_IN, Gradient);
+
+					for(auto k = _Beg; k < _End; ++k)
+					{ 
+						// For each channel.
+						for(auto d = uMAX(0); d < DEPTH_IN; ++d) { for(auto y = RADIUS; y < (HEIGHT_IN - RADIUS); ++y)
+						{
+							const auto OffKernel = math::index_c(0, d, k, SZ_KER, DEPTH_IN);
+							auto LineKernel = this->weightsAt(OffKernel, SZ_KER, KernelWide);
+							auto LineKernelDlt = this->WeightsDlt + OffKernel;
+
+							const auto OffOut =  math::index_c(RADIUS, y, k, WIDTH_IN, HEIGHT_IN);
+							auto LineOutUn = PtrTrDerSrc + OffOut;
+							
+							memCopy(LINE_LEN, LineDerTrans, PtrFrontGradient + OffOut);
+							for(auto x = uMAX(0); x < LINE_LEN; ++x) LineDerTrans[x] *= FN_TRANS::der(LineOutUn[x]);;
+
+							for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
+							{ 
+								const auto OffIn = math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
+								auto LineInput = this->Input + OffIn;
+								auto LineGrad = Gradient + OffIn;
+
+								for(auto x = uMAX(0); x < LINE_LEN; ++x)
+								{
+									for(auto w = uMAX(0); w < SZ_KER_EDGE; ++w)
+									{
+										const auto IdxKer = math::index_c(w, kr, SZ_KER_EDGE);
+										LineKernelDlt[IdxKer] += LineInput[x+w] * LineDerTrans[x];
+										LineGrad[x+w] += LineKernel[IdxKer] * LineDerTrans[x];
+									}
+								}
+							}
+						}}
+					}
+
+					// Apply biases and transfer values.
+					if constexpr(USE_BIASES)
 					{
-						const auto OffKernel = math::index_c(0, d, k, SZ_KER, DEPTH_IN);
-						auto LineKernel = this->Weights + OffKernel;
-						auto LineKernelDlt = this->WeightsDlt + OffKernel;
+						auto OutNeeded = this->OutTrans;
+						if constexpr(FN_TRANS::RAW) OutNeeded = this->OutTemp;
+
+						for(auto o = _Beg * SZ_OUT_K; o < (_End * SZ_OUT_K); ++o)
+						{
+							const auto DerErr = this->Front->gradient()[o];
+							const auto DerTrans = FN_TRANS::der(OutNeeded[o]) * DerErr;
+							this->BiasesDlt[o] += DerTrans;
+						}
+					}
+				});
 
-						const auto OffOut =  math::index_c(RADIUS, y, k, WIDTH_IN, HEIGHT_IN);
-						auto LineOutUn = PtrTrDerSrc + OffOut;
-						
-						memCopy(LINE_LEN, LineDerTrans, PtrFrontGradient + OffOut);
-						for(auto x = 0; x < LINE_LEN; ++x) LineDerTrans[x] *= FN_TRANS::der(LineOutUn[x]);;
+				// Reduce partial gradients.
+				for(auto c = uMAX(1); c < Chunks; ++c)
+				{
+					const auto Part = this->GradientPart.data() + (c - 1) * SZ_IN;
+					for(auto i = uMAX(0); i < SZ_IN; ++i) this->Gradient[i] += Part[i];
+				}
+			}
 
-						for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
-						{ 
-							const auto OffIn = math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
-							auto LineInput = this->Input + OffIn;
-							auto LineGrad = this->Gradient + OffIn;
+			else
+			{
+				memZero(SZ_IN, this->Gradient);
+			}
+
+			SX_MC_LAYER_NEXT_FIT;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch. Kernels are split across thread pool and each chunk runs all samples through its kernels.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			this->ready();
+
+			const auto OutTemp = this->OutTempBatch.reserve(_Count * SZ_OUT);
+			const auto OutTrans = this->OutTransBatch.reserve(_Count * SZ_OUT);
+
+			threadPool().parallelFor(KERNELS, parGrain(SZ_KER * DEPTH_IN * SZ_OUT_K * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				T KernelWide[SZ_KER];
+
+				for(auto n = uMAX(0); n < _Count; ++n)
+				{
+					// Sums are accumulated in outputs, pre-activations are kept in storage format.
+					const auto Input = this->inBatch(n);
+					const auto SampleTemp = OutTemp + math::index_c(0, n, SZ_OUT);
+					const auto SampleTrans = OutTrans + math::index_c(0, n, SZ_OUT);
+					memZero((_End - _Beg) * SZ_OUT_K, SampleTrans + _Beg * SZ_OUT_K);
+
+					for(auto k = _Beg; k < _End; ++k)
+					{
+						// Apply kernel on input.
+						for(auto d = uMAX(0); d < DEPTH_IN; ++d) { for(auto y = RADIUS; y < (HEIGHT_IN - RADIUS); ++y)
+						{
+							auto LineKernel = this->weightsAt(math::index_c(0, d, k, SZ_KER, DEPTH_IN), SZ_KER, KernelWide);
+							auto LineOutTemp = SampleTrans + math::index_c(RADIUS, y, k, WIDTH_IN, HEIGHT_IN);
+
+							for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
+							{
+								auto LineInput = Input + math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
+								for(auto x = uMAX(0); x < LINE_LEN; ++x) for(auto w = uMAX(0); w < SZ_KER_EDGE; ++w) LineOutTemp[x] += LineInput[x+w] * LineKernel[math::index_c(w, kr, SZ_KER_EDGE)];
+							}
+						}}
+					}
+
+					// Apply biases and transfer values.
+					for(auto o = _Beg * SZ_OUT_K; o < (_End * SZ_OUT_K); ++o)
+					{
+						auto Raw = SampleTrans[o];
+						if constexpr(USE_BIASES) Raw += this->BiasesSrc[o];
+						SampleTemp[o] = storeNarrow<FN_STORE>(Raw);
+						SampleTrans[o] = FN_TRANS::trans(Raw);
+					}
+				}
+			});
+
+			SX_MC_LAYER_NEXT_EXE_BATCH;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate batch. Deltas are accumulated by chunks owning kernels, gradient by chunks owning input planes,
+		// so no partial buffers are needed.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT_BATCH final
+		{
+			this->ready(!this->IsLocked);
+
+			const auto Gradient = this->GradientBatch.reserve(_Count * SZ_IN);
+
+			if(!this->IsLocked)
+			{
+				const auto FrontGradient = this->Front->gradientBatch();
+				const auto Der = this->DerBatch.reserve(_Count * SZ_OUT);
 
-							for(auto x = 0; x < LINE_LEN; ++x)
+				const auto OutTrans = this->OutTransBatch.data();
+				const auto OutTemp = this->OutTempBatch.data();
+				const auto outNeeded = [&]( const uMAX _I ) -> T { if constexpr(FN_TRANS::RAW) return storeWiden<FN_STORE,T>(OutTemp[_I]); else return OutTrans[_I]; };
+
+				threadPool().parallelFor(KERNELS, parGrain(SZ_KER * DEPTH_IN * SZ_OUT_K * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+				{
+					for(auto n = uMAX(0); n < _Count; ++n)
+					{
+						const auto Input = this->inBatch(n);
+						const auto SampleDer = Der + math::index_c(0, n, SZ_OUT);
+
+						for(auto o = _Beg * SZ_OUT_K; o < (_End * SZ_OUT_K); ++o)
+						{
+							const auto i = math::index_c(o, n, SZ_OUT);
+							SampleDer[o] = FN_TRANS::der(outNeeded(i)) * FrontGradient[i];
+							if constexpr(USE_BIASES) this->BiasesDlt[o] += SampleDer[o];
+						}
+
+						for(auto k = _Beg; k < _End; ++k)
+						{
+							for(auto d = uMAX(0); d < DEPTH_IN; ++d) { for(auto y = RADIUS; y < (HEIGHT_IN - RADIUS); ++y)
 							{
-								for(auto w = uMAX(0); w < SZ_KER_EDGE; ++w)
+								auto LineKernelDlt = this->WeightsDlt + math::index_c(0, d, k, SZ_KER, DEPTH_IN);
+								auto LineDer = SampleDer + math::index_c(RADIUS, y, k, WIDTH_IN, HEIGHT_IN);
+
+								for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
 								{
-									const auto IdxKer = math::index_c(w, kr, SZ_KER_EDGE);
-									LineKernelDlt[IdxKer] += LineInput[x+w] * LineDerTrans[x];
-									LineGrad[x+w] += LineKernel[IdxKer] * LineDerTrans[x];
+									auto LineInput = Input + math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
+									for(auto x = uMAX(0); x < LINE_LEN; ++x) for(auto w = uMAX(0); w < SZ_KER_EDGE; ++w) LineKernelDlt[math::index_c(w, kr, SZ_KER_EDGE)] += LineInput[x+w] * LineDer[x];
 								}
-							}
+							}}
 						}
-					}}
-				}
+					}
+				});
 
-				// Apply biases and transfer values.
-				if constexpr(USE_BIASES)
+				threadPool().parallelFor(_Count * DEPTH_IN, parGrain(SZ_KER * KERNELS * SZ_OUT_K * 2), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
 				{
-					auto OutNeeded = this->OutTrans;
-					if constexpr(FN_TRANS::RAW) OutNeeded = this->OutTemp;
+					T KernelWide[SZ_KER];
 
-					for(auto o = uMAX(0); o < (WIDTH_IN * HEIGHT_IN * KERNELS); ++o)
+					for(auto p = _Beg; p < _End; ++p)
 					{
-						const auto DerErr = this->Front->gradient()[o];
-						const auto DerTrans = FN_TRANS::der(OutNeeded[o]) * DerErr;
-						this->BiasesDlt[o] += DerTrans;
+						const auto n = p / DEPTH_IN;
+						const auto d = p % DEPTH_IN;
+						const auto SampleDer = Der + math::index_c(0, n, SZ_OUT);
+						const auto SampleGrad = Gradient + math::index_c(0, n, SZ_IN);
+						memZero(SZ_OUT_K, SampleGrad + math::index_c(0, 0, d, WIDTH_IN, HEIGHT_IN));
+
+						for(auto k = uMAX(0); k < KERNELS; ++k) { for(auto y = RADIUS; y < (HEIGHT_IN - RADIUS); ++y)
+						{
+							auto LineKernel = this->weightsAt(math::index_c(0, d, k, SZ_KER, DEPTH_IN), SZ_KER, KernelWide);
+							auto LineDer = SampleDer + math::index_c(RADIUS, y, k, WIDTH_IN, HEIGHT_IN);
+
+							for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
+							{
+								auto LineGrad = SampleGrad + math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
+								for(auto x = uMAX(0); x < LINE_LEN; ++x) for(auto w = uMAX(0); w < SZ_KER_EDGE; ++w) LineGrad[x+w] += LineKernel[math::index_c(w, kr, SZ_KER_EDGE)] * LineDer[x];
+							}
+						}}
 					}
-				}
+				});
 			}
 
 			else
 			{
-
+				memZero(_Count * SZ_IN, Gradient);
 			}
 
-			SX_MC_LAYER_NEXT_FIT;
+			SX_MC_LAYER_NEXT_FIT_BATCH;
 		}
 
 
@@ -208,5 +379,47 @@ namespace sx
 		// Multi threading utility.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		#include "./data/ComImplExchange.hpp"
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Move parameters or deltas through flat buffers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplGather.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Norms of parameters and deltas.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplNorms.hpp"
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::CONV2, SZ_IN, SZ_OUT, SZ_BUF_W, SZ_BUF_B}; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			constexpr auto TAPS = KERNELS * DEPTH_IN * (HEIGHT_IN - RADIUS * 2) * LINE_LEN * SZ_KER;
+
+			if(_Op == LayerOp::EXE) return LayerCost{2 * TAPS + SZ_OUT, SZ_BUF_W * sizeof(StoreT<FN_STORE,T>) + (SZ_IN + SZ_BUF_B + SZ_OUT) * sizeof(T)};
+			if(_Op == LayerOp::FIT) return LayerCost{4 * TAPS + SZ_OUT * 2, SZ_BUF_W * sizeof(StoreT<FN_STORE,T>) + (3 * SZ_IN + 2 * SZ_BUF_W + SZ_BUF_B + 2 * SZ_OUT) * sizeof(T)};
+			if(_Op == LayerOp::APPLY) return applyCost<T,FN_OPTIM>(SZ_BUF_W + SZ_BUF_B);
+			return LayerCost{0, 0};
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute with external read only parameters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplBind.hpp"
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Zero smallest weights and keep them zero while training.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplPrune.hpp"
 	};
 }
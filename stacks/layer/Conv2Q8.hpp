@@ -0,0 +1,237 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Quantized convolutional layer 2d for inference. Kernels are int8 with scale per kernel. Each input line is unrolled into int8 patches,
+	// so every output is single int8 dot product of patch and kernel, dequantized, biased and transferred in one pass.
+	// Parameters come from float Conv2 of same configuration through quantize().
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template
+	<
+		class T,
+		uMAX WIDTH_IN,
+		uMAX HEIGHT_IN,
+		uMAX DEPTH_IN,
+		uMAX KERNELS = 1,
+		uMAX RADIUS = 1,
+		bool USE_BIASES = true,
+		class FN_TRANS = FnTrRelu<T>
+	>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Conv2Q8 :
+		public Layer<T>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Compile time constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		constexpr static auto SZ_KER_EDGE = uMAX(RADIUS * 2 + 1);
+		constexpr static auto SZ_KER = SZ_KER_EDGE * SZ_KER_EDGE;
+		constexpr static auto LINE_LEN = WIDTH_IN - (RADIUS * 2);
+		constexpr static auto LINES = HEIGHT_IN - (RADIUS * 2);
+
+		constexpr static auto SZ_PATCH = SZ_KER * DEPTH_IN; // Kernel laid out as [DEPTH_IN][SZ_KER_EDGE][SZ_KER_EDGE], as Conv2 keeps it.
+		constexpr static auto SZ_PATCH_Q = quantPad(SZ_PATCH);
+		constexpr static auto SZ_BUF_W = KERNELS * SZ_PATCH_Q;
+		constexpr static auto SZ_BUF_B = WIDTH_IN * HEIGHT_IN * KERNELS;
+		constexpr static auto SZ_IN = WIDTH_IN * HEIGHT_IN * DEPTH_IN;
+		constexpr static auto SZ_OUT = WIDTH_IN * HEIGHT_IN * KERNELS;
+		constexpr static auto SZ_OUT_K = WIDTH_IN * HEIGHT_IN;
+		constexpr static auto GRAIN_LINE = parGrain(SZ_PATCH * KERNELS * LINE_LEN * 2); // Lines per chunk.
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		alignas(ALIGNMENT) i8 Weights[SZ_BUF_W];
+		alignas(ALIGNMENT) T Scales[KERNELS]; // Input scale times weight scale of kernel.
+		alignas(ALIGNMENT) T Biases[SZ_BUF_B];
+		alignas(ALIGNMENT) T OutTrans[SZ_OUT];
+		alignas(ALIGNMENT) i8 InputQ[SZ_IN];
+		T InScale;
+		BatchBuf<i8> Patches; // Unrolled line of each chunk.
+		BatchBuf<T> OutTransBatch;
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute single sample into _OutTrans. Lines are split across thread pool.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto exeSample ( const T* _Input, T* _OutTrans ) -> void
+		{
+			quantizeS8(SZ_IN, _Input, this->InputQ, this->InScale);
+
+			const auto Chunks = threadPool().chunks(LINES, GRAIN_LINE);
+			const auto Patches = this->Patches.reserve(Chunks * LINE_LEN * SZ_PATCH_Q);
+
+			threadPool().parallelFor(LINES, GRAIN_LINE, [&]( const uMAX _Beg, const uMAX _End, const uMAX _Chunk )
+			{
+				const auto Line = Patches + _Chunk * LINE_LEN * SZ_PATCH_Q;
+
+				for(auto y = RADIUS + _Beg; y < RADIUS + _End; ++y)
+				{
+					// Unroll patches of line, padding stays zero.
+					for(auto x = uMAX(0); x < LINE_LEN; ++x)
+					{
+						auto Patch = Line + x * SZ_PATCH_Q;
+						for(auto d = uMAX(0); d < DEPTH_IN; ++d) for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
+						{
+							memCopy(SZ_KER_EDGE, Patch, this->InputQ + math::index_c(x, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN));
+							Patch += SZ_KER_EDGE;
+						}
+						memZero(SZ_PATCH_Q - SZ_PATCH, Patch);
+					}
+
+					for(auto k = uMAX(0); k < KERNELS; ++k)
+					{
+						const auto Kernel = this->Weights + k * SZ_PATCH_Q;
+						const auto Off = math::index_c(RADIUS, y, k, WIDTH_IN, HEIGHT_IN);
+
+						for(auto x = uMAX(0); x < LINE_LEN; ++x)
+						{
+							auto Value = T(dotS8(SZ_PATCH_Q, Kernel, Line + x * SZ_PATCH_Q)) * this->Scales[k];
+							if constexpr(USE_BIASES) Value += this->Biases[Off + x];
+							_OutTrans[Off + x] = FN_TRANS::trans(Value);
+						}
+					}
+				}
+			});
+
+			// Border is not convolved, it holds transferred biases as in Conv2.
+			for(auto k = uMAX(0); k < KERNELS; ++k) for(auto y = uMAX(0); y < HEIGHT_IN; ++y) for(auto x = uMAX(0); x < WIDTH_IN; ++x)
+			{
+				if((y >= RADIUS) && (y < HEIGHT_IN - RADIUS) && (x >= RADIUS) && (x < WIDTH_IN - RADIUS)) continue;
+				const auto o = math::index_c(x, y, k, WIDTH_IN, HEIGHT_IN);
+				_OutTrans[o] = FN_TRANS::trans(USE_BIASES ? this->Biases[o] : T(0));
+			}
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Generated functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_MC_LAYER_TRIVIAL(Conv2Q8, SZ_OUT, this->OutTrans, nullptr)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->OutTransBatch.data(), nullptr)
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Conv2Q8 ( void ) : Weights{}, Scales{}, Biases{}, OutTrans{}, InputQ{}, InScale(1), Patches(), OutTransBatch() { this->IsLocked = true; }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE final
+		{
+			this->exeSample(this->Input, this->OutTrans);
+			SX_MC_LAYER_NEXT_EXE;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch sample by sample, kernels and unrolled lines stay in cache either way.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			const auto OutTrans = this->OutTransBatch.reserve(_Count * SZ_OUT);
+			for(auto n = uMAX(0); n < _Count; ++n) this->exeSample(this->inBatch(n), OutTrans + n * SZ_OUT);
+
+			SX_MC_LAYER_NEXT_EXE_BATCH;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Quantized layers are not trained.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT final { throw fx::Error("sx"s, "Conv2Q8<T>"s, "fit"s, 0, "Quantized layer can not be trained!"s); }
+		SX_FNSIG_LAYER_FIT_BATCH final { throw fx::Error("sx"s, "Conv2Q8<T>"s, "fitBatch"s, 0, "Quantized layer can not be trained!"s); }
+		SX_FNSIG_LAYER_EXCHANGE final { throw fx::Error("sx"s, "Conv2Q8<T>"s, "exchange"s, 0, "Quantized layer can not be trained!"s); }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Take parameters of float Conv2. Every kernel gets own weight scale.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_QUANTIZE final
+		{
+			if(!_Source || !(_Source->desc() == LayerDesc{LayerType::CONV2, SZ_IN, SZ_OUT, KERNELS * SZ_PATCH, SZ_BUF_B})) return false;
+
+			auto Params = vec<T>(KERNELS * SZ_PATCH + SZ_BUF_B);
+			_Source->gather(Params.data(), LayerBuf::PARAMS, false);
+
+			this->InScale = quantScale(T(_Range));
+			memZero(SZ_BUF_W, this->Weights);
+
+			for(auto k = uMAX(0); k < KERNELS; ++k)
+			{
+				const auto Kernel = Params.data() + k * SZ_PATCH;
+				const auto Scale = quantScale(quantMaxAbs(SZ_PATCH, Kernel));
+				quantizeS8(SZ_PATCH, Kernel, this->Weights + k * SZ_PATCH_Q, Scale);
+				this->Scales[k] = this->InScale * Scale;
+			}
+
+			memCopy(SZ_BUF_B, this->Biases, Params.data() + KERNELS * SZ_PATCH);
+			return true;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Store parameters to stream.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_STORE final
+		{
+			_Stream.write(reinterpret_cast<const char*>(&this->InScale), sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Scales), KERNELS * sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Biases), SZ_BUF_B * sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Weights), SZ_BUF_W);
+
+			SX_MC_LAYER_NEXT_STORE;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Load parameters from stream.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_LOAD final
+		{
+			_Stream.read(reinterpret_cast<char*>(&this->InScale), sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(this->Scales), KERNELS * sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(this->Biases), SZ_BUF_B * sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(this->Weights), SZ_BUF_W);
+
+			SX_MC_LAYER_NEXT_LOAD;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes. Int8 parameters are not Ts, so none are reported.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::CONV2_Q8, SZ_IN, SZ_OUT, 0, 0}; }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			constexpr auto TAPS = KERNELS * LINES * LINE_LEN * SZ_PATCH;
+
+			if(_Op == LayerOp::EXE) return LayerCost{2 * TAPS + 3 * SZ_OUT, SZ_IN * (sizeof(T) + 1) + LINES * LINE_LEN * SZ_PATCH_Q + SZ_BUF_W + (SZ_BUF_B + SZ_OUT) * sizeof(T)};
+			return LayerCost{0, 0};
+		}
+	};
+}
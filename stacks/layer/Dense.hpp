@@ -16,7 +16,8 @@ namespace sx
 
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Dense layer.
+	// Dense layer. With FN_STORE other than FP32 weights are read in narrowed format and summed in T,
+	// fp32 weights are kept for optimizer and pre-activations of batch are kept narrowed for backpropagation.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	template
 	<
@@ -24,13 +25,14 @@ namespace sx
 		uMAX SZ_IN,
 		uMAX SZ_OUT,
 		class FN_TRANS,
-		FnOptim FN_OPTIM = FnOptim::ADAM
+		FnOptim FN_OPTIM = FnOptim::ADAM,
+		FnStore FN_STORE = FnStore::FP32
 	>
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	class Dense :
 		public Layer<T>,
 		LDOutputs<T, SZ_OUT, SZ_IN, FnTrans::RELU>,
-		LDWeights<T, FN_OPTIM, SZ_IN*SZ_OUT, SZ_IN, SZ_OUT, FnInitWeights::NRM_RELU>,
+		LDWeights<T, FN_OPTIM, SZ_IN*SZ_OUT, SZ_IN, SZ_OUT, FnInitWeights::NRM_RELU, FN_STORE>,
 		LDBiases<T, SZ_OUT, SZ_IN, SZ_OUT, FN_OPTIM>
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	{
@@ -39,12 +41,54 @@ namespace sx
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		constexpr static auto SZ_BUF_W = SZ_OUT * SZ_IN;
 		constexpr static auto SZ_BUF_B = SZ_OUT;
+		constexpr static auto GRAIN_OUT = parGrain(SZ_IN * 2); // Outputs per chunk.
+		constexpr static auto BLOCK_OUT = std::max(uMAX(1), uMAX(1 << 16) / (SZ_IN * sizeof(T))); // Outputs whose weights stay in cache while batch passes them.
+		constexpr static auto SZ_STORE = sizeof(StoreT<FN_STORE,T>); // Bytes of stored weight.
 		
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		vec<T> GradientPart; // Private gradient accumulators of parallel chunks.
+		BatchBuf<T> OutTransBatch;
+		BatchBuf<StoreT<FN_STORE,T>> OutRawBatch;
+		BatchBuf<T> WeightsWideBatch; // Blocks of narrowed weights widened by chunks of batch.
+		BatchBuf<T> DerBatch; // Transfer derivatives of batch.
+		BatchBuf<T> GradientBatch;
+		alignas(ALIGNMENT) u32 ActiveIdx[SZ_IN]; // Positions of non zero inputs of last execution.
+		alignas(ALIGNMENT) T ActiveVal[SZ_IN];
+		uMAX ActiveCount;
+		r64 SparseDensity; // Share of non zero inputs below which only they are visited.
+		bool Sparse; // Last execution compacted inputs and took sparse path, backpropagation follows it.
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Whether inputs are sparse enough. Non zero inputs are counted first, so dense ones are never compacted.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto sparse ( void ) const -> bool
+		{
+			const auto Limit = this->SparseDensity * r64(SZ_IN);
+			return (Limit > 0.0) && (r64(sparseCount(SZ_IN, this->Input)) < Limit);
+		}
+
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Generated functions.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_MC_LAYER_TRIVIAL(Dense, SZ_OUT, this->OutTrans, this->Gradient)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->OutTransBatch.data(), this->GradientBatch.data())
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Dense ( void ) : ActiveCount(0), SparseDensity((FN_STORE == FnStore::FP32) ? SPARSE_DENSITY : SPARSE_DENSITY_STORED), Sparse(false) {}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Set share of non zero inputs below which single sample execution and backpropagation take sparse path. Zero disables it.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto sparseDensity ( const r64 _Density ) -> void { this->SparseDensity = _Density; }
 
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -52,61 +96,206 @@ namespace sx
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_FNSIG_LAYER_EXE final
 		{
-			for(auto o = uMAX(0); o < SZ_OUT; ++o)
+			this->ready();
+
+			// Sparse inputs are compacted once, sparse path sums only them.
+			this->Sparse = this->sparse();
+			if(this->Sparse) this->ActiveCount = sparseCompact(SZ_IN, this->Input, this->ActiveIdx, this->ActiveVal);
+
+			const auto Sparse = this->Sparse;
+			const auto dot = [&]( const uMAX _O ) -> T
 			{
-				if constexpr(FN_TRANS::RAW)
-				{
-					this->OutRaw[o] = std::inner_product(this->Input, this->Input + SZ_IN, this->Weights + math::index_c(0, o, SZ_IN), T(0)) + this->Biases[o];
-					this->OutTrans[o] = FN_TRANS::trans(this->OutRaw[o]);
-				}
+				const auto Row = this->weightsStored(math::index_c(0, _O, SZ_IN));
+				return Sparse ? sparseDot<FN_STORE>(this->ActiveCount, this->ActiveIdx, this->ActiveVal, Row) : storeDot<FN_STORE>(SZ_IN, this->Input, Row);
+			};
 
-				else
+			threadPool().parallelFor(SZ_OUT, GRAIN_OUT, [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto o = _Beg; o < _End; ++o)
 				{
-					this->OutTrans[o] =  FN_TRANS::trans(std::inner_product(this->Input, this->Input + SZ_IN, this->Weights + math::index_c(0, o, SZ_IN), T(0)) + this->Biases[o]);
+					if constexpr(FN_TRANS::RAW)
+					{
+						this->OutRaw[o] = dot(o) + this->BiasesSrc[o];
+						this->OutTrans[o] = FN_TRANS::trans(this->OutRaw[o]);
+					}
+
+					else
+					{
+						this->OutTrans[o] =  FN_TRANS::trans(dot(o) + this->BiasesSrc[o]);
+					}
 				}
-			}
+			});
 
 			SX_MC_LAYER_NEXT_EXE;
 		}
 
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		// Backpropagate.
+		// Backpropagate. Each chunk accumulates gradient privately, partial gradients are reduced afterwards.
+		// Outputs with zero derivative are skipped, sparse path updates deltas of non zero inputs found by execution only.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_FNSIG_LAYER_FIT final
 		{
-			memZero(SZ_IN, this->Gradient);
+			this->ready(!this->IsLocked);
+
+			const auto Sparse = this->Sparse; // Compacted inputs are fresh only when execution took sparse path.
+
+			const auto Chunks = threadPool().chunks(SZ_OUT, GRAIN_OUT);
+			if(this->GradientPart.size() < (Chunks - 1) * SZ_IN) this->GradientPart.resize((Chunks - 1) * SZ_IN);
 
 			auto OutNeeded = this->OutTrans;
 			if constexpr(FN_TRANS::RAW) OutNeeded = this->OutRaw;
 			
-			if(!this->IsLocked)
+			threadPool().parallelFor(SZ_OUT, GRAIN_OUT, [&]( const uMAX _Beg, const uMAX _End, const uMAX _Chunk )
 			{
-				for(auto o = uMAX(0); o < SZ_OUT; ++o)
+				auto Gradient = (_Chunk == 0) ? this->Gradient : (this->GradientPart.data() + (_Chunk - 1) * SZ_IN);
+				memZero(SZ_IN, Gradient);
+
+				if(!this->IsLocked)
 				{
-					const auto DerErr = this->Front->gradient()[o];
-					const auto DerTrans = std::clamp(FN_TRANS::der(OutNeeded[o]) * DerErr, T(-1), T(1));
+					for(auto o = _Beg; o < _End; ++o)
+					{
+						const auto DerErr = this->Front->gradient()[o];
+						const auto DerTrans = std::clamp(FN_TRANS::der(OutNeeded[o]) * DerErr, T(-1), T(1));
+						if(DerTrans == T(0)) continue;
 
-					vops::mulVecByConstAddToOut(SZ_IN, this->Gradient, &this->Weights[math::index_c(0, o, SZ_IN)], DerTrans);
-					vops::mulVecByConstAddToOut(SZ_IN, &this->WeightsDlt[math::index_c(0, o, SZ_IN)], this->Input, DerTrans);
-					this->BiasesDlt[o] += DerTrans;
+						storeAxpy<FN_STORE>(SZ_IN, Gradient, this->weightsStored(math::index_c(0, o, SZ_IN)), DerTrans);
+						if(Sparse) sparseAxpy(this->ActiveCount, this->ActiveIdx, this->ActiveVal, &this->WeightsDlt[math::index_c(0, o, SZ_IN)], DerTrans);
+						else vops::mulVecByConstAddToOut(SZ_IN, &this->WeightsDlt[math::index_c(0, o, SZ_IN)], this->Input, DerTrans);
+						this->BiasesDlt[o] += DerTrans;
+					}
 				}
-			}
 
-			else
-			{
-				for(auto o = uMAX(0); o < SZ_OUT; ++o)
+				else
 				{
-					const auto DerErr = this->Front->gradient()[o];
-					const auto DerTrans = std::clamp(FN_TRANS::der(OutNeeded[o]) * DerErr, T(-1), T(1));
-
-					vops::mulVecByConstAddToOut(SZ_IN, this->Gradient, &this->Weights[math::index_c(0, o, SZ_IN)], DerTrans);
+					for(auto o = _Beg; o < _End; ++o)
+					{
+						const auto DerErr = this->Front->gradient()[o];
+						const auto DerTrans = std::clamp(FN_TRANS::der(OutNeeded[o]) * DerErr, T(-1), T(1));
+						if(DerTrans != T(0)) storeAxpy<FN_STORE>(SZ_IN, Gradient, this->weightsStored(math::index_c(0, o, SZ_IN)), DerTrans);
+					}
 				}
+			});
+
+			// Reduce partial gradients.
+			for(auto c = uMAX(1); c < Chunks; ++c)
+			{
+				const auto Part = this->GradientPart.data() + (c - 1) * SZ_IN;
+				for(auto i = uMAX(0); i < SZ_IN; ++i) this->Gradient[i] += Part[i];
 			}
 			
 			SX_MC_LAYER_NEXT_FIT;
 		}
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch. Chunks own outputs and run all samples through blocks of them, so weights are loaded once per batch.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			this->ready();
+
+			const auto OutTrans = this->OutTransBatch.reserve(_Count * SZ_OUT);
+			const auto OutRaw = FN_TRANS::RAW ? this->OutRawBatch.reserve(_Count * SZ_OUT) : nullptr;
+			const auto Grain = parGrain(SZ_IN * 2 * _Count);
+			const auto WeightsWide = (FN_STORE != FnStore::FP32) ? this->WeightsWideBatch.reserve(threadPool().chunks(SZ_OUT, Grain) * BLOCK_OUT * SZ_IN) : nullptr;
+
+			threadPool().parallelFor(SZ_OUT, Grain, [&]( const uMAX _Beg, const uMAX _End, const uMAX _Chunk )
+			{
+				const auto store = [&]( const uMAX _O, const uMAX _N, const T _Raw )
+				{
+					if constexpr(FN_TRANS::RAW) OutRaw[math::index_c(_O, _N, SZ_OUT)] = storeNarrow<FN_STORE>(_Raw);
+					OutTrans[math::index_c(_O, _N, SZ_OUT)] = FN_TRANS::trans(_Raw);
+				};
+
+				for(auto b = _Beg; b < _End; b += BLOCK_OUT)
+				{
+					// Narrowed block is widened once and shared by all samples.
+					const auto Block = this->weightsAt(math::index_c(0, b, SZ_IN), (std::min(b + BLOCK_OUT, _End) - b) * SZ_IN, WeightsWide ? WeightsWide + _Chunk * BLOCK_OUT * SZ_IN : nullptr);
+
+					// Four samples share every weight load and keep independent sums.
+					auto n = uMAX(0);
+					for(; (n + 4) <= _Count; n += 4)
+					{
+						const auto In0 = this->inBatch(n);
+						const auto In1 = this->inBatch(n + 1);
+						const auto In2 = this->inBatch(n + 2);
+						const auto In3 = this->inBatch(n + 3);
+
+						for(auto o = b; o < std::min(b + BLOCK_OUT, _End); ++o)
+						{
+							const auto Row = Block + math::index_c(0, o - b, SZ_IN);
+							auto Sum0 = T(0), Sum1 = T(0), Sum2 = T(0), Sum3 = T(0);
+							for(auto i = uMAX(0); i < SZ_IN; ++i) { Sum0 += In0[i] * Row[i]; Sum1 += In1[i] * Row[i]; Sum2 += In2[i] * Row[i]; Sum3 += In3[i] * Row[i]; }
+
+							store(o, n, Sum0 + this->BiasesSrc[o]);
+							store(o, n + 1, Sum1 + this->BiasesSrc[o]);
+							store(o, n + 2, Sum2 + this->BiasesSrc[o]);
+							store(o, n + 3, Sum3 + this->BiasesSrc[o]);
+						}
+					}
+
+					for(; n < _Count; ++n)
+					{
+						const auto Input = this->inBatch(n);
+						for(auto o = b; o < std::min(b + BLOCK_OUT, _End); ++o) store(o, n, std::inner_product(Input, Input + SZ_IN, Block + math::index_c(0, o - b, SZ_IN), T(0)) + this->BiasesSrc[o]);
+					}
+				}
+			});
+
+			SX_MC_LAYER_NEXT_EXE_BATCH;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate batch. Deltas are accumulated by chunks owning outputs, gradient by chunks owning inputs,
+		// so no partial buffers are needed. Zero derivatives, common after relu, are skipped.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT_BATCH final
+		{
+			this->ready(!this->IsLocked);
+
+			const auto FrontGradient = this->Front->gradientBatch();
+			const auto Der = this->DerBatch.reserve(_Count * SZ_OUT);
+			const auto Gradient = this->GradientBatch.reserve(_Count * SZ_IN);
+
+			const auto OutTrans = this->OutTransBatch.data();
+			const auto OutRaw = this->OutRawBatch.data();
+			const auto outNeeded = [&]( const uMAX _I ) -> T { if constexpr(FN_TRANS::RAW) return storeWiden<FN_STORE,T>(OutRaw[_I]); else return OutTrans[_I]; };
+
+			threadPool().parallelFor(SZ_OUT, parGrain(SZ_IN * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto b = _Beg; b < _End; b += BLOCK_OUT) { for(auto n = uMAX(0); n < _Count; ++n)
+				{
+					const auto Input = this->inBatch(n);
+
+					for(auto o = b; o < std::min(b + BLOCK_OUT, _End); ++o)
+					{
+						const auto i = math::index_c(o, n, SZ_OUT);
+						Der[i] = std::clamp(FN_TRANS::der(outNeeded(i)) * FrontGradient[i], T(-1), T(1));
+
+						if(!this->IsLocked && (Der[i] != T(0)))
+						{
+							vops::mulVecByConstAddToOut(SZ_IN, &this->WeightsDlt[math::index_c(0, o, SZ_IN)], Input, Der[i]);
+							this->BiasesDlt[o] += Der[i];
+						}
+					}
+				}}
+			});
+
+			threadPool().parallelFor(SZ_IN, parGrain(SZ_OUT * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto n = uMAX(0); n < _Count; ++n) memZero(_End - _Beg, Gradient + math::index_c(_Beg, n, SZ_IN));
+
+				for(auto o = uMAX(0); o < SZ_OUT; ++o)
+				{
+					const auto Row = this->weightsStored(math::index_c(_Beg, o, SZ_IN));
+					for(auto n = uMAX(0); n < _Count; ++n) if(Der[math::index_c(o, n, SZ_OUT)] != T(0)) storeAxpy<FN_STORE>(_End - _Beg, Gradient + math::index_c(_Beg, n, SZ_IN), Row, Der[math::index_c(o, n, SZ_OUT)]);
+				}
+			});
+
+			SX_MC_LAYER_NEXT_FIT_BATCH;
+		}
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Get output error in respect to argument.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -136,5 +325,41 @@ namespace sx
 		// Multi threading utility.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		#include "./data/ComImplExchange.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Move parameters or deltas through flat buffers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplGather.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Norms of parameters and deltas.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplNorms.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::DENSE, SZ_IN, SZ_OUT, SZ_BUF_W, SZ_BUF_B}; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			if(_Op == LayerOp::EXE) return LayerCost{2 * SZ_BUF_W + SZ_OUT, SZ_BUF_W * SZ_STORE + (SZ_IN + SZ_BUF_B + SZ_OUT) * sizeof(T)};
+			if(_Op == LayerOp::FIT) return LayerCost{4 * SZ_BUF_W + SZ_OUT * 2, SZ_BUF_W * SZ_STORE + (2 * SZ_BUF_W + 2 * SZ_IN + 2 * SZ_OUT) * sizeof(T)};
+			if(_Op == LayerOp::APPLY) return applyCost<T,FN_OPTIM>(SZ_BUF_W + SZ_BUF_B);
+			return LayerCost{0, 0};
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute with external read only parameters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplBind.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Zero smallest weights and keep them zero while training.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplPrune.hpp"
 	};
 }
@@ -0,0 +1,208 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Codebook dense layer for inference. Weights share codebook of 2^BITS values fitted by k-means, layer keeps only BITS index
+	// per weight and decodes it while summing, so resident and stored model are compressed alike. Parameters come from float Dense through compress().
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template
+	<
+		class T,
+		uMAX SZ_IN,
+		uMAX SZ_OUT,
+		class FN_TRANS,
+		uMAX BITS = 4
+	>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class DenseCodebook :
+		public Layer<T>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Compile time constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static_assert((BITS == 4) || (BITS == 8), "Codebook indices are 4 or 8 bits!");
+		constexpr static auto SZ_BOOK = uMAX(1) << BITS;
+		constexpr static auto SZ_ROW = codebookBytes<BITS>(SZ_IN); // Packed row with zero padding.
+		constexpr static auto SZ_BUF_W = SZ_OUT * SZ_ROW;
+		constexpr static auto GRAIN_OUT = parGrain(SZ_IN * 2); // Outputs per chunk.
+		constexpr static auto BLOCK_OUT = std::max(uMAX(1), uMAX(1 << 16) / (SZ_IN * sizeof(T))); // Outputs whose decoded weights stay in cache while batch passes them.
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		alignas(ALIGNMENT) u8 Indices[SZ_BUF_W];
+		alignas(ALIGNMENT) T Codebook[SZ_BOOK];
+		alignas(ALIGNMENT) T Biases[SZ_OUT];
+		alignas(ALIGNMENT) T OutTrans[SZ_OUT];
+		BatchBuf<T> WeightsWideBatch; // Blocks of weights decoded by chunks of batch.
+		BatchBuf<T> OutTransBatch;
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Generated functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_MC_LAYER_TRIVIAL(DenseCodebook, SZ_OUT, this->OutTrans, nullptr)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->OutTransBatch.data(), nullptr)
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		DenseCodebook ( void ) : Indices{}, Codebook{}, Biases{}, OutTrans{}, WeightsWideBatch(), OutTransBatch() { this->IsLocked = true; }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE final
+		{
+			threadPool().parallelFor(SZ_OUT, GRAIN_OUT, [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto o = _Beg; o < _End; ++o) this->OutTrans[o] = FN_TRANS::trans(codebookDot<BITS>(SZ_IN, this->Input, this->Indices + o * SZ_ROW, this->Codebook) + this->Biases[o]);
+			});
+
+			SX_MC_LAYER_NEXT_EXE;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch. Chunks own outputs, decode blocks of them once and run four samples per weight load like Dense.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			const auto OutTrans = this->OutTransBatch.reserve(_Count * SZ_OUT);
+			const auto Grain = parGrain(SZ_IN * 2 * _Count);
+			const auto WeightsWide = this->WeightsWideBatch.reserve(threadPool().chunks(SZ_OUT, Grain) * BLOCK_OUT * SZ_IN);
+
+			threadPool().parallelFor(SZ_OUT, Grain, [&]( const uMAX _Beg, const uMAX _End, const uMAX _Chunk )
+			{
+				const auto store = [&]( const uMAX _O, const uMAX _N, const T _Sum ) { OutTrans[math::index_c(_O, _N, SZ_OUT)] = FN_TRANS::trans(_Sum + this->Biases[_O]); };
+				const auto Block = WeightsWide + _Chunk * BLOCK_OUT * SZ_IN;
+
+				for(auto b = _Beg; b < _End; b += BLOCK_OUT)
+				{
+					const auto BlockEnd = std::min(b + BLOCK_OUT, _End);
+					for(auto o = b; o < BlockEnd; ++o) codebookDecode<BITS>(SZ_IN, this->Indices + o * SZ_ROW, this->Codebook, Block + math::index_c(0, o - b, SZ_IN));
+
+					auto n = uMAX(0);
+					for(; (n + 4) <= _Count; n += 4)
+					{
+						const auto In0 = this->inBatch(n);
+						const auto In1 = this->inBatch(n + 1);
+						const auto In2 = this->inBatch(n + 2);
+						const auto In3 = this->inBatch(n + 3);
+
+						for(auto o = b; o < BlockEnd; ++o)
+						{
+							const auto Row = Block + math::index_c(0, o - b, SZ_IN);
+							auto Sum0 = T(0), Sum1 = T(0), Sum2 = T(0), Sum3 = T(0);
+							for(auto i = uMAX(0); i < SZ_IN; ++i) { Sum0 += In0[i] * Row[i]; Sum1 += In1[i] * Row[i]; Sum2 += In2[i] * Row[i]; Sum3 += In3[i] * Row[i]; }
+
+							store(o, n, Sum0);
+							store(o, n + 1, Sum1);
+							store(o, n + 2, Sum2);
+							store(o, n + 3, Sum3);
+						}
+					}
+
+					for(; n < _Count; ++n)
+					{
+						const auto Input = this->inBatch(n);
+						for(auto o = b; o < BlockEnd; ++o) store(o, n, std::inner_product(Input, Input + SZ_IN, Block + math::index_c(0, o - b, SZ_IN), T(0)));
+					}
+				}
+			});
+
+			SX_MC_LAYER_NEXT_EXE_BATCH;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Codebook layers are not trained.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT final { throw fx::Error("sx"s, "DenseCodebook<T>"s, "fit"s, 0, "Codebook layer can not be trained!"s); }
+		SX_FNSIG_LAYER_FIT_BATCH final { throw fx::Error("sx"s, "DenseCodebook<T>"s, "fitBatch"s, 0, "Codebook layer can not be trained!"s); }
+		SX_FNSIG_LAYER_EXCHANGE final { throw fx::Error("sx"s, "DenseCodebook<T>"s, "exchange"s, 0, "Codebook layer can not be trained!"s); }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Take parameters of float Dense. One codebook is fitted to all weights of layer, biases are copied.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COMPRESS final
+		{
+			if(!_Source || !(_Source->desc() == LayerDesc{LayerType::DENSE, SZ_IN, SZ_OUT, SZ_IN * SZ_OUT, SZ_OUT})) return false;
+
+			auto Params = vec<T>(SZ_IN * SZ_OUT + SZ_OUT);
+			_Source->gather(Params.data(), LayerBuf::PARAMS, false);
+
+			auto Idx = vec<u8>(SZ_IN * SZ_OUT);
+			codebookFit(SZ_IN * SZ_OUT, Params.data(), SZ_BOOK, this->Codebook, Idx.data());
+
+			for(auto o = uMAX(0); o < SZ_OUT; ++o)
+			{
+				codebookPack<BITS>(SZ_IN, Idx.data() + o * SZ_IN, this->Indices + o * SZ_ROW);
+				this->Biases[o] = Params[SZ_IN * SZ_OUT + o];
+			}
+
+			return true;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Store parameters to stream.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_STORE final
+		{
+			_Stream.write(reinterpret_cast<const char*>(this->Codebook), SZ_BOOK * sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Biases), SZ_OUT * sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Indices), SZ_BUF_W);
+
+			SX_MC_LAYER_NEXT_STORE;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Load parameters from stream.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_LOAD final
+		{
+			_Stream.read(reinterpret_cast<char*>(this->Codebook), SZ_BOOK * sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(this->Biases), SZ_OUT * sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(this->Indices), SZ_BUF_W);
+
+			SX_MC_LAYER_NEXT_LOAD;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes. Indices are not Ts, so no parameters are reported.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::DENSE_CODEBOOK, SZ_IN, SZ_OUT, 0, 0}; }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			if(_Op == LayerOp::EXE) return LayerCost{2 * SZ_IN * SZ_OUT + SZ_OUT, SZ_BUF_W + (SZ_BOOK + SZ_IN + 2 * SZ_OUT) * sizeof(T)};
+			return LayerCost{0, 0};
+		}
+	};
+}
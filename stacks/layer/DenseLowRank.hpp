@@ -0,0 +1,365 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Low rank dense layer. Weights are factored as U * V with U of SZ_OUT x RANK and V of RANK x SZ_IN, so execution and
+	// backpropagation are two thin products through RANK values and work and size scale with RANK * (SZ_IN + SZ_OUT).
+	// Trains directly, or takes factors of trained Dense through compress() and is fine tuned afterwards.
+	// Both factors share one weights buffer, V first and U after it.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template
+	<
+		class T,
+		uMAX SZ_IN,
+		uMAX SZ_OUT,
+		uMAX RANK,
+		class FN_TRANS,
+		FnOptim FN_OPTIM = FnOptim::ADAM
+	>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class DenseLowRank :
+		public Layer<T>,
+		LDOutputs<T, SZ_OUT, SZ_IN, FnTrans::RELU>,
+		LDWeights<T, FN_OPTIM, RANK*(SZ_IN + SZ_OUT), SZ_IN, RANK, FnInitWeights::NRM_RELU_FACTORS>,
+		LDBiases<T, SZ_OUT, SZ_IN, SZ_OUT, FN_OPTIM>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Compile time constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		constexpr static auto SZ_BUF_W = RANK * (SZ_IN + SZ_OUT);
+		constexpr static auto SZ_BUF_B = SZ_OUT;
+		constexpr static auto OFF_U = RANK * SZ_IN; // Offset of U in weights.
+		constexpr static auto GRAIN_MID = parGrain(SZ_IN * 2); // Rows of V per chunk.
+		constexpr static auto GRAIN_OUT = parGrain(RANK * 2); // Rows of U per chunk.
+		static_assert(RANK > 0, "Rank must be positive!");
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		alignas(ALIGNMENT) T Mid[RANK]; // V * input of last execution.
+		alignas(ALIGNMENT) T MidGrad[RANK]; // Error gradient in respect to Mid.
+		vec<T> MidGradPart; // Private Mid gradient accumulators of parallel chunks.
+		BatchBuf<T> MidBatch;
+		BatchBuf<T> MidGradBatch;
+		BatchBuf<T> OutTransBatch;
+		BatchBuf<T> OutRawBatch;
+		BatchBuf<T> DerBatch; // Transfer derivatives of batch.
+		BatchBuf<T> GradientBatch;
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Rows of factors.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto rowV ( const uMAX _R ) const -> const T* { return this->WeightsSrc + math::index_c(0, _R, SZ_IN); }
+		inline auto rowU ( const uMAX _O ) const -> const T* { return this->WeightsSrc + OFF_U + math::index_c(0, _O, RANK); }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Generated functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_MC_LAYER_TRIVIAL(DenseLowRank, SZ_OUT, this->OutTrans, this->Gradient)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->OutTransBatch.data(), this->GradientBatch.data())
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor. V keeps relu initialisation over input, U is drawn over RANK so product keeps variance of plain Dense.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		DenseLowRank ( void ) : Mid{}, MidGrad{} {}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute. Input is projected to RANK values, which are expanded to outputs.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE final
+		{
+			this->ready();
+
+			threadPool().parallelFor(RANK, GRAIN_MID, [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto r = _Beg; r < _End; ++r) this->Mid[r] = std::inner_product(this->Input, this->Input + SZ_IN, this->rowV(r), T(0));
+			});
+
+			threadPool().parallelFor(SZ_OUT, GRAIN_OUT, [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto o = _Beg; o < _End; ++o)
+				{
+					const auto Raw = std::inner_product(this->Mid, this->Mid + RANK, this->rowU(o), T(0)) + this->BiasesSrc[o];
+					if constexpr(FN_TRANS::RAW) this->OutRaw[o] = Raw;
+					this->OutTrans[o] = FN_TRANS::trans(Raw);
+				}
+			});
+
+			SX_MC_LAYER_NEXT_EXE;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate. Chunks owning outputs accumulate Mid gradient privately, it is reduced and then drives deltas of V
+		// and gradient of input.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT final
+		{
+			this->ready(!this->IsLocked);
+
+			const auto Chunks = threadPool().chunks(SZ_OUT, GRAIN_OUT);
+			if(this->MidGradPart.size() < (Chunks - 1) * RANK) this->MidGradPart.resize((Chunks - 1) * RANK);
+
+			auto OutNeeded = this->OutTrans;
+			if constexpr(FN_TRANS::RAW) OutNeeded = this->OutRaw;
+
+			threadPool().parallelFor(SZ_OUT, GRAIN_OUT, [&]( const uMAX _Beg, const uMAX _End, const uMAX _Chunk )
+			{
+				auto MidGrad = (_Chunk == 0) ? this->MidGrad : (this->MidGradPart.data() + (_Chunk - 1) * RANK);
+				memZero(RANK, MidGrad);
+
+				for(auto o = _Beg; o < _End; ++o)
+				{
+					const auto DerErr = this->Front->gradient()[o];
+					const auto DerTrans = std::clamp(FN_TRANS::der(OutNeeded[o]) * DerErr, T(-1), T(1));
+					if(DerTrans == T(0)) continue;
+
+					vops::mulVecByConstAddToOut(RANK, MidGrad, this->rowU(o), DerTrans);
+
+					if(!this->IsLocked)
+					{
+						vops::mulVecByConstAddToOut(RANK, &this->WeightsDlt[OFF_U + math::index_c(0, o, RANK)], this->Mid, DerTrans);
+						this->BiasesDlt[o] += DerTrans;
+					}
+				}
+			});
+
+			// Reduce partial Mid gradients.
+			for(auto c = uMAX(1); c < Chunks; ++c)
+			{
+				const auto Part = this->MidGradPart.data() + (c - 1) * RANK;
+				for(auto r = uMAX(0); r < RANK; ++r) this->MidGrad[r] += Part[r];
+			}
+
+			if(!this->IsLocked)
+			{
+				threadPool().parallelFor(RANK, GRAIN_MID, [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+				{
+					for(auto r = _Beg; r < _End; ++r) if(this->MidGrad[r] != T(0)) vops::mulVecByConstAddToOut(SZ_IN, &this->WeightsDlt[math::index_c(0, r, SZ_IN)], this->Input, this->MidGrad[r]);
+				});
+			}
+
+			threadPool().parallelFor(SZ_IN, parGrain(RANK * 2), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				memZero(_End - _Beg, this->Gradient + _Beg);
+				for(auto r = uMAX(0); r < RANK; ++r) if(this->MidGrad[r] != T(0)) vops::mulVecByConstAddToOut(_End - _Beg, this->Gradient + _Beg, this->rowV(r) + _Beg, this->MidGrad[r]);
+			});
+
+			SX_MC_LAYER_NEXT_FIT;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch. Chunks own rows of factors and run all samples through them, so every factor is loaded once per batch.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			this->ready();
+
+			const auto Mid = this->MidBatch.reserve(_Count * RANK);
+			const auto OutTrans = this->OutTransBatch.reserve(_Count * SZ_OUT);
+			const auto OutRaw = FN_TRANS::RAW ? this->OutRawBatch.reserve(_Count * SZ_OUT) : nullptr;
+
+			threadPool().parallelFor(RANK, parGrain(SZ_IN * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto r = _Beg; r < _End; ++r) for(auto n = uMAX(0); n < _Count; ++n)
+				{
+					const auto Input = this->inBatch(n);
+					Mid[math::index_c(r, n, RANK)] = std::inner_product(Input, Input + SZ_IN, this->rowV(r), T(0));
+				}
+			});
+
+			threadPool().parallelFor(SZ_OUT, parGrain(RANK * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto o = _Beg; o < _End; ++o) for(auto n = uMAX(0); n < _Count; ++n)
+				{
+					const auto i = math::index_c(o, n, SZ_OUT);
+					const auto Raw = std::inner_product(Mid + math::index_c(0, n, RANK), Mid + math::index_c(0, n + 1, RANK), this->rowU(o), T(0)) + this->BiasesSrc[o];
+					if constexpr(FN_TRANS::RAW) OutRaw[i] = Raw;
+					OutTrans[i] = FN_TRANS::trans(Raw);
+				}
+			});
+
+			SX_MC_LAYER_NEXT_EXE_BATCH;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate batch. Every pass is owned by chunks of its output rows, so no partial buffers are needed.
+		// Zero derivatives, common after relu, are skipped.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT_BATCH final
+		{
+			this->ready(!this->IsLocked);
+
+			const auto FrontGradient = this->Front->gradientBatch();
+			const auto Mid = this->MidBatch.data();
+			const auto Der = this->DerBatch.reserve(_Count * SZ_OUT);
+			const auto MidGrad = this->MidGradBatch.reserve(_Count * RANK);
+			const auto Gradient = this->GradientBatch.reserve(_Count * SZ_IN);
+			const auto OutNeeded = FN_TRANS::RAW ? this->OutRawBatch.data() : this->OutTransBatch.data();
+
+			// Derivatives, deltas of U and biases.
+			threadPool().parallelFor(SZ_OUT, parGrain(RANK * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto o = _Beg; o < _End; ++o) for(auto n = uMAX(0); n < _Count; ++n)
+				{
+					const auto i = math::index_c(o, n, SZ_OUT);
+					Der[i] = std::clamp(FN_TRANS::der(OutNeeded[i]) * FrontGradient[i], T(-1), T(1));
+
+					if(!this->IsLocked && (Der[i] != T(0)))
+					{
+						vops::mulVecByConstAddToOut(RANK, &this->WeightsDlt[OFF_U + math::index_c(0, o, RANK)], Mid + math::index_c(0, n, RANK), Der[i]);
+						this->BiasesDlt[o] += Der[i];
+					}
+				}
+			});
+
+			// Mid gradients of samples.
+			threadPool().parallelFor(_Count, parGrain(SZ_OUT * RANK * 2), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto n = _Beg; n < _End; ++n)
+				{
+					memZero(RANK, MidGrad + math::index_c(0, n, RANK));
+					for(auto o = uMAX(0); o < SZ_OUT; ++o) if(Der[math::index_c(o, n, SZ_OUT)] != T(0)) vops::mulVecByConstAddToOut(RANK, MidGrad + math::index_c(0, n, RANK), this->rowU(o), Der[math::index_c(o, n, SZ_OUT)]);
+				}
+			});
+
+			// Deltas of V.
+			if(!this->IsLocked)
+			{
+				threadPool().parallelFor(RANK, parGrain(SZ_IN * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+				{
+					for(auto r = _Beg; r < _End; ++r) for(auto n = uMAX(0); n < _Count; ++n)
+					{
+						const auto G = MidGrad[math::index_c(r, n, RANK)];
+						if(G != T(0)) vops::mulVecByConstAddToOut(SZ_IN, &this->WeightsDlt[math::index_c(0, r, SZ_IN)], this->inBatch(n), G);
+					}
+				});
+			}
+
+			// Gradient of inputs.
+			threadPool().parallelFor(SZ_IN, parGrain(RANK * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto n = uMAX(0); n < _Count; ++n) memZero(_End - _Beg, Gradient + math::index_c(_Beg, n, SZ_IN));
+
+				for(auto r = uMAX(0); r < RANK; ++r)
+				{
+					const auto Row = this->rowV(r) + _Beg;
+					for(auto n = uMAX(0); n < _Count; ++n) if(MidGrad[math::index_c(r, n, RANK)] != T(0)) vops::mulVecByConstAddToOut(_End - _Beg, Gradient + math::index_c(_Beg, n, SZ_IN), Row, MidGrad[math::index_c(r, n, RANK)]);
+				}
+			});
+
+			SX_MC_LAYER_NEXT_FIT_BATCH;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Get output error in respect to argument.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplErr.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Reset delta parameters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplReset.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Apply optimizations and update parameters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplApply.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Store parameters to stream.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplStore.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Load parameters from stream.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplLoad.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Multi threading utility.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplExchange.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Move parameters or deltas through flat buffers.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplGather.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Norms of parameters and deltas.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplNorms.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute with external read only parameters.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		#include "./data/ComImplBind.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Factor weights of float Dense by truncated SVD. Singular values are split evenly, U = Us * sqrt(S) and V = sqrt(S) * Vt,
+		// so both factors have same scale for training that follows. Biases are copied.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COMPRESS final
+		{
+			if(!_Source || !(_Source->desc() == LayerDesc{LayerType::DENSE, SZ_IN, SZ_OUT, SZ_IN * SZ_OUT, SZ_OUT})) return false;
+			this->detach();
+
+			auto Params = vec<T>(SZ_IN * SZ_OUT + SZ_OUT);
+			_Source->gather(Params.data(), LayerBuf::PARAMS, false);
+
+			auto Us = vec<T>(SZ_OUT * RANK);
+			auto S = vec<T>(RANK);
+			auto Vt = vec<T>(RANK * SZ_IN);
+			svdTruncated(SZ_OUT, SZ_IN, Params.data(), RANK, Us.data(), S.data(), Vt.data());
+
+			for(auto r = uMAX(0); r < RANK; ++r)
+			{
+				const auto Root = std::sqrt(S[r]);
+				for(auto i = uMAX(0); i < SZ_IN; ++i) this->Weights[math::index_c(i, r, SZ_IN)] = Vt[math::index_c(i, r, SZ_IN)] * Root;
+				for(auto o = uMAX(0); o < SZ_OUT; ++o) this->Weights[OFF_U + math::index_c(r, o, RANK)] = Us[math::index_c(r, o, RANK)] * Root;
+			}
+
+			memCopy(SZ_OUT, this->Biases, Params.data() + SZ_IN * SZ_OUT);
+			return true;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::DENSE_LOW_RANK, SZ_IN, SZ_OUT, SZ_BUF_W, SZ_BUF_B}; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			if(_Op == LayerOp::EXE) return LayerCost{2 * SZ_BUF_W + SZ_OUT, (SZ_BUF_W + SZ_IN + RANK + SZ_BUF_B + SZ_OUT) * sizeof(T)};
+			if(_Op == LayerOp::FIT) return LayerCost{6 * SZ_BUF_W + SZ_OUT * 2, (3 * SZ_BUF_W + 2 * SZ_IN + 2 * RANK + 2 * SZ_OUT) * sizeof(T)};
+			if(_Op == LayerOp::APPLY) return applyCost<T,FN_OPTIM>(SZ_BUF_W + SZ_BUF_B);
+			return LayerCost{0, 0};
+		}
+	};
+}
@@ -0,0 +1,209 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Quantized dense layer for inference. Weights are int8 with scale per output, input is quantized with scale found by calibration.
+	// Int32 sums are dequantized, biased and transferred in one pass. Parameters come from float Dense through quantize().
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template
+	<
+		class T,
+		uMAX SZ_IN,
+		uMAX SZ_OUT,
+		class FN_TRANS
+	>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class DenseQ8 :
+		public Layer<T>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Compile time constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		constexpr static auto SZ_ROW = quantPad(SZ_IN); // Int8 row with zero padding.
+		constexpr static auto SZ_BUF_W = SZ_OUT * SZ_ROW;
+		constexpr static auto GRAIN_OUT = parGrain(SZ_IN * 2); // Outputs per chunk.
+		constexpr static auto BLOCK_OUT = std::max(uMAX(1), uMAX(1 << 16) / SZ_ROW); // Outputs whose weights stay in cache while batch passes them.
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		alignas(ALIGNMENT) i8 Weights[SZ_BUF_W];
+		alignas(ALIGNMENT) T Scales[SZ_OUT]; // Input scale times weight scale of output.
+		alignas(ALIGNMENT) T Biases[SZ_OUT];
+		alignas(ALIGNMENT) T OutTrans[SZ_OUT];
+		alignas(ALIGNMENT) i8 InputQ[SZ_ROW];
+		T InScale;
+		BatchBuf<i8> InputQBatch;
+		BatchBuf<T> OutTransBatch;
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Generated functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_MC_LAYER_TRIVIAL(DenseQ8, SZ_OUT, this->OutTrans, nullptr)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->OutTransBatch.data(), nullptr)
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		DenseQ8 ( void ) : Weights{}, Scales{}, Biases{}, OutTrans{}, InputQ{}, InScale(1), InputQBatch(), OutTransBatch() { this->IsLocked = true; }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE final
+		{
+			quantizeS8(SZ_IN, this->Input, this->InputQ, this->InScale);
+
+			threadPool().parallelFor(SZ_OUT, GRAIN_OUT, [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto o = _Beg; o < _End; ++o) this->OutTrans[o] = FN_TRANS::trans(T(dotS8(SZ_ROW, this->Weights + o * SZ_ROW, this->InputQ)) * this->Scales[o] + this->Biases[o]);
+			});
+
+			SX_MC_LAYER_NEXT_EXE;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch. Samples are quantized first, then chunks own outputs and run four samples per weight load like Dense.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			const auto InputQ = this->InputQBatch.reserve(_Count * SZ_ROW);
+			const auto OutTrans = this->OutTransBatch.reserve(_Count * SZ_OUT);
+
+			threadPool().parallelFor(_Count, parGrain(SZ_IN * 4), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto n = _Beg; n < _End; ++n)
+				{
+					memZero(SZ_ROW - SZ_IN, InputQ + n * SZ_ROW + SZ_IN);
+					quantizeS8(SZ_IN, this->inBatch(n), InputQ + n * SZ_ROW, this->InScale);
+				}
+			});
+
+			threadPool().parallelFor(SZ_OUT, parGrain(SZ_IN * 2 * _Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				const auto store = [&]( const uMAX _O, const uMAX _N, const i32 _Sum ) { OutTrans[math::index_c(_O, _N, SZ_OUT)] = FN_TRANS::trans(T(_Sum) * this->Scales[_O] + this->Biases[_O]); };
+
+				for(auto b = _Beg; b < _End; b += BLOCK_OUT)
+				{
+					auto n = uMAX(0);
+					for(; (n + 4) <= _Count; n += 4)
+					{
+						const auto In = InputQ + n * SZ_ROW;
+
+						for(auto o = b; o < std::min(b + BLOCK_OUT, _End); ++o)
+						{
+							i32 Sums[4];
+							dotS8x4(SZ_ROW, this->Weights + o * SZ_ROW, In, In + SZ_ROW, In + 2 * SZ_ROW, In + 3 * SZ_ROW, Sums);
+							for(auto s = uMAX(0); s < 4; ++s) store(o, n + s, Sums[s]);
+						}
+					}
+
+					for(; n < _Count; ++n)
+					{
+						for(auto o = b; o < std::min(b + BLOCK_OUT, _End); ++o) store(o, n, dotS8(SZ_ROW, this->Weights + o * SZ_ROW, InputQ + n * SZ_ROW));
+					}
+				}
+			});
+
+			SX_MC_LAYER_NEXT_EXE_BATCH;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Quantized layers are not trained.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT final { throw fx::Error("sx"s, "DenseQ8<T>"s, "fit"s, 0, "Quantized layer can not be trained!"s); }
+		SX_FNSIG_LAYER_FIT_BATCH final { throw fx::Error("sx"s, "DenseQ8<T>"s, "fitBatch"s, 0, "Quantized layer can not be trained!"s); }
+		SX_FNSIG_LAYER_EXCHANGE final { throw fx::Error("sx"s, "DenseQ8<T>"s, "exchange"s, 0, "Quantized layer can not be trained!"s); }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Take parameters of float Dense. Every output gets own weight scale.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_QUANTIZE final
+		{
+			if(!_Source || !(_Source->desc() == LayerDesc{LayerType::DENSE, SZ_IN, SZ_OUT, SZ_IN * SZ_OUT, SZ_OUT})) return false;
+
+			auto Params = vec<T>(SZ_IN * SZ_OUT + SZ_OUT);
+			_Source->gather(Params.data(), LayerBuf::PARAMS, false);
+
+			this->InScale = quantScale(T(_Range));
+			memZero(SZ_BUF_W, this->Weights);
+
+			for(auto o = uMAX(0); o < SZ_OUT; ++o)
+			{
+				const auto Row = Params.data() + o * SZ_IN;
+				const auto Scale = quantScale(quantMaxAbs(SZ_IN, Row));
+				quantizeS8(SZ_IN, Row, this->Weights + o * SZ_ROW, Scale);
+				this->Scales[o] = this->InScale * Scale;
+				this->Biases[o] = Params[SZ_IN * SZ_OUT + o];
+			}
+
+			return true;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Store parameters to stream.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_STORE final
+		{
+			_Stream.write(reinterpret_cast<const char*>(&this->InScale), sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Scales), SZ_OUT * sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Biases), SZ_OUT * sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Weights), SZ_BUF_W);
+
+			SX_MC_LAYER_NEXT_STORE;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Load parameters from stream.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_LOAD final
+		{
+			_Stream.read(reinterpret_cast<char*>(&this->InScale), sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(this->Scales), SZ_OUT * sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(this->Biases), SZ_OUT * sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(this->Weights), SZ_BUF_W);
+
+			SX_MC_LAYER_NEXT_LOAD;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes. Int8 parameters are not Ts, so none are reported.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::DENSE_Q8, SZ_IN, SZ_OUT, 0, 0}; }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			if(_Op == LayerOp::EXE) return LayerCost{2 * SZ_IN * SZ_OUT + 3 * SZ_OUT, SZ_BUF_W + SZ_ROW + (SZ_IN + 3 * SZ_OUT) * sizeof(T)};
+			return LayerCost{0, 0};
+		}
+	};
+}
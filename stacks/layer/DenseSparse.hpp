@@ -0,0 +1,229 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Sparse dense layer for inference. Non zero weights of pruned Dense are kept in compressed rows, work and size follow their count.
+	// Parameters come from float Dense through compress().
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template
+	<
+		class T,
+		uMAX SZ_IN,
+		uMAX SZ_OUT,
+		class FN_TRANS
+	>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class DenseSparse :
+		public Layer<T>
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Compile time constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		using Col = std::conditional_t<(SZ_IN <= (uMAX(1) << 16)), u16, u32>; // Column position, narrow when input allows it.
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		alignas(ALIGNMENT) u32 Rows[SZ_OUT + 1]; // Start of every row in Cols and Vals.
+		alignas(ALIGNMENT) T Biases[SZ_OUT];
+		alignas(ALIGNMENT) T OutTrans[SZ_OUT];
+		vec<Col> Cols;
+		vec<T> Vals;
+		BatchBuf<T> InputTBatch; // Batch transposed to [SZ_IN][N], so every weight scales contiguous run of samples.
+		BatchBuf<T> AccBatch;
+		BatchBuf<T> OutTransBatch;
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Grain of rows for work of _PerWeight per non zero weight.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inline auto grain ( const uMAX _PerWeight ) const -> uMAX { return parGrain(_PerWeight * (this->Vals.size() / SZ_OUT + 1)); }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Generated functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_MC_LAYER_TRIVIAL(DenseSparse, SZ_OUT, this->OutTrans, nullptr)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->OutTransBatch.data(), nullptr)
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constructor.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		DenseSparse ( void ) : Rows{}, Biases{}, OutTrans{}, Cols(), Vals(), InputTBatch(), AccBatch(), OutTransBatch() { this->IsLocked = true; }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute. Row dots gather input at column positions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE final
+		{
+			threadPool().parallelFor(SZ_OUT, this->grain(2), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto o = _Beg; o < _End; ++o)
+				{
+					const auto Beg = this->Rows[o];
+					this->OutTrans[o] = FN_TRANS::trans(sparseDot<FnStore::FP32>(this->Rows[o + 1] - Beg, this->Cols.data() + Beg, this->Vals.data() + Beg, this->Input) + this->Biases[o]);
+				}
+			});
+
+			SX_MC_LAYER_NEXT_EXE;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch. Inputs are transposed once, then every non zero weight adds its column of samples to row accumulator.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			const auto InputT = this->InputTBatch.reserve(SZ_IN * _Count);
+			const auto OutTrans = this->OutTransBatch.reserve(_Count * SZ_OUT);
+			const auto Grain = this->grain(2 * _Count);
+			const auto Acc = this->AccBatch.reserve(threadPool().chunks(SZ_OUT, Grain) * _Count);
+
+			threadPool().parallelFor(SZ_IN, parGrain(_Count), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto n = uMAX(0); n < _Count; ++n)
+				{
+					const auto Input = this->inBatch(n);
+					for(auto i = _Beg; i < _End; ++i) InputT[math::index_c(n, i, _Count)] = Input[i];
+				}
+			});
+
+			threadPool().parallelFor(SZ_OUT, Grain, [&]( const uMAX _Beg, const uMAX _End, const uMAX _Chunk )
+			{
+				const auto Sums = Acc + _Chunk * _Count;
+
+				for(auto o = _Beg; o < _End; ++o)
+				{
+					memZero(_Count, Sums);
+					for(auto j = this->Rows[o]; j < this->Rows[o + 1]; ++j) vops::mulVecByConstAddToOut(_Count, Sums, InputT + math::index_c(0, this->Cols[j], _Count), this->Vals[j]);
+					for(auto n = uMAX(0); n < _Count; ++n) OutTrans[math::index_c(o, n, SZ_OUT)] = FN_TRANS::trans(Sums[n] + this->Biases[o]);
+				}
+			});
+
+			SX_MC_LAYER_NEXT_EXE_BATCH;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Sparse layers are not trained, pruning continues on float Dense.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT final { throw fx::Error("sx"s, "DenseSparse<T>"s, "fit"s, 0, "Sparse layer can not be trained!"s); }
+		SX_FNSIG_LAYER_FIT_BATCH final { throw fx::Error("sx"s, "DenseSparse<T>"s, "fitBatch"s, 0, "Sparse layer can not be trained!"s); }
+		SX_FNSIG_LAYER_EXCHANGE final { throw fx::Error("sx"s, "DenseSparse<T>"s, "exchange"s, 0, "Sparse layer can not be trained!"s); }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Take non zero parameters of float Dense.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COMPRESS final
+		{
+			if(!_Source || !(_Source->desc() == LayerDesc{LayerType::DENSE, SZ_IN, SZ_OUT, SZ_IN * SZ_OUT, SZ_OUT})) return false;
+
+			auto Params = vec<T>(SZ_IN * SZ_OUT + SZ_OUT);
+			_Source->gather(Params.data(), LayerBuf::PARAMS, false);
+
+			this->Cols.clear();
+			this->Vals.clear();
+
+			for(auto o = uMAX(0); o < SZ_OUT; ++o)
+			{
+				this->Rows[o] = u32(this->Vals.size());
+				for(auto i = uMAX(0); i < SZ_IN; ++i) if(const auto W = Params[math::index_c(i, o, SZ_IN)]; W != T(0)) { this->Cols.push_back(Col(i)); this->Vals.push_back(W); }
+				this->Biases[o] = Params[SZ_IN * SZ_OUT + o];
+			}
+
+			this->Rows[SZ_OUT] = u32(this->Vals.size());
+			return true;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Store parameters to stream. Count of non zero weights leads, compressed rows and biases follow.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_STORE final
+		{
+			const auto Count = u64(this->Vals.size());
+			_Stream.write(reinterpret_cast<const char*>(&Count), sizeof(u64));
+			_Stream.write(reinterpret_cast<const char*>(this->Rows), (SZ_OUT + 1) * sizeof(u32));
+			_Stream.write(reinterpret_cast<const char*>(this->Cols.data()), Count * sizeof(Col));
+			_Stream.write(reinterpret_cast<const char*>(this->Vals.data()), Count * sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Biases), SZ_OUT * sizeof(T));
+
+			SX_MC_LAYER_NEXT_STORE;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Load parameters from stream. Rows must rise from zero to count of weights and columns must be inputs,
+		// since execution trusts both. Layer keeps its parameters unless stream is valid.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_LOAD final
+		{
+			auto Count = u64(0);
+			_Stream.read(reinterpret_cast<char*>(&Count), sizeof(u64));
+			if(Count > SZ_IN * SZ_OUT) throw fx::Error("sx"s, "DenseSparse<T>"s, "load"s, 0, "Invalid count of weights!"s);
+
+			auto Rows = vec<u32>(SZ_OUT + 1);
+			auto Cols = vec<Col>(Count);
+			auto Vals = vec<T>(Count);
+			auto Biases = vec<T>(SZ_OUT);
+			_Stream.read(reinterpret_cast<char*>(Rows.data()), (SZ_OUT + 1) * sizeof(u32));
+			_Stream.read(reinterpret_cast<char*>(Cols.data()), Count * sizeof(Col));
+			_Stream.read(reinterpret_cast<char*>(Vals.data()), Count * sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(Biases.data()), SZ_OUT * sizeof(T));
+			if(!_Stream) throw fx::Error("sx"s, "DenseSparse<T>"s, "load"s, 0, "Truncated stream!"s);
+
+			if((Rows[0] != 0) || (Rows[SZ_OUT] != Count)) throw fx::Error("sx"s, "DenseSparse<T>"s, "load"s, 0, "Invalid rows!"s);
+			for(auto o = uMAX(0); o < SZ_OUT; ++o) if(Rows[o + 1] < Rows[o]) throw fx::Error("sx"s, "DenseSparse<T>"s, "load"s, 0, "Invalid rows!"s);
+			for(const auto C : Cols) if(C >= SZ_IN) throw fx::Error("sx"s, "DenseSparse<T>"s, "load"s, 0, "Invalid column!"s);
+
+			std::copy(Rows.begin(), Rows.end(), this->Rows);
+			std::copy(Biases.begin(), Biases.end(), this->Biases);
+			this->Cols = std::move(Cols);
+			this->Vals = std::move(Vals);
+
+			SX_MC_LAYER_NEXT_LOAD;
+		}
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Count of non zero weights.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto nonZeros ( void ) const -> uMAX { return this->Vals.size(); }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes. Parameter count is known only at run time, so none are reported.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::DENSE_SPARSE, SZ_IN, SZ_OUT, 0, 0}; }
+
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			const auto Count = this->Vals.size();
+			if(_Op == LayerOp::EXE) return LayerCost{2 * Count + SZ_OUT, Count * (sizeof(T) * 2 + sizeof(Col)) + (SZ_OUT + 1) * sizeof(u32) + 2 * SZ_OUT * sizeof(T)};
+			return LayerCost{0, 0};
+		}
+	};
+}
@@ -64,16 +64,19 @@ namespace sx
 		constexpr static auto HEIGHT_OUT = HEIGHT_IN / 2;
 		constexpr static auto SZ_IN = WIDTH_IN * HEIGHT_IN * DEPTH_IN;
 		constexpr static auto SZ_OUT = WIDTH_OUT * HEIGHT_OUT * DEPTH_IN;
-		
+		constexpr static auto ROUTE = (FN_POOL == FnPool::MIN) || (FN_POOL == FnPool::MAX);
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		// Generated functions.
+		// Members.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		SX_MC_LAYER_TRIVIAL(Downscale2, SZ_OUT, this->OutTrans, this->Gradient)
+		BatchBuf<T> OutTransBatch;
+		BatchBuf<T> GradientBatch;
+		BatchBuf<uMAX> RouteBatch;
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		// Execute.
+		// Execute single sample.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		SX_FNSIG_LAYER_EXE final
+		auto exeSample ( const T* _Input, T* _OutTrans, uMAX* _Route ) -> void
 		{
 			auto ox = uMAX(0);
 			auto oy = uMAX(0);
@@ -85,45 +88,43 @@ namespace sx
 					if constexpr((FN_POOL == FnPool::AVG) || (FN_POOL == FnPool::ADD))
 					{
 						auto Sum = T(0);
-						Sum += this->Input[math::index_c(ix, iy, d, WIDTH_IN, HEIGHT_IN)];
-						Sum += this->Input[math::index_c(ix + uMAX(1), iy, d, WIDTH_IN, HEIGHT_IN)];
-						Sum += this->Input[math::index_c(ix, iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)];
-						Sum += this->Input[math::index_c(ix + uMAX(1), iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)];
+						Sum += _Input[math::index_c(ix, iy, d, WIDTH_IN, HEIGHT_IN)];
+						Sum += _Input[math::index_c(ix + uMAX(1), iy, d, WIDTH_IN, HEIGHT_IN)];
+						Sum += _Input[math::index_c(ix, iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)];
+						Sum += _Input[math::index_c(ix + uMAX(1), iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)];
 
-						if constexpr(FN_POOL == FnPool::AVG) this->OutTrans[math::index_c(ox, oy, d, WIDTH_OUT, HEIGHT_OUT)] = Sum * T(0.25);
-						if constexpr(FN_POOL == FnPool::ADD) this->OutTrans[math::index_c(ox, oy, d, WIDTH_OUT, HEIGHT_OUT)] = Sum;
+						if constexpr(FN_POOL == FnPool::AVG) _OutTrans[math::index_c(ox, oy, d, WIDTH_OUT, HEIGHT_OUT)] = Sum * T(0.25);
+						if constexpr(FN_POOL == FnPool::ADD) _OutTrans[math::index_c(ox, oy, d, WIDTH_OUT, HEIGHT_OUT)] = Sum;
 					}
 
 					if constexpr((FN_POOL == FnPool::MIN) || (FN_POOL == FnPool::MAX))
 					{
 						T Candidates[4];
-						Candidates[0] = this->Input[math::index_c(ix, iy, d, WIDTH_IN, HEIGHT_IN)];
-						Candidates[1] = this->Input[math::index_c(ix + uMAX(1), iy, d, WIDTH_IN, HEIGHT_IN)];
-						Candidates[2] = this->Input[math::index_c(ix, iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)];
-						Candidates[3] = this->Input[math::index_c(ix + uMAX(1), iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)];
+						Candidates[0] = _Input[math::index_c(ix, iy, d, WIDTH_IN, HEIGHT_IN)];
+						Candidates[1] = _Input[math::index_c(ix + uMAX(1), iy, d, WIDTH_IN, HEIGHT_IN)];
+						Candidates[2] = _Input[math::index_c(ix, iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)];
+						Candidates[3] = _Input[math::index_c(ix + uMAX(1), iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)];
 
 						T* Picked;
 						if constexpr(FN_POOL == FnPool::MIN) Picked = std::min_element(Candidates, Candidates + 4);
 						if constexpr(FN_POOL == FnPool::MAX) Picked = std::max_element(Candidates, Candidates + 4);
 					
 						const auto o = math::index_c(ox, oy, d, WIDTH_OUT, HEIGHT_OUT);
-						this->Route[o] = std::distance(Candidates, Picked);
-						this->OutTrans[o] = *Picked;
+						_Route[o] = std::distance(Candidates, Picked);
+						_OutTrans[o] = *Picked;
 					}
 				}
 
 				++ox; if(ox >= WIDTH_OUT) { ox = uMAX(0); ++oy; }
 			}}
-
-			SX_MC_LAYER_NEXT_EXE;
 		}
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		// Backpropagate.
+		// Backpropagate single sample. Without front gradient error derivative is taken from _Target.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		SX_FNSIG_LAYER_FIT final
+		auto fitSample ( const T* _Target, const T* _FrontGradient, const T* _OutTrans, const uMAX* _Route, T* _Gradient ) -> void
 		{
-			if constexpr((FN_POOL == FnPool::MIN) || (FN_POOL == FnPool::MAX)) memZero(SZ_IN, this->Gradient);
+			if constexpr((FN_POOL == FnPool::MIN) || (FN_POOL == FnPool::MAX)) memZero(SZ_IN, _Gradient);
 			
 			auto ox = uMAX(0);
 			auto oy = uMAX(0);
@@ -136,32 +137,96 @@ namespace sx
 					
 					if constexpr((FN_POOL == FnPool::AVG) || (FN_POOL == FnPool::ADD))
 					{
-						SX_MC_LAYER_DER_ERR;
+						auto DerErr = _FrontGradient ? _FrontGradient[o] : errorDer<T,FN_ERR>(_Target[o], _OutTrans[o]);
 						if constexpr(FN_POOL == FnPool::AVG) DerErr *= T(0.25);
 
-						this->Gradient[math::index_c(ix, iy, d, WIDTH_IN, HEIGHT_IN)] = DerErr;
-						this->Gradient[math::index_c(ix + uMAX(1), iy, d, WIDTH_IN, HEIGHT_IN)] = DerErr;
-						this->Gradient[math::index_c(ix, iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)] = DerErr;
-						this->Gradient[math::index_c(ix + uMAX(1), iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)] = DerErr;
+						_Gradient[math::index_c(ix, iy, d, WIDTH_IN, HEIGHT_IN)] = DerErr;
+						_Gradient[math::index_c(ix + uMAX(1), iy, d, WIDTH_IN, HEIGHT_IN)] = DerErr;
+						_Gradient[math::index_c(ix, iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)] = DerErr;
+						_Gradient[math::index_c(ix + uMAX(1), iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)] = DerErr;
 					}
 
 					if constexpr((FN_POOL == FnPool::MIN) || (FN_POOL == FnPool::MAX))
 					{
-						SX_MC_LAYER_DER_ERR;
+						auto DerErr = _FrontGradient ? _FrontGradient[o] : errorDer<T,FN_ERR>(_Target[o], _OutTrans[o]);
 
-						if(this->Route[o] == 0) this->Gradient[math::index_c(ix, iy, d, WIDTH_IN, HEIGHT_IN)] = DerErr;
-						else if(this->Route[o] == 1) this->Gradient[math::index_c(ix + uMAX(1), iy, d, WIDTH_IN, HEIGHT_IN)] = DerErr;
-						else if(this->Route[o] == 2) this->Gradient[math::index_c(ix, iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)] = DerErr;
-						else this->Gradient[math::index_c(ix + uMAX(1), iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)] = DerErr;
+						if(_Route[o] == 0) _Gradient[math::index_c(ix, iy, d, WIDTH_IN, HEIGHT_IN)] = DerErr;
+						else if(_Route[o] == 1) _Gradient[math::index_c(ix + uMAX(1), iy, d, WIDTH_IN, HEIGHT_IN)] = DerErr;
+						else if(_Route[o] == 2) _Gradient[math::index_c(ix, iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)] = DerErr;
+						else _Gradient[math::index_c(ix + uMAX(1), iy + uMAX(1), d, WIDTH_IN, HEIGHT_IN)] = DerErr;
 					}
 				}
 
 				++ox; if(ox >= WIDTH_OUT) { ox = uMAX(0); ++oy; }
 			}}
+		}
+
+		
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Generated functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_MC_LAYER_TRIVIAL(Downscale2, SZ_OUT, this->OutTrans, this->Gradient)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->OutTransBatch.data(), this->GradientBatch.data())
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE final
+		{
+			if constexpr(ROUTE) this->exeSample(this->Input, this->OutTrans, this->Route);
+			else this->exeSample(this->Input, this->OutTrans, nullptr);
+
+			SX_MC_LAYER_NEXT_EXE;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch. Samples are split across thread pool.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			const auto OutTrans = this->OutTransBatch.reserve(_Count * SZ_OUT);
+			const auto Route = ROUTE ? this->RouteBatch.reserve(_Count * SZ_OUT) : nullptr;
+
+			threadPool().parallelFor(_Count, parGrain(SZ_IN), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto n = _Beg; n < _End; ++n) this->exeSample(this->inBatch(n), OutTrans + math::index_c(0, n, SZ_OUT), ROUTE ? (Route + math::index_c(0, n, SZ_OUT)) : nullptr);
+			});
+
+			SX_MC_LAYER_NEXT_EXE_BATCH;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT final
+		{
+			const auto FrontGradient = this->Front ? this->Front->gradient() : nullptr;
+			if constexpr(ROUTE) this->fitSample(_Target, FrontGradient, this->OutTrans, this->Route, this->Gradient);
+			else this->fitSample(_Target, FrontGradient, this->OutTrans, nullptr, this->Gradient);
 
 			SX_MC_LAYER_NEXT_FIT;
 		}
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate batch. Samples are split across thread pool.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT_BATCH final
+		{
+			const auto FrontGradient = this->Front ? this->Front->gradientBatch() : nullptr;
+			const auto Gradient = this->GradientBatch.reserve(_Count * SZ_IN);
+
+			threadPool().parallelFor(_Count, parGrain(SZ_IN), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto n = _Beg; n < _End; ++n)
+				{
+					const auto o = math::index_c(0, n, SZ_OUT);
+					this->fitSample(_Target ? (_Target + n * _Stride) : nullptr, FrontGradient ? (FrontGradient + o) : nullptr, this->OutTransBatch.data() + o, ROUTE ? (this->RouteBatch.data() + o) : nullptr, Gradient + math::index_c(0, n, SZ_IN));
+				}
+			});
+
+			SX_MC_LAYER_NEXT_FIT_BATCH;
+		}
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Get output error in respect to argument.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -171,5 +236,20 @@ namespace sx
 		// Multi threading utility.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		#include "./data/ComImplExchangeSkip.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::DOWNSCALE2, SZ_IN, SZ_OUT, 0, 0}; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			if(_Op == LayerOp::EXE) return LayerCost{4 * SZ_OUT, (SZ_IN + SZ_OUT) * sizeof(T)};
+			if(_Op == LayerOp::FIT) return LayerCost{SZ_IN, (SZ_IN + SZ_OUT) * sizeof(T)};
+			return LayerCost{0, 0};
+		}
 	};
 }
@@ -36,11 +36,13 @@ namespace sx
 		// Members.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		alignas(ALIGNMENT) T Gradient[SIZE];
+		BatchBuf<T> GradientBatch;
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Generated functions.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_MC_LAYER_TRIVIAL(Error, SIZE, this->Back->out(), this->Gradient)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->InputBatch, this->GradientBatch.data())
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Execute.
@@ -48,10 +50,18 @@ namespace sx
 		SX_FNSIG_LAYER_EXE final
 		{
 			if(!this->Front) return;
-			else if(this->Front && _Chain) this->Front->exe();
+			else if(this->Front && _Chain) SX_MC_PROFILE(this->Front, LayerOp::EXE, this->Front->exe());
 			else return;
 		}
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			if(this->Front && _Chain) { this->Front->setInputBatch(this->InputBatch, this->InputStride); SX_MC_PROFILE_BATCH(this->Front, LayerOp::EXE_BATCH, _Count, this->Front->exeBatch(_Count)); }
+		}
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Backpropagate.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -69,11 +79,43 @@ namespace sx
 			SX_MC_LAYER_NEXT_FIT;
 		}
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate batch.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT_BATCH final
+		{
+			const auto Gradient = this->GradientBatch.reserve(_Count * SIZE);
+
+			if(!this->Front)
+			{
+				for(auto n = uMAX(0); n < _Count; ++n)
+				{
+					const auto Input = this->inBatch(n);
+					const auto Target = _Target + n * _Stride;
+					const auto SampleGrad = Gradient + math::index_c(0, n, SIZE);
+					for(auto g = uMAX(0); g < SIZE; ++g) SampleGrad[g] = errorDer<T,FN_ERR>(Target[g], Input[g]);
+				}
+			}
+			else memCopy(_Count * SIZE, Gradient, this->Front->gradientBatch());
+
+			SX_MC_LAYER_NEXT_FIT_BATCH;
+		}
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Get output error in respect to argument.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_FNSIG_LAYER_ERR final { return error<T,FN_ERR>(SIZE, _Target, this->Back->out()); }
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Get mean output error of batch in respect to arguments.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_ERR_BATCH final
+		{
+			auto Err = T(0);
+			for(auto n = uMAX(0); n < _Count; ++n) Err += error<T,FN_ERR>(SIZE, _Target + n * _Stride, this->inBatch(n));
+			return Err / T(std::max(_Count, uMAX(1)));
+		}
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Store parameters to stream.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -88,5 +130,19 @@ namespace sx
 		// Multi threading utility.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_FNSIG_LAYER_EXCHANGE final { return; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::ERROR, SIZE, SIZE, 0, 0}; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			if(_Op == LayerOp::FIT) return LayerCost{2 * SIZE, 3 * SIZE * sizeof(T)};
+			return LayerCost{0, 0};
+		}
 	};
 }
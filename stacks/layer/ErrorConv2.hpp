@@ -51,11 +51,34 @@ namespace sx
 		// Members.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		alignas(ALIGNMENT) T Gradient[SZ_IN];
+		BatchBuf<T> GradientBatch;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Error derivative of single sample, averaged over kernel window.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto fitSample ( const T* _Target, const T* _Input, T* _Gradient ) -> void
+		{
+			memZero(SZ_IN, _Gradient);
+
+
+			for(auto d = uMAX(0); d < DEPTH_IN; ++d) { for(auto y = RADIUS; y < (HEIGHT_IN - RADIUS); ++y)
+			{
+				auto LineGrad = _Gradient + math::index_c(RADIUS, y, WIDTH_IN);
+
+				for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
+				{
+					auto LinePred = _Input + math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
+					auto LineReal = _Target + math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
+					for(auto x = uMAX(0); x < LINE_LEN; ++x) for(auto w = uMAX(0); w < SZ_KER_EDGE; ++w) LineGrad[x] += errorDer<T,FN_ERR>(LineReal[x+w], LinePred[x+w]) / SZ_KER;
+				}
+			}}
+		}
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Generated functions.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_MC_LAYER_TRIVIAL(ErrorConv2, SZ_IN, this->Back->out(), this->Gradient)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->InputBatch, this->GradientBatch.data())
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Execute.
@@ -63,37 +86,48 @@ namespace sx
 		SX_FNSIG_LAYER_EXE final
 		{
 			if(!this->Front) return;
-			else if(this->Front && _Chain) this->Front->exe();
+			else if(this->Front && _Chain) SX_MC_PROFILE(this->Front, LayerOp::EXE, this->Front->exe());
 			else return;
 		}
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			if(this->Front && _Chain) { this->Front->setInputBatch(this->InputBatch, this->InputStride); SX_MC_PROFILE_BATCH(this->Front, LayerOp::EXE_BATCH, _Count, this->Front->exeBatch(_Count)); }
+		}
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Backpropagate.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_FNSIG_LAYER_FIT final
 		{
-			if(!this->Front)
-			{
-				memZero(SZ_IN, this->Gradient);
+			if(!this->Front) this->fitSample(_Target, this->Input, this->Gradient);
+			else memCopy(SZ_IN,  this->Gradient, this->Front->gradient());
+
+			
+			SX_MC_LAYER_NEXT_FIT;
+		}
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate batch.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT_BATCH final
+		{
+			const auto Gradient = this->GradientBatch.reserve(_Count * SZ_IN);
 
-				for(auto d = uMAX(0); d < DEPTH_IN; ++d) { for(auto y = RADIUS; y < (HEIGHT_IN - RADIUS); ++y)
+			if(!this->Front)
+			{
+				threadPool().parallelFor(_Count, parGrain(SZ_IN * SZ_KER * 2), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
 				{
-					auto LineGrad = this->Gradient + math::index_c(RADIUS, y, WIDTH_IN);
-
-					for(auto kr = uMAX(0); kr < SZ_KER_EDGE; ++kr)
-					{
-						auto LinePred = this->Input + math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
-						auto LineReal = _Target + math::index_c(0, y - RADIUS + kr, d, WIDTH_IN, HEIGHT_IN);
-						for(auto x = uMAX(0); x < LINE_LEN; ++x) for(auto w = uMAX(0); w < SZ_KER_EDGE; ++w) LineGrad[x] += errorDer<T,FN_ERR>(LineReal[x+w], LinePred[x+w]) / SZ_KER;
-					}
-				}}
+					for(auto n = _Beg; n < _End; ++n) this->fitSample(_Target + n * _Stride, this->inBatch(n), Gradient + math::index_c(0, n, SZ_IN));
+				});
 			}
 
-			else memCopy(SZ_IN,  this->Gradient, this->Front->gradient());
+			else memCopy(_Count * SZ_IN, Gradient, this->Front->gradientBatch());
 
-			
-			SX_MC_LAYER_NEXT_FIT;
+			SX_MC_LAYER_NEXT_FIT_BATCH;
 		}
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -101,6 +135,16 @@ namespace sx
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_FNSIG_LAYER_ERR final { return error<T,FN_ERR>(SZ_IN, _Target, this->Back->out()); }
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Get mean output error of batch in respect to arguments.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_ERR_BATCH final
+		{
+			auto Err = T(0);
+			for(auto n = uMAX(0); n < _Count; ++n) Err += error<T,FN_ERR>(SZ_IN, _Target + n * _Stride, this->inBatch(n));
+			return Err / T(std::max(_Count, uMAX(1)));
+		}
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Store parameters to stream.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -115,5 +159,21 @@ namespace sx
 		// Multi threading utility.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		SX_FNSIG_LAYER_EXCHANGE final { return; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::ERROR_CONV2, SZ_IN, SZ_IN, 0, 0}; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			constexpr auto TAPS = DEPTH_IN * (HEIGHT_IN - RADIUS * 2) * LINE_LEN * SZ_KER;
+
+			if(_Op == LayerOp::FIT) return LayerCost{4 * TAPS, 3 * SZ_IN * sizeof(T)};
+			return LayerCost{0, 0};
+		}
 	};
 }
@@ -41,54 +41,120 @@ namespace sx
 		constexpr static auto HEIGHT_OUT = HEIGHT_IN * 2;
 		constexpr static auto SZ_IN = WIDTH_IN * HEIGHT_IN * DEPTH_IN;
 		constexpr static auto SZ_OUT = WIDTH_OUT * HEIGHT_OUT * DEPTH_IN;
-		
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		// Generated functions.
+		// Members.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		SX_MC_LAYER_TRIVIAL(Upscale2, SZ_OUT, this->OutTrans, this->Gradient)
+		BatchBuf<T> OutTransBatch;
+		BatchBuf<T> GradientBatch;
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		// Execute. Optimized for sequential access.
+		// Execute single sample. Optimized for sequential access.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		SX_FNSIG_LAYER_EXE final
+		auto exeSample ( const T* _Input, T* _OutTrans ) -> void
 		{
-			auto LnIn = this->Input;
-			auto LnOut = this->OutTrans;
+			auto LnIn = _Input;
+			auto LnOut = _OutTrans;
 			for(auto d = u64(0); d < DEPTH_IN; ++d) { for(auto iy = uMAX(0); iy < HEIGHT_IN; ++iy)
 			{
 				for(auto ix = uMAX(0); ix < WIDTH_IN; ++ix) { *LnOut = *LnIn; *(LnOut+1) = *LnIn; LnIn += 1; LnOut += 2; }
 				LnIn -= WIDTH_IN;
 				for(auto ix = uMAX(0); ix < WIDTH_IN; ++ix) { *LnOut = *LnIn; *(LnOut+1) = *LnIn; LnIn += 1; LnOut += 2; }
 			}}
-
-
-			SX_MC_LAYER_NEXT_EXE;
 		}
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		// Backpropagate. Optimized for sequential access.
+		// Backpropagate single sample. Optimized for sequential access.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		SX_FNSIG_LAYER_FIT final
+		auto fitSample ( const T* _FrontGradient, T* _Gradient ) -> void
 		{
-			memZero(SZ_IN, this->Gradient);
-
+			memZero(SZ_IN, _Gradient);
 
-			auto LnInGrad = this->Front->gradient();
-			auto LnOutGrad = this->Gradient;
+			auto LnInGrad = _FrontGradient;
+			auto LnOutGrad = _Gradient;
 			for(auto d = uMAX(0); d < DEPTH_IN; ++d) { for(auto iy = uMAX(0); iy < HEIGHT_IN; ++iy)
 			{
 				for(auto ix = uMAX(0); ix < WIDTH_IN; ++ix) { *LnOutGrad += *LnInGrad; *LnOutGrad += *(LnInGrad+1); LnOutGrad += 1; LnInGrad += 2; }
 				LnOutGrad -= WIDTH_IN;
 				for(auto ix = uMAX(0); ix < WIDTH_IN; ++ix) { *LnOutGrad += *LnInGrad; *LnOutGrad += *(LnInGrad+1); LnOutGrad += 1; LnInGrad += 2; }
 			}}
+		}
+		
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Generated functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_MC_LAYER_TRIVIAL(Upscale2, SZ_OUT, this->OutTrans, this->Gradient)
+		SX_MC_LAYER_TRIVIAL_BATCH(this->OutTransBatch.data(), this->GradientBatch.data())
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE final
+		{
+			this->exeSample(this->Input, this->OutTrans);
+
+			SX_MC_LAYER_NEXT_EXE;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Execute batch. Samples are split across thread pool.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_EXE_BATCH final
+		{
+			const auto OutTrans = this->OutTransBatch.reserve(_Count * SZ_OUT);
 
+			threadPool().parallelFor(_Count, parGrain(SZ_OUT), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto n = _Beg; n < _End; ++n) this->exeSample(this->inBatch(n), OutTrans + math::index_c(0, n, SZ_OUT));
+			});
+
+			SX_MC_LAYER_NEXT_EXE_BATCH;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT final
+		{
+			this->fitSample(this->Front->gradient(), this->Gradient);
 
 			SX_MC_LAYER_NEXT_FIT;
 		}
 
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Backpropagate batch. Samples are split across thread pool.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_FIT_BATCH final
+		{
+			const auto FrontGradient = this->Front->gradientBatch();
+			const auto Gradient = this->GradientBatch.reserve(_Count * SZ_IN);
+
+			threadPool().parallelFor(_Count, parGrain(SZ_OUT), [&]( const uMAX _Beg, const uMAX _End, const uMAX )
+			{
+				for(auto n = _Beg; n < _End; ++n) this->fitSample(FrontGradient + math::index_c(0, n, SZ_OUT), Gradient + math::index_c(0, n, SZ_IN));
+			});
+
+			SX_MC_LAYER_NEXT_FIT_BATCH;
+		}
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Multi threading utility.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		#include "./data/ComImplExchangeSkip.hpp"
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Describe type and sizes.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_DESC final { return LayerDesc{LayerType::UPSCALE2, SZ_IN, SZ_OUT, 0, 0}; }
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Work of single call of operation.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SX_FNSIG_LAYER_COST final
+		{
+			if(_Op == LayerOp::EXE) return LayerCost{0, (SZ_IN + SZ_OUT) * sizeof(T)};
+			if(_Op == LayerOp::FIT) return LayerCost{SZ_OUT, (2 * SZ_IN + SZ_OUT) * sizeof(T)};
+			return LayerCost{0, 0};
+		}
 	};
 }
@@ -0,0 +1,56 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Neural Networks Experiment.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace sx
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Buffer of batch activations or gradients, laid out as [N][SZ]. Grows on demand, content is not kept on growth.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class BatchBuf
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		T* Data;
+		uMAX Capacity;
+
+		public:
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		BatchBuf ( void ) : Data(nullptr), Capacity(0) {}
+		~BatchBuf ( void ) { std::free(this->Data); }
+
+		BatchBuf ( const BatchBuf& ) = delete;
+		auto operator= ( const BatchBuf& ) -> BatchBuf& = delete;
+
+		// Make room for _Size Ts.
+		auto reserve ( const uMAX _Size ) -> T*
+		{
+			if(_Size > this->Capacity)
+			{
+				const auto Bytes = ((_Size * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+				std::free(this->Data);
+				this->Data = static_cast<T*>(std::aligned_alloc(ALIGNMENT, Bytes));
+				if(!this->Data) { this->Capacity = 0; throw std::bad_alloc(); }
+				this->Capacity = _Size;
+			}
+
+			return this->Data;
+		}
+
+		inline auto data ( void ) const -> T* { return this->Data; }
+	};
+}
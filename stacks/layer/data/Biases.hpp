@@ -33,8 +33,9 @@ namespace sx
 		alignas(ALIGNMENT) T BiasesDlt[SZ_BUF];
 		alignas(ALIGNMENT) T BiasesDltM[SZ_BUF];
 		alignas(ALIGNMENT) T BiasesDltV[SZ_BUF];
+		const T* BiasesSrc;
 
-		LDBiases ( void ) : Biases{}, BiasesDlt{}, BiasesDltM{}, BiasesDltV{} { SX_MC_BIASES_INIT }
+		LDBiases ( void ) : Biases{}, BiasesDlt{}, BiasesDltM{}, BiasesDltV{}, BiasesSrc(Biases) { SX_MC_BIASES_INIT }
 	};
 
 
@@ -45,8 +46,9 @@ namespace sx
 		alignas(ALIGNMENT) T Biases[SZ_BUF];
 		alignas(ALIGNMENT) T BiasesDlt[SZ_BUF];
 		alignas(ALIGNMENT) T BiasesDltM[SZ_BUF];
+		const T* BiasesSrc;
 
-		LDBiases ( void ) : Biases{}, BiasesDlt{}, BiasesDltM{} { SX_MC_BIASES_INIT }
+		LDBiases ( void ) : Biases{}, BiasesDlt{}, BiasesDltM{}, BiasesSrc(Biases) { SX_MC_BIASES_INIT }
 	};
 
 
@@ -56,7 +58,8 @@ namespace sx
 	{
 		alignas(ALIGNMENT) T Biases[SZ_BUF];
 		alignas(ALIGNMENT) T BiasesDlt[SZ_BUF];
+		const T* BiasesSrc;
 
-		LDBiases ( void ) : Biases{}, BiasesDlt{} { SX_MC_BIASES_INIT }
+		LDBiases ( void ) : Biases{}, BiasesDlt{}, BiasesSrc(Biases) { SX_MC_BIASES_INIT }
 	};
 }
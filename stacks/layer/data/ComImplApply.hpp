@@ -12,6 +12,9 @@
 			
 			if(!this->IsLocked)
 			{
+				this->own();
+				this->maskDeltas();
+
 				if constexpr(!needBufM<T,FN_OPTIM>() && !needBufV<T,FN_OPTIM>()) optimApply<T,FN_OPTIM>(Rate, this->Iter, SZ_BUF_W, this->Weights, this->WeightsDlt, nullptr, nullptr);
 				if constexpr(needBufM<T,FN_OPTIM>() && !needBufV<T,FN_OPTIM>()) optimApply<T,FN_OPTIM>(Rate, this->Iter, SZ_BUF_W, this->Weights, this->WeightsDlt, this->WeightsDltM, nullptr);
 				if constexpr(needBufM<T,FN_OPTIM>() && needBufV<T,FN_OPTIM>()) optimApply<T,FN_OPTIM>(Rate, this->Iter, SZ_BUF_W, this->Weights, this->WeightsDlt, this->WeightsDltM, this->WeightsDltV);
@@ -19,6 +22,9 @@
 				if constexpr(!needBufM<T,FN_OPTIM>() && !needBufV<T,FN_OPTIM>()) optimApply<T,FN_OPTIM>(Rate, this->Iter, SZ_BUF_B, this->Biases, this->BiasesDlt, nullptr, nullptr);
 				if constexpr(needBufM<T,FN_OPTIM>() && !needBufV<T,FN_OPTIM>()) optimApply<T,FN_OPTIM>(Rate, this->Iter, SZ_BUF_B, this->Biases, this->BiasesDlt, this->BiasesDltM, nullptr);
 				if constexpr(needBufM<T,FN_OPTIM>() && needBufV<T,FN_OPTIM>()) optimApply<T,FN_OPTIM>(Rate, this->Iter, SZ_BUF_B, this->Biases, this->BiasesDlt, this->BiasesDltM, this->BiasesDltV);
+
+				this->maskWeights();
+				this->narrowWeights();
 			}
 
 			SX_MC_LAYER_NEXT_APPLY;
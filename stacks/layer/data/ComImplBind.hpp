@@ -0,0 +1,26 @@
+		// Binding locks layer and unbinding unlocks it. Own parameters are left untouched and return into use once unbound,
+		// layer bound before it ever had them gets them on first use after. Writing parameters or unlocking detaches layer instead.
+		SX_FNSIG_LAYER_BIND final
+		{
+			this->WeightsSrc = _Weights ? _Weights : this->Weights;
+			this->BiasesSrc = _Biases ? _Biases : this->Biases;
+			this->IsLocked = (_Weights != nullptr);
+			this->narrowWeights();
+		}
+
+		// Unlocked bound layer trains copy of bound parameters, which it executes from as well.
+		SX_FNSIG_LAYER_UNLOCK final
+		{
+			if((this->WeightsSrc != this->Weights) || (this->BiasesSrc != this->Biases)) this->detach();
+			this->IsLocked = false;
+		}
+
+		// Copy bound parameters into own buffers and execute from them. Called before parameters are written,
+		// so writes reach execution instead of own buffers nothing reads while bound.
+		inline auto detach ( void ) -> void
+		{
+			this->own();
+			if(this->WeightsSrc != this->Weights) { memCopy(SZ_BUF_W, this->Weights, this->WeightsSrc); this->WeightsSrc = this->Weights; }
+			if(this->BiasesSrc != this->Biases) { memCopy(SZ_BUF_B, this->Biases, this->BiasesSrc); this->BiasesSrc = this->Biases; }
+			this->narrowWeights();
+		}
\ No newline at end of file
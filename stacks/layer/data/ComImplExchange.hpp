@@ -1,12 +1,16 @@
 		// This function expects _Master to be in identical configuration as this.
 		SX_FNSIG_LAYER_EXCHANGE final
 		{
+			SX_MC_TRACE(layerTypeName(this->desc().Type), "exchange");
 			auto Master = static_cast<decltype(this)>(_Master);
+			this->detach();
+			Master->own();
 
 			memCopy(SZ_BUF_W, Master->WeightsDlt, this->WeightsDlt);
 			memCopy(SZ_BUF_B, Master->BiasesDlt, this->BiasesDlt);
-			memCopy(SZ_BUF_W, this->Weights, Master->Weights);
-			memCopy(SZ_BUF_B, this->Biases, Master->Biases);
+			memCopy(SZ_BUF_W, this->Weights, Master->WeightsSrc);
+			memCopy(SZ_BUF_B, this->Biases, Master->BiasesSrc);
+			this->narrowWeights();
 
 
 			if(this->Front && _Chain) this->Front->exchange(Master->Front);
@@ -0,0 +1,55 @@
+		// State holds iteration counter bit copied into Ts, parameters and optimizer buffers present for FN_OPTIM.
+		constexpr static auto SZ_BUF_ITER = (sizeof(uMAX) + sizeof(T) - 1) / sizeof(T);
+		constexpr static auto SZ_BUF_STATE = SZ_BUF_ITER + (SZ_BUF_W + SZ_BUF_B) * (1 + uMAX(needBufM<T,FN_OPTIM>()) + uMAX(needBufV<T,FN_OPTIM>()));
+
+		SX_FNSIG_LAYER_BUFSZ final
+		{
+			const auto Sz = (_Buf == LayerBuf::STATE) ? SZ_BUF_STATE : (SZ_BUF_W + SZ_BUF_B);
+			if(this->Front && _Chain) return Sz + this->Front->bufSz(_Buf);
+			else return Sz;
+		}
+
+		SX_FNSIG_LAYER_GATHER final
+		{
+			this->ready(_Buf != LayerBuf::PARAMS);
+			if(_Buf == LayerBuf::PARAMS) { memCopy(SZ_BUF_W, _Dst, this->WeightsSrc); memCopy(SZ_BUF_B, _Dst + SZ_BUF_W, this->BiasesSrc); }
+			if(_Buf == LayerBuf::DELTAS) { memCopy(SZ_BUF_W, _Dst, this->WeightsDlt); memCopy(SZ_BUF_B, _Dst + SZ_BUF_W, this->BiasesDlt); }
+			
+			if(_Buf == LayerBuf::STATE)
+			{
+				auto Dst = _Dst;
+				std::memcpy(Dst, &this->Iter, sizeof(uMAX)); Dst += SZ_BUF_ITER;
+				memCopy(SZ_BUF_W, Dst, this->WeightsSrc); Dst += SZ_BUF_W;
+				memCopy(SZ_BUF_B, Dst, this->BiasesSrc); Dst += SZ_BUF_B;
+				if constexpr(needBufM<T,FN_OPTIM>()) { memCopy(SZ_BUF_W, Dst, this->WeightsDltM); Dst += SZ_BUF_W; memCopy(SZ_BUF_B, Dst, this->BiasesDltM); Dst += SZ_BUF_B; }
+				if constexpr(needBufV<T,FN_OPTIM>()) { memCopy(SZ_BUF_W, Dst, this->WeightsDltV); Dst += SZ_BUF_W; memCopy(SZ_BUF_B, Dst, this->BiasesDltV); Dst += SZ_BUF_B; }
+				_Dst += SZ_BUF_STATE;
+			}
+			else _Dst += SZ_BUF_W + SZ_BUF_B;
+
+			SX_MC_LAYER_NEXT_GATHER;
+		}
+
+		SX_FNSIG_LAYER_SCATTER final
+		{
+			if(_Buf == LayerBuf::DELTAS) this->own();
+			else this->detach();
+			if(_Buf == LayerBuf::PARAMS) { memCopy(SZ_BUF_W, this->Weights, _Src); memCopy(SZ_BUF_B, this->Biases, _Src + SZ_BUF_W); }
+			if(_Buf == LayerBuf::DELTAS) { memCopy(SZ_BUF_W, this->WeightsDlt, _Src); memCopy(SZ_BUF_B, this->BiasesDlt, _Src + SZ_BUF_W); }
+
+			if(_Buf == LayerBuf::STATE)
+			{
+				auto Src = _Src;
+				std::memcpy(&this->Iter, Src, sizeof(uMAX)); Src += SZ_BUF_ITER;
+				memCopy(SZ_BUF_W, this->Weights, Src); Src += SZ_BUF_W;
+				memCopy(SZ_BUF_B, this->Biases, Src); Src += SZ_BUF_B;
+				if constexpr(needBufM<T,FN_OPTIM>()) { memCopy(SZ_BUF_W, this->WeightsDltM, Src); Src += SZ_BUF_W; memCopy(SZ_BUF_B, this->BiasesDltM, Src); Src += SZ_BUF_B; }
+				if constexpr(needBufV<T,FN_OPTIM>()) { memCopy(SZ_BUF_W, this->WeightsDltV, Src); Src += SZ_BUF_W; memCopy(SZ_BUF_B, this->BiasesDltV, Src); Src += SZ_BUF_B; }
+				_Src += SZ_BUF_STATE;
+			}
+			else _Src += SZ_BUF_W + SZ_BUF_B;
+
+			if(_Buf != LayerBuf::DELTAS) this->narrowWeights();
+
+			SX_MC_LAYER_NEXT_SCATTER;
+		}
\ No newline at end of file
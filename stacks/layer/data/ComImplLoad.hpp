@@ -1,7 +1,9 @@
 		SX_FNSIG_LAYER_LOAD final
 		{
+			this->detach();
 			_Stream.read(reinterpret_cast<char*>(this->Weights), SZ_BUF_W * sizeof(T));
 			_Stream.read(reinterpret_cast<char*>(this->Biases), SZ_BUF_B * sizeof(T));
+			this->narrowWeights();
 
 			SX_MC_LAYER_NEXT_LOAD;
 		}
\ No newline at end of file
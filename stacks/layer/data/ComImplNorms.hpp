@@ -0,0 +1,9 @@
+		SX_FNSIG_LAYER_NORMS final
+		{
+			const auto sqSum = []( const uMAX _Size, const T* _Src ) { return std::transform_reduce(_Src, _Src + _Size, rMAX(0), std::plus<rMAX>(), []( const T _Value ) { return rMAX(_Value) * rMAX(_Value); }); };
+
+			// Own buffers missing so far count as zero, layer never used has no weights and bound one no deltas.
+			const auto SqW = this->WeightsSrc ? sqSum(SZ_BUF_W, this->WeightsSrc) : rMAX(0);
+			const auto SqDltW = this->Weights ? sqSum(SZ_BUF_W, this->WeightsDlt) : rMAX(0);
+			return LayerNorms{std::sqrt(SqW + sqSum(SZ_BUF_B, this->BiasesSrc)), std::sqrt(SqDltW + sqSum(SZ_BUF_B, this->BiasesDlt))};
+		}
@@ -0,0 +1,2 @@
+		// Magnitude pruning of own weights. Pruned weights stay zero through apply.
+		SX_FNSIG_LAYER_PRUNE final { return this->pruneWeights(_Sparsity); }
\ No newline at end of file
@@ -2,7 +2,7 @@
 		{
 			if(!this->IsLocked)
 			{
-				memZero(SZ_BUF_W, this->WeightsDlt);
+				if(this->Weights) memZero(SZ_BUF_W, this->WeightsDlt);
 				memZero(SZ_BUF_B, this->BiasesDlt);
 			}
 			
@@ -28,46 +28,78 @@ namespace sx
 
 		UNI_SIGMOID,
 		UNI_TANH,
-		UNI_RELU
+		UNI_RELU,
+
+		NRM_RELU_FACTORS // Leading SZ_IN x SZ_OUT factor as NRM_RELU, rest normal over SZ_OUT so product of factors keeps variance.
 	};
 
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Weights m buffer.
+	// Weights m buffer. Lives in own buffers of LDWeights.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	template<class T, uMAX SIZE> struct LDWeightsM
 	{
-		alignas(ALIGNMENT) T WeightsDltM[SIZE];
-		LDWeightsM ( void ) : WeightsDltM{}{}
+		T* WeightsDltM;
+		LDWeightsM ( void ) : WeightsDltM(nullptr){}
 	};
 	
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Weights m and v buffers.
+	// Weights m and v buffers. Live in own buffers of LDWeights.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	template<class T, uMAX SIZE> struct LDWeightsMV
 	{
-		alignas(ALIGNMENT) T WeightsDltM[SIZE];
-		alignas(ALIGNMENT) T WeightsDltV[SIZE];
-		LDWeightsMV ( void ) : WeightsDltM{}, WeightsDltV{}{}
+		T* WeightsDltM;
+		T* WeightsDltV;
+		LDWeightsMV ( void ) : WeightsDltM(nullptr), WeightsDltV(nullptr){}
+	};
+
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Weights narrowed to storage format. Read by execution and backpropagation, refreshed from fp32 weights whenever they change.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, uMAX SIZE, FnStore FN_STORE> struct LDWeightsS
+	{
+		alignas(ALIGNMENT) StoreT<FN_STORE,T> WeightsStore[SIZE];
+		LDWeightsS ( void ) : WeightsStore{}{}
 	};
 
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Weights and delta buffers.
+	// Weights and delta buffers. Own weights, deltas and optimizer buffers share one allocation made and initialised on first use,
+	// so layer bound to external parameters for inference never carries them.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	template<class T, FnOptim FN_OPTIM, uMAX SZ_BUF, uMAX SZ_IN, uMAX SZ_OUT, FnInitWeights FN_INIT_W = FnInitWeights::DEFAULT>
+	template<class T, FnOptim FN_OPTIM, uMAX SZ_BUF, uMAX SZ_IN, uMAX SZ_OUT, FnInitWeights FN_INIT_W = FnInitWeights::DEFAULT, FnStore FN_STORE = FnStore::FP32>
 	struct LDWeights:
 	std::conditional_t<FN_OPTIM == FnOptim::MOMENTUM, LDWeightsM<T, SZ_BUF>, None1>,
-	std::conditional_t<FN_OPTIM == FnOptim::ADAM, LDWeightsMV<T, SZ_BUF>, None2>
+	std::conditional_t<FN_OPTIM == FnOptim::ADAM, LDWeightsMV<T, SZ_BUF>, None2>,
+	std::conditional_t<FN_STORE != FnStore::FP32, LDWeightsS<T, SZ_BUF, FN_STORE>, None3>
 	{
+		constexpr static auto SZ_PAD = ((SZ_BUF * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT / sizeof(T); // Stride of own buffers.
+		constexpr static auto BUFS_OWN = uMAX(2) + uMAX(FN_OPTIM == FnOptim::MOMENTUM) + uMAX(FN_OPTIM == FnOptim::ADAM) * 2;
+
 		alignas(ALIGNMENT) uMAX Iter;
 		
-		alignas(ALIGNMENT) T Weights[SZ_BUF];
-		alignas(ALIGNMENT) T WeightsDlt[SZ_BUF];
+		T* Weights; // Own weights, nullptr until first use.
+		T* WeightsDlt;
+		const T* WeightsSrc; // Weights used for execution. Own buffer unless bound to external memory, nullptr until either exists.
+		vec<u8> PruneMask; // Empty unless pruned. Zero marks weight held at zero.
+		BatchBuf<T> Own;
+
+		LDWeights ( void ) : Iter(0), Weights(nullptr), WeightsDlt(nullptr), WeightsSrc(nullptr), PruneMask(), Own() {}
 
-		LDWeights ( void ) : Iter(0), Weights{}, WeightsDlt{}
+		// Allocate and initialise own buffers unless done already. Execution switches to them when layer is not bound.
+		inline auto own ( void ) -> void
 		{
+			if(this->Weights) return;
+
+			const auto Buf = this->Own.reserve(SZ_PAD * BUFS_OWN);
+			memZero(SZ_PAD * BUFS_OWN, Buf);
+			this->Weights = Buf;
+			this->WeightsDlt = Buf + SZ_PAD;
+			if constexpr(FN_OPTIM == FnOptim::MOMENTUM) this->WeightsDltM = Buf + SZ_PAD * 2;
+			if constexpr(FN_OPTIM == FnOptim::ADAM) { this->WeightsDltM = Buf + SZ_PAD * 2; this->WeightsDltV = Buf + SZ_PAD * 3; }
+
 			if constexpr(FN_INIT_W == FnInitWeights::DEFAULT)
 			{
 				rng::rbuf(SZ_BUF, this->Weights, T(-0.01), T(0.01));
@@ -108,6 +140,83 @@ namespace sx
 				const auto Range = std::sqrt(T(2)) * std::sqrt(T(6) / (SZ_IN + SZ_OUT));
 				rng::rbuf(SZ_BUF, this->Weights, -Range, Range);
 			}
+
+			if constexpr(FN_INIT_W == FnInitWeights::NRM_RELU_FACTORS)
+			{
+				const auto Variance =  std::sqrt(T(2)) * std::sqrt(T(2) / (SZ_IN + SZ_OUT));
+				rng::rbuf_nrm(SZ_BUF, this->Weights, T(0), Variance);
+				rng::rbuf_nrm(SZ_BUF - SZ_IN * SZ_OUT, this->Weights + SZ_IN * SZ_OUT, T(0), std::sqrt(T(1) / T(SZ_OUT)));
+			}
+
+			if(!this->WeightsSrc)
+			{
+				this->WeightsSrc = this->Weights;
+				this->narrowWeights();
+			}
+		}
+
+		// Make weights used for execution available, with _Train also deltas. Bound layer executes from bound memory without own buffers.
+		// Callable from const functions, own buffers are made on demand and not part of observable state.
+		inline auto ready ( const bool _Train = false ) const -> void { if(!this->WeightsSrc || _Train) const_cast<LDWeights*>(this)->own(); }
+
+		// Refresh stored weights after weights or their source changed. Fp32 weights stay master copy for optimizer.
+		inline auto narrowWeights ( void ) -> void
+		{
+			if constexpr(FN_STORE != FnStore::FP32) if(this->WeightsSrc) storeNarrow<FN_STORE>(SZ_BUF, this->WeightsSrc, this->WeightsStore);
+		}
+
+		// Zero smallest magnitudes so _Sparsity share of weights is zero and mask them. Ties at threshold are pruned in order.
+		// Already pruned weights are zero, so raising sparsity over time extends mask. Zero sparsity removes mask.
+		inline auto pruneWeights ( const r64 _Sparsity ) -> bool
+		{
+			this->ready();
+			if(this->WeightsSrc != this->Weights) return false;
+
+			const auto Count = uMAX(std::clamp(_Sparsity, 0.0, 1.0) * r64(SZ_BUF));
+			if(Count == 0) { this->PruneMask.clear(); return true; }
+
+			auto Magnitudes = vec<T>(SZ_BUF);
+			for(auto i = uMAX(0); i < SZ_BUF; ++i) Magnitudes[i] = std::abs(this->Weights[i]);
+			std::nth_element(Magnitudes.begin(), Magnitudes.begin() + (Count - 1), Magnitudes.end());
+			const auto Threshold = Magnitudes[Count - 1];
+
+			auto Ties = Count;
+			for(auto i = uMAX(0); i < SZ_BUF; ++i) Ties -= std::abs(this->Weights[i]) < Threshold;
+
+			this->PruneMask.assign(SZ_BUF, 1);
+			for(auto i = uMAX(0); i < SZ_BUF; ++i)
+			{
+				const auto Magnitude = std::abs(this->Weights[i]);
+				if((Magnitude < Threshold) || ((Magnitude == Threshold) && Ties && Ties--)) { this->PruneMask[i] = 0; this->Weights[i] = T(0); }
+			}
+
+			this->narrowWeights();
+			return true;
+		}
+
+		// Drop deltas of pruned weights before optimizer and put pruned weights back to zero after it, since momentum still moves them.
+		inline auto maskDeltas ( void ) -> void
+		{
+			if(!this->PruneMask.empty()) for(auto i = uMAX(0); i < SZ_BUF; ++i) if(!this->PruneMask[i]) this->WeightsDlt[i] = T(0);
+		}
+
+		inline auto maskWeights ( void ) -> void
+		{
+			if(!this->PruneMask.empty()) for(auto i = uMAX(0); i < SZ_BUF; ++i) if(!this->PruneMask[i]) this->Weights[i] = T(0);
+		}
+
+		// Weights from _Off on as T. Fp32 storage points into weights directly, narrowed storage is widened into _Wide.
+		inline auto weightsAt ( const uMAX _Off, const uMAX _Count, T* _Wide ) const -> const T*
+		{
+			if constexpr(FN_STORE == FnStore::FP32) return this->WeightsSrc + _Off;
+			else { storeWiden<FN_STORE,T>(_Count, this->WeightsStore + _Off, _Wide); return _Wide; }
+		}
+
+		// Weights from _Off on in storage format.
+		inline auto weightsStored ( const uMAX _Off ) const -> const StoreT<FN_STORE,T>*
+		{
+			if constexpr(FN_STORE == FnStore::FP32) return this->WeightsSrc + _Off;
+			else return this->WeightsStore + _Off;
 		}
 	};
 }
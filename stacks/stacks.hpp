@@ -33,8 +33,22 @@ namespace sx
 #include <fx/Vops.hpp>
 
 #include "./Samples.hpp"
+#include "./SamplesMap.hpp"
+#include "./SamplesStream.hpp"
+#include "./SamplesShards.hpp"
+#include "./SamplesUpdate.hpp"
 
 #include "./Network.hpp"
+#include "./Processes.hpp"
+#include "./Model.hpp"
+#include "./Checkpoint.hpp"
+#include "./Telemetry.hpp"
+#include "./Server.hpp"
+#include "./Async.hpp"
+#include "./Calibrate.hpp"
+#include "./Compress.hpp"
+#include "./Sampler.hpp"
+#include "./Augment.hpp"
 
 #include "./Layer.hpp"
 
@@ -44,7 +58,12 @@ namespace sx
 #include "./layer/Filter.hpp"
 
 #include "./layer/Dense.hpp"
+#include "./layer/DenseQ8.hpp"
+#include "./layer/DenseSparse.hpp"
+#include "./layer/DenseLowRank.hpp"
+#include "./layer/DenseCodebook.hpp"
 
 #include "./layer/Downscale2.hpp"
 #include "./layer/Upscale2.hpp"
 #include "./layer/Conv2.hpp"
+#include "./layer/Conv2Q8.hpp"